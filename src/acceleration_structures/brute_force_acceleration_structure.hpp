@@ -9,12 +9,7 @@ namespace fc
         explicit brute_force_acceleration_structure(std::vector<entity_primitive> surface_primitives)
             : entity_primitives_{std::move(surface_primitives)}
         {
-            bounds3f bounds{};
-            for(auto const& ep : entity_primitives_)
-            {
-                bounds.Union(ep.entity->surface->get_bounds(ep.primitive));
-            }
-            bounds_ = bounds3{bounds};
+            update();
         }
 
         virtual bounds3 get_bounds() const override
@@ -62,6 +57,16 @@ namespace fc
             return false;
         }
 
+        virtual void update() override
+        {
+            bounds3f bounds{};
+            for(auto const& ep : entity_primitives_)
+            {
+                bounds.Union(ep.entity->surface->get_bounds(ep.primitive));
+            }
+            bounds_ = bounds3{bounds};
+        }
+
     private:
         std::vector<entity_primitive> entity_primitives_{};
         bounds3 bounds_{};
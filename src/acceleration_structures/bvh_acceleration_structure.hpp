@@ -1,31 +1,191 @@
 #pragma once
 #include "../core/acceleration_structure.hpp"
+#include "../core/kernels.hpp"
+#include "../core/parallel.hpp"
+#include "../surfaces/sphere_surface.hpp"
+#include "../surfaces/plane_surface.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
 
 namespace fc
 {
-    class bvh_acceleration_structure : public acceleration_structure
+    enum class bvh_node_layout
+    {
+        standard,
+        quantized
+    };
+
+    // sah builds the best trees, hlbvh orders the primitives along a morton curve and builds only the top
+    // levels with sah, lbvh orders them and nothing more, for scenes that are rebuilt all the time
+    enum class bvh_builder
+    {
+        sah,
+        hlbvh,
+        lbvh
+    };
+
+    struct bvh_settings
+    {
+        bvh_builder builder{bvh_builder::sah};
+        bvh_node_layout layout{bvh_node_layout::standard};
+
+        // spatial splits clip triangles at the split plane and reference them from both children,
+        // the budget bounds the duplicated references relative to the primitive count
+        bool spatial_splits{};
+        double spatial_split_budget{0.3};
+
+        // update() refits the tree to primitives that moved and rebuilds it once its sah cost grew by more than
+        // this fraction over the cost after the build, clipped spatial split references count as grown
+        double rebuild_threshold{0.5};
+
+        // counts the work of every ray in get_raycast_statistics(), for finding out why a scene is slow
+        bool statistics{};
+    };
+
+    // Statistics compiles the counting into the traversal, without it none of it exists
+    template <bool Statistics>
+    class basic_bvh_acceleration_structure : public acceleration_structure
     {
         static constexpr int bucket_count{12};
+        static constexpr int spatial_bin_count{32};
+        static constexpr double spatial_split_min_overlap{1e-5};
+        static constexpr int morton_cluster_bits{12};
+        static constexpr std::size_t treelet_bytes{4096};
     public:
-        explicit bvh_acceleration_structure(std::vector<entity_primitive> surface_primitives)
-            : primitives_{std::move(surface_primitives)}
+        explicit basic_bvh_acceleration_structure(std::vector<entity_primitive> surface_primitives, bvh_settings const& settings = {})
+            : primitives_{std::move(surface_primitives)}, settings_{settings}, layout_{settings.layout}
+            , raycast_bounds_{get_kernels().raycast_bounds}, raycast_triangles_{get_kernels().raycast_triangles}
+        {
+            std::uint32_t primitive_count{static_cast<std::uint32_t>(primitives_.size())};
+            bool spatial_splits{settings.builder == bvh_builder::sah && settings.spatial_splits};
+
+            std::vector<primitive_info> primitive_infos(primitive_count);
+            if(spatial_splits) build_triangles_.resize(primitive_count);
+            parallel_for(primitive_count, [&] (std::size_t i)
+            {
+                surface const& surface{*primitives_[i].entity->surface};
+                auto shape{surface.get_shape(primitives_[i].primitive)};
+                bool triangle{shape && std::holds_alternative<surface_triangle>(*shape)};
+                primitive_infos[i] = primitive_info{static_cast<std::uint32_t>(i), surface.get_bounds(primitives_[i].primitive), triangle};
+
+                if(spatial_splits && triangle)
+                {
+                    build_triangles_[i] = std::get<surface_triangle>(*shape);
+                }
+            });
+
+            build_output output{};
+            if(settings.builder == bvh_builder::sah)
+            {
+                // duplicated references are written into the spare slots behind the primitives
+                std::uint32_t capacity{primitive_count};
+                if(spatial_splits)
+                {
+                    bounds3f root_bounds{};
+                    for(primitive_info const& primitive_info : primitive_infos)
+                    {
+                        root_bounds.Union(primitive_info.get_bounds());
+                    }
+                    spatial_split_min_overlap_ = spatial_split_min_overlap * root_bounds.area();
+
+                    capacity += static_cast<std::uint32_t>(primitive_count * settings.spatial_split_budget);
+                    primitive_infos.resize(capacity);
+                }
+
+                build(primitive_infos, 0, primitive_count, capacity, output);
+            }
+            else
+            {
+                build_morton(primitive_infos, settings.builder == bvh_builder::hlbvh, output);
+            }
+            primitives_ = std::move(output.primitives);
+            build_nodes_ = std::move(output.nodes);
+            triangle_packets_ = std::move(output.triangle_packets);
+            leaf_primitives_ = std::move(output.leaf_primitives);
+            spheres_ = std::move(output.spheres);
+            planes_ = std::move(output.planes);
+            build_triangles_ = {};
+
+            sah_cost_ = output.sah_cost / build_nodes_[0].get_bounds().area();
+            built_sah_cost_ = sah_cost_;
+            lay_out_nodes(settings.builder == bvh_builder::sah);
+        }
+
+        // refits the bounds to the current shapes of the primitives, bottom up from the leaves in parallel where the
+        // second child to finish refits its parent; the node layout stays, so the tree degrades as primitives move
+        virtual void update() override
         {
-            std::vector<primitive_info> primitive_infos{};
-            primitive_infos.reserve(primitives_.size());
-            for(std::uint32_t i{}; i < static_cast<std::uint32_t>(primitives_.size()); ++i)
+            if(root_.type != node_type::interior)
+            {
+                double cost{};
+                bounds_ = refit_leaf(root_, &cost);
+                sah_cost_ = cost / bounds_.area();
+                return;
+            }
+
+            std::size_t node_count{layout_ == bvh_node_layout::quantized ? quantized_nodes_.size() : nodes_.size()};
+            std::vector<bounds3f> child_bounds(node_count * 2);
+            std::vector<std::atomic<std::uint32_t>> arrivals(node_count);
+            std::size_t chunk_count{get_parallel_chunk_count(refit_leaves_.size())};
+            std::vector<double> chunk_costs(chunk_count);
+            parallel_chunks(refit_leaves_.size(), chunk_count, [&] (std::size_t chunk, std::size_t begin, std::size_t end)
+            {
+                double cost{};
+                for(std::size_t i{begin}; i < end; ++i)
+                {
+                    std::uint32_t slot{refit_leaves_[i]};
+                    child_bounds[slot] = refit_leaf(get_child(slot), &cost);
+
+                    std::uint32_t index{slot >> 1};
+                    while(arrivals[index].fetch_add(1, std::memory_order_acq_rel) == 1)
+                    {
+                        bounds3f bounds{child_bounds[index * 2]};
+                        bounds.Union(child_bounds[index * 2 + 1]);
+                        cost += 0.125 * bounds.area();
+
+                        if(index == 0)
+                        {
+                            bounds_ = bounds;
+                            break;
+                        }
+                        child_bounds[refit_parents_[index]] = bounds;
+                        index = refit_parents_[index] >> 1;
+                    }
+                }
+                chunk_costs[chunk] = cost;
+            });
+            store_child_bounds(child_bounds);
+
+            double cost{};
+            for(double chunk_cost : chunk_costs)
+            {
+                cost += chunk_cost;
+            }
+            sah_cost_ = cost / bounds_.area();
+
+            if(sah_cost_ > built_sah_cost_ * (1.0 + settings_.rebuild_threshold))
             {
-                primitive_infos.emplace_back(i, primitives_[i].entity->surface->get_bounds(primitives_[i].primitive));
+                rebuild();
             }
+        }
+
+        // expected cost of a ray through the tree in units of one primitive test, as estimated by the builder
+        double get_sah_cost() const
+        {
+            return sah_cost_;
+        }
 
-            std::vector<entity_primitive> ordered_primitives{};
-            ordered_primitives.reserve(primitives_.size());
-            build(primitive_infos, 0, static_cast<std::uint32_t>(primitives_.size()), ordered_primitives);
-            std::swap(primitives_, ordered_primitives);
+        // primitives referenced by the leaves, above the primitive count when spatial splits duplicated some
+        std::size_t get_reference_count() const
+        {
+            return primitives_.size();
         }
 
         virtual bounds3 get_bounds() const override
         {
-            return bounds3{nodes_[0].get_bounds()};
+            return bounds3{bounds_};
         }
 
         virtual std::optional<acceleration_structure_raycast_surface_point_result> raycast_surface_point(ray3 const& ray, double t_max, allocator_wrapper& allocator) const override
@@ -33,55 +193,83 @@ namespace fc
             entity_primitive entity_primitive{};
             surface_point* p{};
 
-            vector3 inv_dir{1.0 / ray.direction};
-            int dir_is_neg[3]{inv_dir.x < 0, inv_dir.y < 0, inv_dir.z < 0};
-
-            std::uint32_t stack[64];
-            stack[0] = 0;
-            int stack_size{1};
+            // hits found by the bvh itself only get their surface point once the closest one is known
+            bool deferred_hit{};
+            vector3 b{};
 
-            while(stack_size > 0)
+            triangle_ray triangle_ray{ray};
+            auto visit_leaf{[&] (node_ref const& leaf)
             {
-                std::uint32_t node_index{stack[--stack_size]};
-                node const& node{nodes_[node_index]};
-
-                bounds3 bounds{node.get_bounds()};
-                if(bounds.Raycast(ray, t_max, inv_dir, dir_is_neg))
+                if(leaf.type == node_type::triangle_leaf)
                 {
-                    if(!node.is_interior())
+                    for(std::uint32_t i{leaf.index}; i < leaf.index + leaf.count; ++i)
                     {
-                        for(std::uint32_t i{node.get_first_primitive()}; i < node.get_first_primitive() + node.get_primitive_count(); ++i)
-                        {
-                            auto raycast_result{primitives_[i].entity->surface->raycast_surface_point(primitives_[i].primitive, ray, t_max, allocator)};
+                        if constexpr(Statistics) get_raycast_statistics().primitive_test_count += get_lane_count(triangle_packets_[i]);
 
-                            if(raycast_result)
-                            {
-                                t_max = raycast_result->t;
-                                p = raycast_result->p;
-                                entity_primitive = primitives_[i];
-                            }
+                        triangle_packet_hit hit{};
+                        if(raycast_triangles_(triangle_packets_[i].packet, triangle_ray, t_max, &hit))
+                        {
+                            t_max = hit.t;
+                            deferred_hit = true;
+                            b = hit.b;
+                            entity_primitive = primitives_[triangle_packets_[i].primitives[hit.lane]];
                         }
                     }
-                    else
+                }
+                else
+                {
+                    for(std::uint32_t i{leaf.index}; i < leaf.index + leaf.count; ++i)
                     {
-                        if(dir_is_neg[node.get_split_axis()])
-                        {
-                            stack[stack_size++] = node_index + 1;
-                            stack[stack_size++] = node.get_second_child();
-                        }
-                        else
+                        if constexpr(Statistics) ++get_raycast_statistics().primitive_test_count;
+
+                        leaf_primitive const& primitive{leaf_primitives_[i]};
+                        switch(primitive.type)
                         {
-                            stack[stack_size++] = node.get_second_child();
-                            stack[stack_size++] = node_index + 1;
+                        case leaf_primitive_type::sphere:
+                            if(auto t{sphere_surface::raycast_sphere(spheres_[primitive.shape], ray, t_max)})
+                            {
+                                t_max = *t;
+                                deferred_hit = true;
+                                entity_primitive = primitives_[primitive.primitive];
+                            }
+                            break;
+                        case leaf_primitive_type::plane:
+                            if(auto t{plane_surface::raycast_plane(planes_[primitive.shape], ray, t_max)})
+                            {
+                                t_max = *t;
+                                deferred_hit = true;
+                                entity_primitive = primitives_[primitive.primitive];
+                            }
+                            break;
+                        case leaf_primitive_type::surface:
+                            {
+                                auto const& candidate{primitives_[primitive.primitive]};
+                                if(auto raycast_result{candidate.entity->surface->raycast_surface_point(candidate.primitive, ray, t_max, allocator)})
+                                {
+                                    t_max = raycast_result->t;
+                                    p = raycast_result->p;
+                                    deferred_hit = false;
+                                    entity_primitive = candidate;
+                                }
+                            }
+                            break;
                         }
                     }
                 }
-            }
+                return false;
+            }};
+            traverse(ray, t_max, visit_leaf);
 
+            if(deferred_hit)
+            {
+                p = entity_primitive.entity->surface->create_surface_point(entity_primitive.primitive, ray, t_max, b, allocator);
+            }
 
             std::optional<acceleration_structure_raycast_surface_point_result> result{};
             if(p != nullptr)
             {
+                if constexpr(Statistics) ++get_raycast_statistics().hit_count;
+
                 result.emplace();
                 result->entity_primitive = entity_primitive;
                 result->p = p;
@@ -92,69 +280,324 @@ namespace fc
 
         virtual bool raycast(ray3 const& ray, double t_max) const override
         {
-            vector3 inv_dir{1.0 / ray.direction};
-            int dir_is_neg[3]{inv_dir.x < 0, inv_dir.y < 0, inv_dir.z < 0};
+            bool hit_any{};
 
-            std::uint32_t stack[64];
-            stack[0] = 0;
-            int stack_size{1};
-
-            while(stack_size > 0)
+            triangle_ray triangle_ray{ray};
+            auto visit_leaf{[&] (node_ref const& leaf)
             {
-                std::uint32_t node_index{stack[--stack_size]};
-                node const& node{nodes_[node_index]};
+                if(leaf.type == node_type::triangle_leaf)
+                {
+                    for(std::uint32_t i{leaf.index}; i < leaf.index + leaf.count; ++i)
+                    {
+                        if constexpr(Statistics) get_raycast_statistics().primitive_test_count += get_lane_count(triangle_packets_[i]);
 
-                bounds3 bounds{node.get_bounds()};
-                if(bounds.Raycast(ray, t_max, inv_dir, dir_is_neg))
+                        triangle_packet_hit hit{};
+                        if(raycast_triangles_(triangle_packets_[i].packet, triangle_ray, t_max, &hit))
+                        {
+                            return hit_any = true;
+                        }
+                    }
+                }
+                else
                 {
-                    if(!node.is_interior())
+                    for(std::uint32_t i{leaf.index}; i < leaf.index + leaf.count; ++i)
                     {
-                        for(std::uint32_t i{node.get_first_primitive()}; i < node.get_first_primitive() + node.get_primitive_count(); ++i)
+                        if constexpr(Statistics) ++get_raycast_statistics().primitive_test_count;
+
+                        leaf_primitive const& primitive{leaf_primitives_[i]};
+                        switch(primitive.type)
                         {
-                            auto raycast_result{primitives_[i].entity->surface->raycast(primitives_[i].primitive, ray, t_max)};
-                            if(raycast_result)
+                        case leaf_primitive_type::sphere:
+                            if(sphere_surface::raycast_sphere(spheres_[primitive.shape], ray, t_max)) return hit_any = true;
+                            break;
+                        case leaf_primitive_type::plane:
+                            if(plane_surface::raycast_plane(planes_[primitive.shape], ray, t_max)) return hit_any = true;
+                            break;
+                        case leaf_primitive_type::surface:
                             {
-                                return true;
+                                auto const& candidate{primitives_[primitive.primitive]};
+                                if(candidate.entity->surface->raycast(candidate.primitive, ray, t_max)) return hit_any = true;
                             }
+                            break;
                         }
                     }
+                }
+                return false;
+            }};
+            traverse_any(ray, t_max, visit_leaf);
+
+            if constexpr(Statistics) get_raycast_statistics().hit_count += hit_any ? 1 : 0;
+            return hit_any;
+        }
+
+    private:
+        enum class node_type : std::uint8_t
+        {
+            interior,
+            leaf,
+            triangle_leaf
+        };
+
+        // an interior node, a leaf of primitives or a leaf of triangle packets
+        struct node_ref
+        {
+            std::uint32_t index{};
+            std::uint16_t count{};
+            node_type type{};
+        };
+
+        // both children of an interior node, tested together from one cache line
+        struct alignas(64) node
+        {
+            bounds3f child_bounds[2]{};
+            node_ref children[2]{};
+
+            bounds3f get_child_bounds(int i, bounds3f const&) const
+            {
+                return child_bounds[i];
+            }
+        };
+
+        // the child bounds as 8 bit multiples of a power of two step from the node bounds, two nodes per cache line;
+        // the product is exact, so decoding rounds the same way wherever it happens
+        struct alignas(32) quantized_node
+        {
+            std::uint8_t child_bounds[2][2][3]{};
+            std::int8_t exponents[3]{};
+            node_ref children[2]{};
+
+            static float get_step(int exponent)
+            {
+                return std::bit_cast<float>(static_cast<std::uint32_t>(exponent + 127) << 23);
+            }
+
+            bounds3f get_child_bounds(int i, bounds3f const& bounds) const
+            {
+                vector3f low{};
+                vector3f high{};
+                for(int axis{}; axis < 3; ++axis)
+                {
+                    float step{get_step(exponents[axis])};
+                    low[axis] = bounds.Min()[axis] + static_cast<float>(child_bounds[i][0][axis]) * step;
+                    high[axis] = bounds.Min()[axis] + static_cast<float>(child_bounds[i][1][axis]) * step;
+                }
+                return {low, high};
+            }
+        };
+
+        // visits the leaves the ray reaches, nearer children first, until visit_leaf returns true; visit_leaf may lower t_max
+        template <typename Visitor>
+        void traverse(ray3 const& ray, double const& t_max, Visitor& visit_leaf) const
+        {
+            if(layout_ == bvh_node_layout::quantized)
+            {
+                traverse(quantized_nodes_, ray, t_max, visit_leaf);
+            }
+            else
+            {
+                traverse(nodes_, ray, t_max, visit_leaf);
+            }
+        }
+
+        template <typename Node, typename Visitor>
+        void traverse(std::vector<Node> const& nodes, ray3 const& ray, double const& t_max, Visitor& visit_leaf) const
+        {
+            // quantized children are decoded against the bounds of their parent, which therefore travel on the stack
+            static constexpr bool quantized{std::is_same_v<Node, quantized_node>};
+            struct stack_entry
+            {
+                node_ref const* ref;
+                double t_near;
+                float bounds[quantized ? 6 : 1];
+            };
+
+            if constexpr(Statistics) ++get_raycast_statistics().ray_count;
+
+            bounds_ray box_ray{ray};
+            stack_entry stack[64];
+            int stack_size{};
+
+            double t_near{};
+            if(raycast_bounds_(bounds_, box_ray, t_max, &t_near))
+            {
+                stack_entry& entry{stack[stack_size++]};
+                entry.ref = &root_;
+                entry.t_near = t_near;
+                if constexpr(quantized) store_bounds(bounds_, entry.bounds);
+            }
+
+            while(stack_size > 0)
+            {
+                stack_entry const& entry{stack[--stack_size]};
+
+                // a closer hit may have been found since the node was pushed
+                if(!(entry.t_near < t_max)) continue;
+
+                if(entry.ref->type != node_type::interior)
+                {
+                    if constexpr(Statistics) ++get_raycast_statistics().leaf_count;
+
+                    if(visit_leaf(*entry.ref)) return;
+                    continue;
+                }
+
+                if constexpr(Statistics) ++get_raycast_statistics().node_count;
+
+                Node const& node{nodes[entry.ref->index]};
+                bounds3f decoded_bounds[quantized ? 2 : 1];
+                bounds3f const* child_bounds[2];
+                double child_t_near[2];
+                bool hits[2];
+                for(int i{}; i < 2; ++i)
+                {
+                    if constexpr(quantized)
+                    {
+                        decoded_bounds[i] = node.get_child_bounds(i, load_bounds(entry.bounds));
+                        child_bounds[i] = &decoded_bounds[i];
+                    }
                     else
                     {
-                        if(dir_is_neg[node.get_split_axis()])
-                        {
-                            stack[stack_size++] = node_index + 1;
-                            stack[stack_size++] = node.get_second_child();
-                        }
-                        else
-                        {
-                            stack[stack_size++] = node.get_second_child();
-                            stack[stack_size++] = node_index + 1;
-                        }
+                        child_bounds[i] = &node.child_bounds[i];
                     }
+                    hits[i] = raycast_bounds_(*child_bounds[i], box_ray, t_max, &child_t_near[i]);
+                }
+
+                // the nearer child ends up on top
+                int first{child_t_near[0] <= child_t_near[1] ? 1 : 0};
+                for(int i : {first, 1 - first})
+                {
+                    if(!hits[i]) continue;
+
+                    stack_entry& child{stack[stack_size++]};
+                    child.ref = &node.children[i];
+                    child.t_near = child_t_near[i];
+                    if constexpr(quantized) store_bounds(*child_bounds[i], child.bounds);
                 }
             }
+        }
+
+        // visits the leaves the ray reaches until visit_leaf returns true, for rays that only ask whether anything is
+        // hit; no order can cull against a t_max that never drops, so children are pushed untested and their boxes
+        // tested once popped, and a hit below the first child ends the ray before the second one costs anything
+        template <typename Visitor>
+        void traverse_any(ray3 const& ray, double t_max, Visitor& visit_leaf) const
+        {
+            if(layout_ == bvh_node_layout::quantized)
+            {
+                traverse_any(quantized_nodes_, ray, t_max, visit_leaf);
+            }
+            else
+            {
+                traverse_any(nodes_, ray, t_max, visit_leaf);
+            }
+        }
+
+        template <typename Node, typename Visitor>
+        void traverse_any(std::vector<Node> const& nodes, ray3 const& ray, double t_max, Visitor& visit_leaf) const
+        {
+            static constexpr bool quantized{std::is_same_v<Node, quantized_node>};
+            struct stack_entry
+            {
+                node_ref const* ref;
+                bounds3f const* bounds;
+                float decoded_bounds[quantized ? 6 : 1];
+            };
+
+            if constexpr(Statistics) ++get_raycast_statistics().ray_count;
+
+            bounds_ray box_ray{ray};
+            stack_entry stack[64];
+            int stack_size{1};
+            stack[0].ref = &root_;
+            stack[0].bounds = &bounds_;
+            if constexpr(quantized) store_bounds(bounds_, stack[0].decoded_bounds);
+
+            while(stack_size > 0)
+            {
+                stack_entry const& entry{stack[--stack_size]};
+                node_ref const& ref{*entry.ref};
+                bounds3f decoded_bounds{};
+                bounds3f const* bounds{entry.bounds};
+                if constexpr(quantized)
+                {
+                    decoded_bounds = load_bounds(entry.decoded_bounds);
+                    bounds = &decoded_bounds;
+                }
+
+                double t_near{};
+                if(!raycast_bounds_(*bounds, box_ray, t_max, &t_near)) continue;
 
-            return false;
+                if(ref.type != node_type::interior)
+                {
+                    if constexpr(Statistics) ++get_raycast_statistics().leaf_count;
+
+                    if(visit_leaf(ref)) return;
+                    continue;
+                }
+
+                if constexpr(Statistics) ++get_raycast_statistics().node_count;
+
+                // the first child ends up on top
+                Node const& node{nodes[ref.index]};
+                for(int i : {1, 0})
+                {
+                    stack_entry& child{stack[stack_size++]};
+                    child.ref = &node.children[i];
+                    if constexpr(quantized)
+                    {
+                        store_bounds(node.get_child_bounds(i, *bounds), child.decoded_bounds);
+                    }
+                    else
+                    {
+                        child.bounds = &node.child_bounds[i];
+                    }
+                }
+            }
         }
 
-    private:
-        class node
+        static void store_bounds(bounds3f const& bounds, float* values)
+        {
+            for(int axis{}; axis < 3; ++axis)
+            {
+                values[axis] = bounds.Min()[axis];
+                values[axis + 3] = bounds.Max()[axis];
+            }
+        }
+
+        static bounds3f load_bounds(float const* values)
+        {
+            return {vector3f{values[0], values[1], values[2]}, vector3f{values[3], values[4], values[5]}};
+        }
+
+        class build_node
         {
-            node(bounds3f const& bounds, std::uint32_t a, std::uint16_t b, std::uint16_t interior)
-                : bounds_{bounds}, first_primitive_or_second_child_{a}, primitive_count_or_split_axis_{b}, interior_{interior}
+            enum class type : std::uint16_t
+            {
+                leaf,
+                interior,
+                triangle_leaf
+            };
+
+            build_node(bounds3f const& bounds, std::uint32_t a, std::uint16_t b, type type)
+                : bounds_{bounds}, first_primitive_or_second_child_{a}, primitive_count_or_split_axis_{b}, type_{type}
             { }
 
         public:
-            node() = default;
+            build_node() = default;
 
-            static node create_leaf(bounds3f const& bounds, std::uint32_t first_primitive, std::uint16_t primitive_count)
+            static build_node create_leaf(bounds3f const& bounds, std::uint32_t first_primitive, std::uint16_t primitive_count)
             {
-                return {bounds, first_primitive, primitive_count, 0};
+                return {bounds, first_primitive, primitive_count, type::leaf};
             }
 
-            static node create_interior(bounds3f const& bounds, std::uint32_t second_child, std::uint16_t split_axis)
+            static build_node create_triangle_leaf(bounds3f const& bounds, std::uint32_t first_packet, std::uint16_t packet_count)
             {
-                return {bounds, second_child, split_axis, 1};
+                return {bounds, first_packet, packet_count, type::triangle_leaf};
+            }
+
+            static build_node create_interior(bounds3f const& bounds, std::uint32_t second_child, std::uint16_t split_axis)
+            {
+                return {bounds, second_child, split_axis, type::interior};
             }
 
             bounds3f const& get_bounds() const
@@ -164,7 +607,12 @@ namespace fc
 
             bool is_interior() const
             {
-                return interior_;
+                return type_ == type::interior;
+            }
+
+            bool is_triangle_leaf() const
+            {
+                return type_ == type::triangle_leaf;
             }
 
             std::uint32_t get_first_primitive() const
@@ -172,6 +620,11 @@ namespace fc
                 return first_primitive_or_second_child_;
             }
 
+            std::uint32_t get_first_packet() const
+            {
+                return first_primitive_or_second_child_;
+            }
+
             std::uint32_t get_second_child() const
             {
                 return first_primitive_or_second_child_;
@@ -182,26 +635,102 @@ namespace fc
                 return primitive_count_or_split_axis_;
             }
 
+            std::uint16_t get_packet_count() const
+            {
+                return primitive_count_or_split_axis_;
+            }
+
             int get_split_axis() const
             {
                 return primitive_count_or_split_axis_;
             }
 
+            void relocate(std::uint32_t node_offset, std::uint32_t primitive_offset, std::uint32_t packet_offset)
+            {
+                first_primitive_or_second_child_ += type_ == type::interior ? node_offset : type_ == type::triangle_leaf ? packet_offset : primitive_offset;
+            }
+
         private:
             bounds3f bounds_{};
             std::uint32_t first_primitive_or_second_child_{};
             std::uint16_t primitive_count_or_split_axis_{};
-            std::uint16_t interior_{};
+            type type_{};
+        };
+
+        // lanes past the last triangle of a leaf stay degenerate and refer to no primitive
+        static constexpr std::uint32_t empty_lane{~0u};
+
+        // triangles of a leaf with the indices into primitives_ of their lanes
+        struct leaf_triangle_packet
+        {
+            triangle_packet packet{};
+            std::uint32_t primitives[triangle_packet_width]{};
+        };
+
+        static std::uint64_t get_lane_count(leaf_triangle_packet const& packet)
+        {
+            return static_cast<std::uint64_t>(std::count_if(std::begin(packet.primitives), std::end(packet.primitives),
+                [] (std::uint32_t primitive) { return primitive != empty_lane; }
+            ));
+        }
+
+        // shapes the bvh tests itself refer to their data in spheres_ or planes_, anything else goes through its surface
+        enum class leaf_primitive_type : std::uint32_t
+        {
+            sphere,
+            plane,
+            surface
+        };
+
+        struct leaf_primitive
+        {
+            leaf_primitive_type type{};
+            std::uint32_t primitive{};
+            std::uint32_t shape{};
+        };
+
+        // everything a build emits, nodes refer to the other arrays by index so separately built subtrees can be joined
+        struct build_output
+        {
+            std::vector<build_node> nodes{};
+            std::vector<leaf_triangle_packet> triangle_packets{};
+            std::vector<leaf_primitive> leaf_primitives{};
+            std::vector<surface_sphere> spheres{};
+            std::vector<surface_plane> planes{};
+            std::vector<entity_primitive> primitives{};
+            double sah_cost{};
         };
 
         std::vector<entity_primitive> primitives_{};
+        bvh_settings settings_{};
+        bvh_node_layout layout_{};
+        bounds3f bounds_{};
+        node_ref root_{};
         std::vector<node> nodes_{};
+        std::vector<quantized_node> quantized_nodes_{};
+        std::vector<build_node> build_nodes_{};
+        std::vector<leaf_triangle_packet> triangle_packets_{};
+        std::vector<leaf_primitive> leaf_primitives_{};
+        std::vector<surface_sphere> spheres_{};
+        std::vector<surface_plane> planes_{};
+        std::vector<surface_triangle> build_triangles_{};
+        double spatial_split_min_overlap_{};
+        double sah_cost_{};
+        double built_sah_cost_{};
+
+        // the slot, node index times two plus child, that holds each interior node and each leaf
+        std::vector<std::uint32_t> refit_parents_{};
+        std::vector<std::uint32_t> refit_leaves_{};
+        bool (*raycast_bounds_)(bounds3f const& bounds, bounds_ray const& ray, double t_max, double* t_near){};
+        bool (*raycast_triangles_)(triangle_packet const& packet, triangle_ray const& ray, double t_max, triangle_packet_hit* hit){};
 
         class primitive_info
         {
         public:
-            primitive_info(std::uint32_t primitive_index, bounds3f const& bounds)
-                : primitive_index_{primitive_index}, bounds_{bounds}, centroid_{bounds_.centroid()}
+            primitive_info() = default;
+
+            primitive_info(std::uint32_t primitive_index, bounds3f const& bounds, bool triangle)
+                : primitive_index_{primitive_index}, bounds_{bounds}, centroid_{bounds_.centroid()}, triangle_{triangle}
             { }
 
             bounds3f const& get_bounds() const
@@ -219,13 +748,19 @@ namespace fc
                 return primitive_index_;
             }
 
+            bool is_triangle() const
+            {
+                return triangle_;
+            }
+
         private:
             std::uint32_t primitive_index_{};
             bounds3f bounds_{};
             vector3f centroid_{};
+            bool triangle_{};
         };
 
-        std::uint32_t build(std::vector<primitive_info>& primitive_infos, std::uint32_t begin, std::uint32_t end, std::vector<entity_primitive>& ordered_primitives)
+        std::uint32_t build(std::vector<primitive_info>& primitive_infos, std::uint32_t begin, std::uint32_t end, std::uint32_t capacity_end, build_output& output)
         {
             bounds3f node_bounds{primitive_infos[begin].get_bounds()};
             for(std::uint32_t i{begin + 1}; i < end; ++i)
@@ -233,45 +768,149 @@ namespace fc
                 node_bounds.Union(primitive_infos[i].get_bounds());
             }
 
-            std::uint32_t primitive_count{end - begin};
-            if(primitive_count == 1)
+            if(is_leaf_sized(primitive_infos, begin, end))
             {
-                return build_leaf(primitive_infos, begin, end, node_bounds, ordered_primitives);
+                return build_leaf(primitive_infos, begin, end, node_bounds, output);
             }
             else
             {
-                return build_interior(primitive_infos, begin, end, node_bounds, ordered_primitives);
+                return build_interior(primitive_infos, begin, end, capacity_end, node_bounds, output);
             }
         }
 
-        std::uint32_t build_leaf(std::vector<primitive_info>& primitive_infos, std::uint32_t begin, std::uint32_t end, bounds3f const& bounds, std::vector<entity_primitive>& ordered_primitives)
+        // a packet tests a handful of triangles at the cost of one, splitting them further does not pay off
+        static bool is_leaf_sized(std::vector<primitive_info> const& primitive_infos, std::uint32_t begin, std::uint32_t end)
         {
-            std::uint32_t first_primitive{static_cast<std::uint32_t>(ordered_primitives.size())};
             std::uint32_t primitive_count{end - begin};
+            return primitive_count == 1 || (primitive_count <= triangle_packet_width && std::all_of(primitive_infos.begin() + begin, primitive_infos.begin() + end,
+                [] (primitive_info const& a) { return a.is_triangle(); }
+            ));
+        }
 
-            for(std::uint32_t i{begin}; i < end; ++i)
+        std::uint32_t build_leaf(std::vector<primitive_info>& primitive_infos, std::uint32_t begin, std::uint32_t end, bounds3f const& bounds, build_output& output)
+        {
+            auto it{std::partition(primitive_infos.begin() + begin, primitive_infos.begin() + end,
+                [] (primitive_info const& a) { return !a.is_triangle(); }
+            )};
+            std::uint32_t middle{static_cast<std::uint32_t>(std::distance(primitive_infos.begin(), it))};
+
+            if(middle == begin)
             {
-                ordered_primitives.push_back(std::move(primitives_[primitive_infos[i].get_primitive_index()]));
+                return build_triangle_leaf(primitive_infos, begin, end, bounds, output);
+            }
+            else if(middle == end)
+            {
+                return build_primitive_leaf(primitive_infos, begin, end, bounds, output);
             }
 
-            std::uint32_t index{static_cast<uint32_t>(nodes_.size())};
-            nodes_.push_back(node::create_leaf(bounds, first_primitive, primitive_count));
-            return index;
-        }
-
-        std::uint32_t build_interior(std::vector<primitive_info>& primitive_infos, std::uint32_t begin, std::uint32_t end, bounds3f const& bounds, std::vector<entity_primitive>& ordered_primitives)
-        {
-            bounds3f centroid_bounds{primitive_infos[begin].get_centroid()};
-            for(std::uint32_t i{begin + 1}; i < end; ++i)
+            // leaves hold either triangle packets or other primitives, a mixed one becomes an interior node over both
+            bounds3f primitive_bounds{primitive_infos[begin].get_bounds()};
+            for(std::uint32_t i{begin + 1}; i < middle; ++i)
             {
-                centroid_bounds.Union(primitive_infos[i].get_centroid());
+                primitive_bounds.Union(primitive_infos[i].get_bounds());
             }
 
-            int split_axis{centroid_bounds.maximum_extent()};
-            float axisLength{centroid_bounds.diagonal()[split_axis]};
-            if(axisLength == 0.0)
+            bounds3f triangle_bounds{primitive_infos[middle].get_bounds()};
+            for(std::uint32_t i{middle + 1}; i < end; ++i)
             {
-                return build_leaf(primitive_infos, begin, end, bounds, ordered_primitives);
+                triangle_bounds.Union(primitive_infos[i].get_bounds());
+            }
+
+            std::uint32_t index{static_cast<uint32_t>(output.nodes.size())};
+            output.nodes.emplace_back();
+            output.sah_cost += 0.125 * bounds.area();
+
+            build_primitive_leaf(primitive_infos, begin, middle, primitive_bounds, output);
+            std::uint32_t right_child_index{build_triangle_leaf(primitive_infos, middle, end, triangle_bounds, output)};
+            output.nodes[index] = build_node::create_interior(bounds, right_child_index, 0);
+            return index;
+        }
+
+        std::uint32_t build_triangle_leaf(std::vector<primitive_info>& primitive_infos, std::uint32_t begin, std::uint32_t end, bounds3f const& bounds, build_output& output)
+        {
+            std::uint32_t first_packet{static_cast<std::uint32_t>(output.triangle_packets.size())};
+
+            for(std::uint32_t i{begin}; i < end; ++i)
+            {
+                std::uint32_t lane{(i - begin) % triangle_packet_width};
+                if(lane == 0)
+                {
+                    leaf_triangle_packet& packet{output.triangle_packets.emplace_back()};
+                    std::fill(std::begin(packet.primitives), std::end(packet.primitives), empty_lane);
+                }
+
+                entity_primitive const& primitive{primitives_[primitive_infos[i].get_primitive_index()]};
+                surface_triangle triangle{std::get<surface_triangle>(*primitive.entity->surface->get_shape(primitive.primitive))};
+                vector3f const* vertices[3]{&triangle.p0, &triangle.p1, &triangle.p2};
+
+                leaf_triangle_packet& packet{output.triangle_packets.back()};
+                for(int v{}; v < 3; ++v)
+                {
+                    for(int axis{}; axis < 3; ++axis)
+                    {
+                        packet.packet.vertices[v][axis][lane] = (*vertices[v])[axis];
+                    }
+                }
+                packet.primitives[lane] = static_cast<std::uint32_t>(output.primitives.size());
+                output.primitives.push_back(primitives_[primitive_infos[i].get_primitive_index()]);
+            }
+
+            std::uint32_t packet_count{static_cast<std::uint32_t>(output.triangle_packets.size()) - first_packet};
+            output.sah_cost += bounds.area() * (end - begin);
+
+            std::uint32_t index{static_cast<uint32_t>(output.nodes.size())};
+            output.nodes.push_back(build_node::create_triangle_leaf(bounds, first_packet, static_cast<std::uint16_t>(packet_count)));
+            return index;
+        }
+
+        std::uint32_t build_primitive_leaf(std::vector<primitive_info>& primitive_infos, std::uint32_t begin, std::uint32_t end, bounds3f const& bounds, build_output& output)
+        {
+            std::uint32_t first_primitive{static_cast<std::uint32_t>(output.leaf_primitives.size())};
+            std::uint32_t primitive_count{end - begin};
+
+            for(std::uint32_t i{begin}; i < end; ++i)
+            {
+                entity_primitive const& primitive{primitives_[primitive_infos[i].get_primitive_index()]};
+                auto shape{primitive.entity->surface->get_shape(primitive.primitive)};
+
+                leaf_primitive& leaf_primitive{output.leaf_primitives.emplace_back()};
+                leaf_primitive.primitive = static_cast<std::uint32_t>(output.primitives.size());
+                leaf_primitive.type = leaf_primitive_type::surface;
+                if(shape && std::holds_alternative<surface_sphere>(*shape))
+                {
+                    leaf_primitive.type = leaf_primitive_type::sphere;
+                    leaf_primitive.shape = static_cast<std::uint32_t>(output.spheres.size());
+                    output.spheres.push_back(std::get<surface_sphere>(*shape));
+                }
+                else if(shape && std::holds_alternative<surface_plane>(*shape))
+                {
+                    leaf_primitive.type = leaf_primitive_type::plane;
+                    leaf_primitive.shape = static_cast<std::uint32_t>(output.planes.size());
+                    output.planes.push_back(std::get<surface_plane>(*shape));
+                }
+
+                output.primitives.push_back(primitives_[primitive_infos[i].get_primitive_index()]);
+            }
+            output.sah_cost += bounds.area() * primitive_count;
+
+            std::uint32_t index{static_cast<uint32_t>(output.nodes.size())};
+            output.nodes.push_back(build_node::create_leaf(bounds, first_primitive, primitive_count));
+            return index;
+        }
+
+        std::uint32_t build_interior(std::vector<primitive_info>& primitive_infos, std::uint32_t begin, std::uint32_t end, std::uint32_t capacity_end, bounds3f const& bounds, build_output& output)
+        {
+            bounds3f centroid_bounds{primitive_infos[begin].get_centroid()};
+            for(std::uint32_t i{begin + 1}; i < end; ++i)
+            {
+                centroid_bounds.Union(primitive_infos[i].get_centroid());
+            }
+
+            int split_axis{centroid_bounds.maximum_extent()};
+            float axisLength{centroid_bounds.diagonal()[split_axis]};
+            if(axisLength == 0.0)
+            {
+                return build_leaf(primitive_infos, begin, end, bounds, output);
             }
 
             std::uint32_t primitive_count{end - begin};
@@ -286,7 +925,6 @@ namespace fc
             }
             else
             {
-                constexpr int bucket_count{12};
                 struct bucket_info
                 {
                     std::uint32_t primitive_count{};
@@ -336,8 +974,30 @@ namespace fc
                     }
                 }
 
+                // spatial splits only pay off where the children of the object split overlap
+                spatial_split spatial{};
+                if(capacity_end > end)
+                {
+                    bounds3f overlap{};
+                    bounds3f other{};
+                    for(int i{}; i < bucket_count; ++i)
+                    {
+                        (i <= min_cost_index ? overlap : other).Union(buckets[i].bounds);
+                    }
+                    overlap.Intersect(other);
+
+                    if(!overlap.is_empty() && overlap.area() > spatial_split_min_overlap_)
+                    {
+                        spatial = find_spatial_split(primitive_infos, begin, end, capacity_end, bounds);
+                    }
+                }
+
                 double leaf_cost{static_cast<double>(primitive_count)};
-                if(min_cost < leaf_cost)
+                if(spatial.cost < min_cost && spatial.cost < leaf_cost)
+                {
+                    return build_spatial_split(primitive_infos, begin, end, capacity_end, bounds, spatial, output);
+                }
+                else if(min_cost < leaf_cost)
                 {
                     float partition_point{centroid_bounds.Min()[split_axis] + axisLength / bucket_count * (min_cost_index + 1)};
                     auto it{std::partition(primitive_infos.begin() + begin, primitive_infos.begin() + end,
@@ -351,26 +1011,978 @@ namespace fc
                 }
                 else
                 {
-                    return build_leaf(primitive_infos, begin, end, bounds, ordered_primitives);
+                    return build_leaf(primitive_infos, begin, end, bounds, output);
+                }
+            }
+
+            // spare slots are shared by the children in proportion to their references
+            std::uint32_t spare{capacity_end - end};
+            std::uint32_t left_spare{static_cast<std::uint32_t>(static_cast<std::uint64_t>(spare) * (middle - begin) / primitive_count)};
+            if(left_spare > 0)
+            {
+                std::move_backward(primitive_infos.begin() + middle, primitive_infos.begin() + end, primitive_infos.begin() + end + left_spare);
+            }
+
+            std::uint32_t index{static_cast<uint32_t>(output.nodes.size())};
+            output.nodes.emplace_back();
+            output.sah_cost += 0.125 * bounds.area();
+
+            build(primitive_infos, begin, middle, middle + left_spare, output);
+            std::uint32_t right_child_index{build(primitive_infos, middle + left_spare, end + left_spare, capacity_end, output)};
+            output.nodes[index] = build_node::create_interior(bounds, right_child_index, static_cast<uint16_t>(split_axis));
+            return index;
+        }
+
+        struct spatial_split
+        {
+            int axis{};
+            int plane{};
+            double cost{std::numeric_limits<double>::infinity()};
+        };
+
+        // plane i of spatial_bin_count + 1 evenly spaced planes through the node, the outer two on its faces
+        static float get_spatial_plane(bounds3f const& bounds, int axis, int i)
+        {
+            if(i == spatial_bin_count) return bounds.Max()[axis];
+            return bounds.Min()[axis] + (bounds.Max()[axis] - bounds.Min()[axis]) * static_cast<float>(i) / spatial_bin_count;
+        }
+
+        static int get_spatial_bin(bounds3f const& bounds, int axis, float value)
+        {
+            float offset{(value - bounds.Min()[axis]) / (bounds.Max()[axis] - bounds.Min()[axis])};
+            return std::clamp(static_cast<int>(offset * spatial_bin_count), 0, spatial_bin_count - 1);
+        }
+
+        // bins spanned by a reference, only triangles are clipped and others stay whole in the bin of their centroid
+        static std::pair<int, int> get_spatial_bins(bounds3f const& bounds, int axis, primitive_info const& reference)
+        {
+            if(!reference.is_triangle())
+            {
+                int bin{get_spatial_bin(bounds, axis, reference.get_centroid()[axis])};
+                return {bin, bin};
+            }
+            return {get_spatial_bin(bounds, axis, reference.get_bounds().Min()[axis]), get_spatial_bin(bounds, axis, reference.get_bounds().Max()[axis])};
+        }
+
+        // bounds of the parts of a triangle reference on either side of a plane
+        std::pair<bounds3f, bounds3f> split_reference(primitive_info const& reference, int axis, float plane) const
+        {
+            bounds3f const& bounds{reference.get_bounds()};
+            if(plane < bounds.Min()[axis]) return {bounds3f{}, bounds};
+            if(plane > bounds.Max()[axis]) return {bounds, bounds3f{}};
+
+            vector3f left_max{bounds.Max()};
+            vector3f right_min{bounds.Min()};
+            left_max[axis] = plane;
+            right_min[axis] = plane;
+            bounds3f left{bounds.Min(), left_max};
+            bounds3f right{right_min, bounds.Max()};
+
+            surface_triangle const& triangle{build_triangles_[reference.get_primitive_index()]};
+            vector3f const* vertices[3]{&triangle.p0, &triangle.p1, &triangle.p2};
+
+            bounds3 clipped[2]{};
+            for(int i{}; i < 3; ++i)
+            {
+                vector3 a{*vertices[i]};
+                vector3 b{*vertices[(i + 1) % 3]};
+                if(a[axis] <= plane) clipped[0].Union(a);
+                if(a[axis] >= plane) clipped[1].Union(a);
+
+                if((a[axis] < plane && b[axis] > plane) || (a[axis] > plane && b[axis] < plane))
+                {
+                    vector3 p{a + (b - a) * ((plane - a[axis]) / (b[axis] - a[axis]))};
+                    p[axis] = plane;
+                    clipped[0].Union(p);
+                    clipped[1].Union(p);
+                }
+            }
+
+            // rounded outwards to float so the boxes never cut into the triangle
+            auto round_out{[] (bounds3 const& part, bounds3f const& box)
+            {
+                if(part.is_empty()) return bounds3f{};
+
+                vector3f part_min{};
+                vector3f part_max{};
+                for(int i{}; i < 3; ++i)
+                {
+                    part_min[i] = static_cast<float>(part.Min()[i]);
+                    part_max[i] = static_cast<float>(part.Max()[i]);
+                    if(part_min[i] > part.Min()[i]) part_min[i] = std::nextafter(part_min[i], -std::numeric_limits<float>::infinity());
+                    if(part_max[i] < part.Max()[i]) part_max[i] = std::nextafter(part_max[i], std::numeric_limits<float>::infinity());
+                }
+
+                bounds3f result{part_min, part_max};
+                result.Intersect(box);
+                return result.is_empty() ? bounds3f{} : result;
+            }};
+            return {round_out(clipped[0], left), round_out(clipped[1], right)};
+        }
+
+        // bins the references of a node between evenly spaced planes on every axis, references spanning
+        // several bins are clipped into each of them and counted on both sides of the planes they cross
+        spatial_split find_spatial_split(std::vector<primitive_info> const& primitive_infos, std::uint32_t begin, std::uint32_t end, std::uint32_t capacity_end, bounds3f const& bounds) const
+        {
+            struct bin_info
+            {
+                std::uint32_t entry_count{};
+                std::uint32_t exit_count{};
+                bounds3f bounds{};
+            };
+
+            spatial_split best{};
+            for(int axis{}; axis < 3; ++axis)
+            {
+                if(!(bounds.Max()[axis] > bounds.Min()[axis])) continue;
+
+                bin_info bins[spatial_bin_count]{};
+                for(std::uint32_t i{begin}; i < end; ++i)
+                {
+                    primitive_info const& reference{primitive_infos[i]};
+                    auto [first, last] {get_spatial_bins(bounds, axis, reference)};
+                    bins[first].entry_count += 1;
+                    bins[last].exit_count += 1;
+
+                    if(first == last)
+                    {
+                        bins[first].bounds.Union(reference.get_bounds());
+                        continue;
+                    }
+
+                    // each crossed plane cuts the rest of the reference once, the part left of it belongs to the bin
+                    bounds3f rest{reference.get_bounds()};
+                    for(int b{first}; b < last && !rest.is_empty(); ++b)
+                    {
+                        auto [left, right] {split_reference(reference, axis, get_spatial_plane(bounds, axis, b + 1))};
+                        if(!left.Intersect(rest).is_empty()) bins[b].bounds.Union(left);
+                        rest.Intersect(right);
+                    }
+                    if(!rest.is_empty()) bins[last].bounds.Union(rest);
+                }
+
+                bounds3f right_bounds[spatial_bin_count]{};
+                std::uint32_t right_counts[spatial_bin_count]{};
+                right_bounds[spatial_bin_count - 1] = bins[spatial_bin_count - 1].bounds;
+                right_counts[spatial_bin_count - 1] = bins[spatial_bin_count - 1].exit_count;
+                for(int i{spatial_bin_count - 2}; i >= 0; --i)
+                {
+                    right_bounds[i] = Union(right_bounds[i + 1], bins[i].bounds);
+                    right_counts[i] = right_counts[i + 1] + bins[i].exit_count;
+                }
+
+                bounds3f left_bounds{};
+                std::uint32_t left_count{};
+                for(int i{1}; i < spatial_bin_count; ++i)
+                {
+                    left_bounds.Union(bins[i - 1].bounds);
+                    left_count += bins[i - 1].entry_count;
+                    std::uint32_t right_count{right_counts[i]};
+                    if(left_count == 0 || right_count == 0) continue;
+
+                    std::uint32_t duplicate_count{left_count + right_count - (end - begin)};
+                    if(duplicate_count > capacity_end - end) continue;
+
+                    double cost{0.125 + (left_count * left_bounds.area() + right_count * right_bounds[i].area()) / bounds.area()};
+                    if(cost < best.cost)
+                    {
+                        best = {axis, i, cost};
+                    }
+                }
+            }
+
+            return best;
+        }
+
+        std::uint32_t build_spatial_split(std::vector<primitive_info>& primitive_infos, std::uint32_t begin, std::uint32_t end, std::uint32_t capacity_end, bounds3f const& bounds,
+            spatial_split const& split, build_output& output)
+        {
+            float plane{get_spatial_plane(bounds, split.axis, split.plane)};
+
+            std::vector<primitive_info> left{};
+            std::vector<primitive_info> right{};
+            for(std::uint32_t i{begin}; i < end; ++i)
+            {
+                primitive_info const& reference{primitive_infos[i]};
+                auto [first, last] {get_spatial_bins(bounds, split.axis, reference)};
+                if(last < split.plane)
+                {
+                    left.push_back(reference);
+                }
+                else if(first >= split.plane)
+                {
+                    right.push_back(reference);
+                }
+                else
+                {
+                    auto [left_part, right_part] {split_reference(reference, split.axis, plane)};
+                    if(left_part.is_empty())
+                    {
+                        right.push_back(reference);
+                    }
+                    else if(right_part.is_empty())
+                    {
+                        left.push_back(reference);
+                    }
+                    else
+                    {
+                        left.emplace_back(reference.get_primitive_index(), left_part, reference.is_triangle());
+                        right.emplace_back(reference.get_primitive_index(), right_part, reference.is_triangle());
+                    }
+                }
+            }
+
+            // the same references would come back, which only happens when clipping rounds away a side
+            if(left.empty() || right.empty())
+            {
+                return build_leaf(primitive_infos, begin, end, bounds, output);
+            }
+
+            std::uint32_t reference_count{static_cast<std::uint32_t>(left.size() + right.size())};
+            std::uint32_t spare{capacity_end - begin - reference_count};
+            std::uint32_t left_spare{static_cast<std::uint32_t>(static_cast<std::uint64_t>(spare) * left.size() / reference_count)};
+            std::uint32_t middle{begin + static_cast<std::uint32_t>(left.size())};
+            std::copy(left.begin(), left.end(), primitive_infos.begin() + begin);
+            std::copy(right.begin(), right.end(), primitive_infos.begin() + middle + left_spare);
+
+            std::uint32_t index{static_cast<uint32_t>(output.nodes.size())};
+            output.nodes.emplace_back();
+            output.sah_cost += 0.125 * bounds.area();
+
+            build(primitive_infos, begin, middle, middle + left_spare, output);
+            std::uint32_t right_child_index{build(primitive_infos, middle + left_spare, middle + left_spare + static_cast<std::uint32_t>(right.size()), capacity_end, output)};
+            output.nodes[index] = build_node::create_interior(bounds, right_child_index, static_cast<uint16_t>(split.axis));
+            return index;
+        }
+
+        struct morton_primitive
+        {
+            std::uint32_t code{};
+            std::uint32_t index{};
+        };
+
+        // interior node of the binary radix tree over the sorted codes, children with radix_leaf set are primitives
+        static constexpr std::uint32_t radix_leaf{1u << 31};
+
+        struct radix_node
+        {
+            std::uint32_t children[2]{};
+            std::uint32_t first{};
+            std::uint32_t last{};
+            std::uint32_t parent{};
+            bounds3f bounds{};
+        };
+
+        // where a separately built subtree starts in each array of the joined output
+        struct build_offsets
+        {
+            std::uint32_t nodes{};
+            std::uint32_t triangle_packets{};
+            std::uint32_t leaf_primitives{};
+            std::uint32_t spheres{};
+            std::uint32_t planes{};
+            std::uint32_t primitives{};
+        };
+
+        struct morton_cluster
+        {
+            std::uint32_t root{};
+            std::uint32_t primitive_count{};
+            bounds3f bounds{};
+            vector3f centroid{};
+            build_output output{};
+            build_offsets offsets{};
+        };
+
+        // 10 bits per axis interleaved into the top 30 bits
+        static std::uint32_t encode_morton(vector3f const& offset)
+        {
+            auto spread{[] (float x)
+            {
+                std::uint32_t v{std::min(static_cast<std::uint32_t>(std::max(x, 0.0f) * 1024.0f), 1023u)};
+                v = (v | (v << 16)) & 0x030000ff;
+                v = (v | (v << 8)) & 0x0300f00f;
+                v = (v | (v << 4)) & 0x030c30c3;
+                v = (v | (v << 2)) & 0x09249249;
+                return v;
+            }};
+            return ((spread(offset.x) << 2) | (spread(offset.y) << 1) | spread(offset.z)) << 2;
+        }
+
+        // least significant digit first, every pass counts per chunk in parallel and scatters each chunk behind
+        // the same digits of the chunks before it, so the order of equal codes is kept
+        static void radix_sort(std::vector<morton_primitive>& primitives)
+        {
+            std::vector<morton_primitive> sorted(primitives.size());
+            std::size_t chunk_count{get_parallel_chunk_count(primitives.size())};
+            std::vector<std::array<std::uint32_t, 256>> offsets(chunk_count);
+
+            for(int shift{}; shift < 32; shift += 8)
+            {
+                parallel_chunks(primitives.size(), chunk_count, [&] (std::size_t chunk, std::size_t begin, std::size_t end)
+                {
+                    offsets[chunk].fill(0);
+                    for(std::size_t i{begin}; i < end; ++i)
+                    {
+                        offsets[chunk][(primitives[i].code >> shift) & 0xff] += 1;
+                    }
+                });
+
+                std::uint32_t offset{};
+                for(int digit{}; digit < 256; ++digit)
+                {
+                    for(std::size_t chunk{}; chunk < chunk_count; ++chunk)
+                    {
+                        std::uint32_t count{offsets[chunk][digit]};
+                        offsets[chunk][digit] = offset;
+                        offset += count;
+                    }
+                }
+
+                parallel_chunks(primitives.size(), chunk_count, [&] (std::size_t chunk, std::size_t begin, std::size_t end)
+                {
+                    for(std::size_t i{begin}; i < end; ++i)
+                    {
+                        sorted[offsets[chunk][(primitives[i].code >> shift) & 0xff]++] = primitives[i];
+                    }
+                });
+                std::swap(primitives, sorted);
+            }
+        }
+
+        // length of the common prefix of two sorted codes, equal codes are told apart by their positions
+        static int get_common_prefix(std::vector<morton_primitive> const& primitives, std::int64_t i, std::int64_t j)
+        {
+            if(j < 0 || j >= static_cast<std::int64_t>(primitives.size())) return -1;
+
+            std::uint32_t a{primitives[i].code};
+            std::uint32_t b{primitives[j].code};
+            if(a == b) return 32 + std::countl_zero(static_cast<std::uint32_t>(i ^ j));
+            return std::countl_zero(a ^ b);
+        }
+
+        // node i of the radix tree covers the range that starts or ends at primitive i and splits it where
+        // the common prefix grows, which lets every node be found independently [Karras 2012]
+        static void build_radix_node(std::vector<morton_primitive> const& primitives, std::int64_t i, std::vector<radix_node>& radix_nodes, std::vector<std::uint32_t>& leaf_parents)
+        {
+            int direction{get_common_prefix(primitives, i, i + 1) > get_common_prefix(primitives, i, i - 1) ? 1 : -1};
+            int prefix_min{get_common_prefix(primitives, i, i - direction)};
+
+            std::int64_t length_max{2};
+            while(get_common_prefix(primitives, i, i + length_max * direction) > prefix_min)
+            {
+                length_max *= 2;
+            }
+
+            std::int64_t length{};
+            for(std::int64_t t{length_max / 2}; t >= 1; t /= 2)
+            {
+                if(get_common_prefix(primitives, i, i + (length + t) * direction) > prefix_min) length += t;
+            }
+
+            std::int64_t j{i + length * direction};
+            int prefix{get_common_prefix(primitives, i, j)};
+
+            std::int64_t split{};
+            for(std::int64_t t{length}; t > 1;)
+            {
+                t = (t + 1) / 2;
+                if(get_common_prefix(primitives, i, i + (split + t) * direction) > prefix) split += t;
+            }
+
+            std::uint32_t gamma{static_cast<std::uint32_t>(i + split * direction + std::min(direction, 0))};
+            radix_node& node{radix_nodes[i]};
+            node.first = static_cast<std::uint32_t>(std::min(i, j));
+            node.last = static_cast<std::uint32_t>(std::max(i, j));
+
+            std::uint32_t children[2]{gamma, gamma + 1};
+            for(int c{}; c < 2; ++c)
+            {
+                if(children[c] == (c == 0 ? node.first : node.last))
+                {
+                    node.children[c] = children[c] | radix_leaf;
+                    leaf_parents[children[c]] = static_cast<std::uint32_t>(i);
+                }
+                else
+                {
+                    node.children[c] = children[c];
+                    radix_nodes[children[c]].parent = static_cast<std::uint32_t>(i);
+                }
+            }
+        }
+
+        // sorts the primitives along a morton curve over their centroids and builds the radix tree of the codes,
+        // every node at once, then its bounds bottom up where the second child to finish refits the parent;
+        // subtrees whose codes share the top morton_cluster_bits become clusters, built in parallel and joined
+        // by a sah build over them or by the radix tree above them
+        void build_morton(std::vector<primitive_info>& primitive_infos, bool sah_top, build_output& output)
+        {
+            std::uint32_t primitive_count{static_cast<std::uint32_t>(primitive_infos.size())};
+            if(primitive_count == 1)
+            {
+                build(primitive_infos, 0, 1, 1, output);
+                return;
+            }
+
+            std::size_t chunk_count{get_parallel_chunk_count(primitive_count)};
+            std::vector<bounds3f> chunk_bounds(chunk_count);
+            parallel_chunks(primitive_count, chunk_count, [&] (std::size_t chunk, std::size_t begin, std::size_t end)
+            {
+                for(std::size_t i{begin}; i < end; ++i)
+                {
+                    chunk_bounds[chunk].Union(primitive_infos[i].get_centroid());
+                }
+            });
+
+            bounds3f centroid_bounds{};
+            for(bounds3f const& bounds : chunk_bounds)
+            {
+                centroid_bounds.Union(bounds);
+            }
+
+            vector3f extent{centroid_bounds.diagonal()};
+            vector3f scale{extent.x > 0.0f ? 1.0f / extent.x : 0.0f, extent.y > 0.0f ? 1.0f / extent.y : 0.0f, extent.z > 0.0f ? 1.0f / extent.z : 0.0f};
+            std::vector<morton_primitive> morton_primitives(primitive_count);
+            parallel_for(primitive_count, [&] (std::size_t i)
+            {
+                vector3f offset{(primitive_infos[i].get_centroid() - centroid_bounds.Min()) * scale};
+                morton_primitives[i] = {encode_morton(offset), static_cast<std::uint32_t>(i)};
+            });
+            radix_sort(morton_primitives);
+
+            std::vector<primitive_info> sorted_infos(primitive_count);
+            parallel_for(primitive_count, [&] (std::size_t i)
+            {
+                sorted_infos[i] = primitive_infos[morton_primitives[i].index];
+            });
+            std::swap(primitive_infos, sorted_infos);
+
+            std::vector<radix_node> radix_nodes(primitive_count - 1);
+            std::vector<std::uint32_t> leaf_parents(primitive_count);
+            parallel_for(primitive_count - 1, [&] (std::size_t i)
+            {
+                build_radix_node(morton_primitives, static_cast<std::int64_t>(i), radix_nodes, leaf_parents);
+            });
+
+            std::vector<std::atomic<std::uint32_t>> arrivals(primitive_count - 1);
+            parallel_for(primitive_count, [&] (std::size_t i)
+            {
+                std::uint32_t index{leaf_parents[i]};
+                while(arrivals[index].fetch_add(1, std::memory_order_acq_rel) == 1)
+                {
+                    radix_node& node{radix_nodes[index]};
+                    for(int c{}; c < 2; ++c)
+                    {
+                        std::uint32_t child{node.children[c]};
+                        node.bounds.Union(child & radix_leaf ? primitive_infos[child & ~radix_leaf].get_bounds() : radix_nodes[child].bounds);
+                    }
+
+                    if(index == 0) break;
+                    index = node.parent;
+                }
+            });
+
+            std::vector<morton_cluster> clusters{};
+            std::vector<std::uint32_t> stack{0};
+            while(!stack.empty())
+            {
+                std::uint32_t root{stack.back()};
+                stack.pop_back();
+
+                if(root & radix_leaf)
+                {
+                    std::uint32_t i{root & ~radix_leaf};
+                    clusters.push_back({root, 1, primitive_infos[i].get_bounds(), primitive_infos[i].get_centroid()});
+                    continue;
+                }
+
+                radix_node const& node{radix_nodes[root]};
+                if(get_common_prefix(morton_primitives, node.first, node.last) >= morton_cluster_bits)
+                {
+                    clusters.push_back({root, node.last - node.first + 1, node.bounds, node.bounds.centroid()});
+                }
+                else
+                {
+                    stack.push_back(node.children[1]);
+                    stack.push_back(node.children[0]);
+                }
+            }
+
+            parallel_chunks(clusters.size(), chunk_count, [&] (std::size_t, std::size_t begin, std::size_t end)
+            {
+                for(std::size_t i{begin}; i < end; ++i)
+                {
+                    // a leaf per primitive at most, and the interior nodes joining them
+                    build_output& cluster_output{clusters[i].output};
+                    cluster_output.nodes.reserve(clusters[i].primitive_count * 2 - 1);
+                    cluster_output.primitives.reserve(clusters[i].primitive_count);
+                    build_radix_subtree(clusters[i].root, primitive_infos, radix_nodes, cluster_output);
+                }
+            });
+
+            // the joined output never grows past the clusters and the top nodes above them
+            build_offsets sizes{static_cast<std::uint32_t>(clusters.size())};
+            for(morton_cluster const& cluster : clusters)
+            {
+                sizes.nodes += static_cast<std::uint32_t>(cluster.output.nodes.size());
+                sizes.triangle_packets += static_cast<std::uint32_t>(cluster.output.triangle_packets.size());
+                sizes.leaf_primitives += static_cast<std::uint32_t>(cluster.output.leaf_primitives.size());
+                sizes.spheres += static_cast<std::uint32_t>(cluster.output.spheres.size());
+                sizes.planes += static_cast<std::uint32_t>(cluster.output.planes.size());
+                sizes.primitives += static_cast<std::uint32_t>(cluster.output.primitives.size());
+            }
+            output.nodes.reserve(sizes.nodes);
+            output.triangle_packets.reserve(sizes.triangle_packets);
+            output.leaf_primitives.reserve(sizes.leaf_primitives);
+            output.spheres.reserve(sizes.spheres);
+            output.planes.reserve(sizes.planes);
+            output.primitives.reserve(sizes.primitives);
+
+            if(sah_top)
+            {
+                build_clusters(clusters, 0, static_cast<std::uint32_t>(clusters.size()), output);
+            }
+            else
+            {
+                std::uint32_t next_cluster{};
+                build_radix_top(0, radix_nodes, clusters, next_cluster, output);
+            }
+
+            parallel_chunks(clusters.size(), chunk_count, [&] (std::size_t, std::size_t begin, std::size_t end)
+            {
+                for(std::size_t i{begin}; i < end; ++i)
+                {
+                    copy_subtree(clusters[i].output, clusters[i].offsets, output);
+                    clusters[i].output = {};
+                }
+            });
+        }
+
+        // exact sah over the clusters, sorted along the widest axis of their centroids
+        static std::uint32_t build_clusters(std::vector<morton_cluster>& clusters, std::uint32_t begin, std::uint32_t end, build_output& output)
+        {
+            if(end - begin == 1)
+            {
+                return place_subtree(clusters[begin].output, clusters[begin].offsets, output);
+            }
+
+            bounds3f bounds{};
+            bounds3f centroid_bounds{};
+            for(std::uint32_t i{begin}; i < end; ++i)
+            {
+                bounds.Union(clusters[i].bounds);
+                centroid_bounds.Union(clusters[i].centroid);
+            }
+
+            int split_axis{centroid_bounds.maximum_extent()};
+            std::sort(clusters.begin() + begin, clusters.begin() + end,
+                [split_axis] (morton_cluster const& a, morton_cluster const& b)
+                {
+                    return a.centroid[split_axis] < b.centroid[split_axis];
+                }
+            );
+
+            std::vector<double> right_costs(end - begin);
+            bounds3f right_bounds{};
+            std::uint32_t right_count{};
+            for(std::uint32_t i{end - 1}; i > begin; --i)
+            {
+                right_bounds.Union(clusters[i].bounds);
+                right_count += clusters[i].primitive_count;
+                right_costs[i - begin] = right_bounds.area() * right_count;
+            }
+
+            bounds3f left_bounds{};
+            std::uint32_t left_count{};
+            double min_cost{std::numeric_limits<double>::infinity()};
+            std::uint32_t middle{begin + 1};
+            for(std::uint32_t i{begin + 1}; i < end; ++i)
+            {
+                left_bounds.Union(clusters[i - 1].bounds);
+                left_count += clusters[i - 1].primitive_count;
+                double cost{left_bounds.area() * left_count + right_costs[i - begin]};
+                if(cost < min_cost)
+                {
+                    min_cost = cost;
+                    middle = i;
                 }
             }
 
-            std::uint32_t index{static_cast<uint32_t>(nodes_.size())};
-            nodes_.emplace_back();
+            std::uint32_t index{static_cast<uint32_t>(output.nodes.size())};
+            output.nodes.emplace_back();
+            output.sah_cost += 0.125 * bounds.area();
+
+            build_clusters(clusters, begin, middle, output);
+            std::uint32_t right_child_index{build_clusters(clusters, middle, end, output)};
+            output.nodes[index] = build_node::create_interior(bounds, right_child_index, static_cast<uint16_t>(split_axis));
+            return index;
+        }
+
+        // the radix tree above the clusters, which meets them in the order they were collected
+        static std::uint32_t build_radix_top(std::uint32_t root, std::vector<radix_node> const& radix_nodes, std::vector<morton_cluster>& clusters,
+            std::uint32_t& next_cluster, build_output& output)
+        {
+            if(clusters[next_cluster].root == root)
+            {
+                morton_cluster& cluster{clusters[next_cluster++]};
+                return place_subtree(cluster.output, cluster.offsets, output);
+            }
+
+            radix_node const& node{radix_nodes[root]};
+            std::uint32_t index{static_cast<uint32_t>(output.nodes.size())};
+            output.nodes.emplace_back();
+            output.sah_cost += 0.125 * node.bounds.area();
+
+            build_radix_top(node.children[0], radix_nodes, clusters, next_cluster, output);
+            std::uint32_t right_child_index{build_radix_top(node.children[1], radix_nodes, clusters, next_cluster, output)};
+            output.nodes[index] = build_node::create_interior(node.bounds, right_child_index, 0);
+            return index;
+        }
+
+        // radix tree nodes small enough for a leaf end there, primitives keep their sorted order
+        std::uint32_t build_radix_subtree(std::uint32_t root, std::vector<primitive_info>& primitive_infos, std::vector<radix_node> const& radix_nodes, build_output& output)
+        {
+            if(root & radix_leaf)
+            {
+                std::uint32_t i{root & ~radix_leaf};
+                return build_leaf(primitive_infos, i, i + 1, primitive_infos[i].get_bounds(), output);
+            }
+
+            radix_node const& node{radix_nodes[root]};
+            if(is_leaf_sized(primitive_infos, node.first, node.last + 1))
+            {
+                return build_leaf(primitive_infos, node.first, node.last + 1, node.bounds, output);
+            }
+
+            std::uint32_t index{static_cast<uint32_t>(output.nodes.size())};
+            output.nodes.emplace_back();
+            output.sah_cost += 0.125 * node.bounds.area();
 
-            build(primitive_infos, begin, middle, ordered_primitives);
-            std::uint32_t right_child_index{build(primitive_infos, middle, end, ordered_primitives)};
-            nodes_[index] = node::create_interior(bounds, right_child_index, static_cast<uint16_t>(split_axis));
+            build_radix_subtree(node.children[0], primitive_infos, radix_nodes, output);
+            std::uint32_t right_child_index{build_radix_subtree(node.children[1], primitive_infos, radix_nodes, output)};
+            output.nodes[index] = build_node::create_interior(node.bounds, right_child_index, 0);
             return index;
         }
+
+        // makes room for a separately built subtree behind what the output holds so far, copy_subtree fills it in
+        static std::uint32_t place_subtree(build_output const& subtree, build_offsets& offsets, build_output& output)
+        {
+            auto place{[] (auto& values, std::size_t count)
+            {
+                std::uint32_t offset{static_cast<std::uint32_t>(values.size())};
+                values.resize(values.size() + count);
+                return offset;
+            }};
+
+            offsets.nodes = place(output.nodes, subtree.nodes.size());
+            offsets.triangle_packets = place(output.triangle_packets, subtree.triangle_packets.size());
+            offsets.leaf_primitives = place(output.leaf_primitives, subtree.leaf_primitives.size());
+            offsets.spheres = place(output.spheres, subtree.spheres.size());
+            offsets.planes = place(output.planes, subtree.planes.size());
+            offsets.primitives = place(output.primitives, subtree.primitives.size());
+            output.sah_cost += subtree.sah_cost;
+            return offsets.nodes;
+        }
+
+        // indices within the subtree become indices into the joined output
+        static void copy_subtree(build_output const& subtree, build_offsets const& offsets, build_output& output)
+        {
+            for(std::size_t i{}; i < subtree.nodes.size(); ++i)
+            {
+                build_node& node{output.nodes[offsets.nodes + i] = subtree.nodes[i]};
+                node.relocate(offsets.nodes, offsets.leaf_primitives, offsets.triangle_packets);
+            }
+
+            for(std::size_t i{}; i < subtree.triangle_packets.size(); ++i)
+            {
+                leaf_triangle_packet& packet{output.triangle_packets[offsets.triangle_packets + i] = subtree.triangle_packets[i]};
+                for(std::uint32_t& primitive : packet.primitives)
+                {
+                    if(primitive != empty_lane) primitive += offsets.primitives;
+                }
+            }
+
+            for(std::size_t i{}; i < subtree.leaf_primitives.size(); ++i)
+            {
+                leaf_primitive& primitive{output.leaf_primitives[offsets.leaf_primitives + i] = subtree.leaf_primitives[i]};
+                primitive.primitive += offsets.primitives;
+                if(primitive.type == leaf_primitive_type::sphere) primitive.shape += offsets.spheres;
+                if(primitive.type == leaf_primitive_type::plane) primitive.shape += offsets.planes;
+            }
+
+            std::copy(subtree.spheres.begin(), subtree.spheres.end(), output.spheres.begin() + offsets.spheres);
+            std::copy(subtree.planes.begin(), subtree.planes.end(), output.planes.begin() + offsets.planes);
+            std::copy(subtree.primitives.begin(), subtree.primitives.end(), output.primitives.begin() + offsets.primitives);
+        }
+
+        // replaces the depth first build nodes by nodes holding both children; the morton builders are for scenes
+        // rebuilt all the time and keep the depth first order, which needs no search and still puts every first
+        // child right behind its parent
+        void lay_out_nodes(bool treelets)
+        {
+            std::vector<std::uint32_t> order{};
+            if(treelets)
+            {
+                order = get_treelet_order();
+            }
+            else
+            {
+                order.reserve(build_nodes_.size() / 2);
+                for(std::uint32_t i{}; i < static_cast<std::uint32_t>(build_nodes_.size()); ++i)
+                {
+                    if(build_nodes_[i].is_interior()) order.push_back(i);
+                }
+            }
+
+            std::vector<std::uint32_t> node_indices(build_nodes_.size());
+            for(std::uint32_t i{}; i < static_cast<std::uint32_t>(order.size()); ++i)
+            {
+                node_indices[order[i]] = i;
+            }
+
+            auto get_ref{[&] (std::uint32_t index)
+            {
+                build_node const& n{build_nodes_[index]};
+                if(n.is_interior()) return node_ref{node_indices[index], 0, node_type::interior};
+                if(n.is_triangle_leaf()) return node_ref{n.get_first_packet(), n.get_packet_count(), node_type::triangle_leaf};
+                return node_ref{n.get_first_primitive(), n.get_primitive_count(), node_type::leaf};
+            }};
+
+            bounds_ = build_nodes_[0].get_bounds();
+            root_ = get_ref(0);
+
+            if(layout_ == bvh_node_layout::quantized)
+            {
+                quantized_nodes_.resize(order.size());
+            }
+            else
+            {
+                nodes_.resize(order.size());
+            }
+
+            std::vector<bounds3f> child_bounds(order.size() * 2);
+            refit_parents_.resize(order.size());
+            parallel_for(order.size(), [&] (std::size_t i)
+            {
+                std::uint32_t children[2]{order[i] + 1, build_nodes_[order[i]].get_second_child()};
+                for(int c{}; c < 2; ++c)
+                {
+                    std::uint32_t slot{static_cast<std::uint32_t>(i * 2 + c)};
+                    node_ref& child{get_child(slot)};
+                    child = get_ref(children[c]);
+                    child_bounds[slot] = build_nodes_[children[c]].get_bounds();
+
+                    if(child.type == node_type::interior)
+                    {
+                        refit_parents_[child.index] = slot;
+                    }
+                }
+            });
+
+            for(std::uint32_t slot{}; slot < static_cast<std::uint32_t>(order.size() * 2); ++slot)
+            {
+                if(get_child(slot).type != node_type::interior) refit_leaves_.push_back(slot);
+            }
+            store_child_bounds(child_bounds);
+
+            build_nodes_ = {};
+        }
+
+        // interior nodes grouped into page sized treelets, a treelet grows from its root by the largest nodes of its
+        // frontier, those most likely to be visited; a node already keeps both children in one cache line, the page
+        // keeps the nodes a ray walks through next under one tlb entry, and smaller treelets down to two cache lines
+        // traced no faster
+        std::vector<std::uint32_t> get_treelet_order() const
+        {
+            std::size_t treelet_size{treelet_bytes / (layout_ == bvh_node_layout::quantized ? sizeof(quantized_node) : sizeof(node))};
+
+            std::vector<std::uint32_t> order{};
+            std::vector<std::uint32_t> treelet_roots{};
+            if(build_nodes_[0].is_interior()) treelet_roots.push_back(0);
+
+            while(!treelet_roots.empty())
+            {
+                std::vector<std::uint32_t> frontier{treelet_roots.back()};
+                treelet_roots.pop_back();
+
+                for(std::size_t i{}; i < treelet_size && !frontier.empty(); ++i)
+                {
+                    auto it{std::max_element(frontier.begin(), frontier.end(), [this] (std::uint32_t a, std::uint32_t b) {
+                        return build_nodes_[a].get_bounds().area() < build_nodes_[b].get_bounds().area();
+                    })};
+                    std::uint32_t index{*it};
+                    frontier.erase(it);
+                    order.push_back(index);
+
+                    for(std::uint32_t child : {index + 1, build_nodes_[index].get_second_child()})
+                    {
+                        if(build_nodes_[child].is_interior()) frontier.push_back(child);
+                    }
+                }
+
+                treelet_roots.insert(treelet_roots.end(), frontier.rbegin(), frontier.rend());
+            }
+            return order;
+        }
+
+        node_ref& get_child(std::uint32_t slot)
+        {
+            if(layout_ == bvh_node_layout::quantized)
+            {
+                return quantized_nodes_[slot >> 1].children[slot & 1];
+            }
+            return nodes_[slot >> 1].children[slot & 1];
+        }
+
+        // quantized children are encoded against the decoded bounds of their parent, the same ones traversal sees,
+        // which comes before them in the layout
+        void store_child_bounds(std::vector<bounds3f> const& child_bounds)
+        {
+            if(layout_ == bvh_node_layout::quantized)
+            {
+                std::vector<bounds3f> node_bounds(quantized_nodes_.size());
+                if(!node_bounds.empty()) node_bounds[0] = bounds_;
+
+                for(std::uint32_t i{}; i < static_cast<std::uint32_t>(quantized_nodes_.size()); ++i)
+                {
+                    quantized_node& node{quantized_nodes_[i]};
+                    quantize(node_bounds[i], child_bounds[i * 2], child_bounds[i * 2 + 1], &node);
+
+                    for(int c{}; c < 2; ++c)
+                    {
+                        if(node.children[c].type == node_type::interior)
+                        {
+                            node_bounds[node.children[c].index] = node.get_child_bounds(c, node_bounds[i]);
+                        }
+                    }
+                }
+            }
+            else
+            {
+                parallel_for(nodes_.size(), [&] (std::size_t i)
+                {
+                    nodes_[i].child_bounds[0] = child_bounds[i * 2];
+                    nodes_[i].child_bounds[1] = child_bounds[i * 2 + 1];
+                });
+            }
+        }
+
+        // copies the current shapes into the leaf and returns its bounds, adding its part of the sah cost
+        bounds3f refit_leaf(node_ref const& leaf, double* cost)
+        {
+            bounds3f bounds{};
+            std::uint32_t primitive_count{};
+            if(leaf.type == node_type::triangle_leaf)
+            {
+                for(std::uint32_t i{leaf.index}; i < leaf.index + leaf.count; ++i)
+                {
+                    leaf_triangle_packet& packet{triangle_packets_[i]};
+                    for(int lane{}; lane < triangle_packet_width; ++lane)
+                    {
+                        if(packet.primitives[lane] == empty_lane) continue;
+
+                        entity_primitive const& primitive{primitives_[packet.primitives[lane]]};
+                        surface_triangle triangle{std::get<surface_triangle>(*primitive.entity->surface->get_shape(primitive.primitive))};
+                        vector3f const* vertices[3]{&triangle.p0, &triangle.p1, &triangle.p2};
+                        for(int v{}; v < 3; ++v)
+                        {
+                            for(int axis{}; axis < 3; ++axis)
+                            {
+                                packet.packet.vertices[v][axis][lane] = (*vertices[v])[axis];
+                            }
+                            bounds.Union(*vertices[v]);
+                        }
+                        ++primitive_count;
+                    }
+                }
+            }
+            else
+            {
+                for(std::uint32_t i{leaf.index}; i < leaf.index + leaf.count; ++i)
+                {
+                    leaf_primitive const& leaf_primitive{leaf_primitives_[i]};
+                    entity_primitive const& primitive{primitives_[leaf_primitive.primitive]};
+                    bounds.Union(primitive.entity->surface->get_bounds(primitive.primitive));
+
+                    if(leaf_primitive.type == leaf_primitive_type::sphere)
+                    {
+                        spheres_[leaf_primitive.shape] = std::get<surface_sphere>(*primitive.entity->surface->get_shape(primitive.primitive));
+                    }
+                    else if(leaf_primitive.type == leaf_primitive_type::plane)
+                    {
+                        planes_[leaf_primitive.shape] = std::get<surface_plane>(*primitive.entity->surface->get_shape(primitive.primitive));
+                    }
+                    ++primitive_count;
+                }
+            }
+
+            *cost += bounds.area() * primitive_count;
+            return bounds;
+        }
+
+        // a new tree over the same primitives, each referenced once again
+        void rebuild()
+        {
+            std::vector<entity_primitive> primitives{primitives_};
+            if(settings_.spatial_splits)
+            {
+                auto key{[] (entity_primitive const& a) { return std::make_pair(a.entity, a.primitive); }};
+                std::sort(primitives.begin(), primitives.end(), [&key] (entity_primitive const& a, entity_primitive const& b) { return key(a) < key(b); });
+                primitives.erase(std::unique(primitives.begin(), primitives.end(), [&key] (entity_primitive const& a, entity_primitive const& b) { return key(a) == key(b); }), primitives.end());
+            }
+            *this = basic_bvh_acceleration_structure{std::move(primitives), settings_};
+        }
+
+        // picks per axis the smallest step that spans the node in 255 steps, then rounds the children outwards
+        static void quantize(bounds3f const& bounds, bounds3f const& child0, bounds3f const& child1, quantized_node* node)
+        {
+            bounds3f const* children[2]{&child0, &child1};
+            for(int axis{}; axis < 3; ++axis)
+            {
+                float low{bounds.Min()[axis]};
+                float high{std::max(child0.Max()[axis], child1.Max()[axis])};
+
+                int exponent{};
+                std::frexp((static_cast<double>(high) - low) / 255.0, &exponent);
+                exponent = std::clamp(exponent, -126, 127);
+                while(exponent < 127 && low + 255.0f * quantized_node::get_step(exponent) < high) ++exponent;
+                node->exponents[axis] = static_cast<std::int8_t>(exponent);
+
+                float step{quantized_node::get_step(exponent)};
+                for(int c{}; c < 2; ++c)
+                {
+                    int q_low{std::clamp(static_cast<int>(std::floor((static_cast<double>(children[c]->Min()[axis]) - low) / step)), 0, 255)};
+                    while(q_low > 0 && low + static_cast<float>(q_low) * step > children[c]->Min()[axis]) --q_low;
+
+                    int q_high{std::clamp(static_cast<int>(std::ceil((static_cast<double>(children[c]->Max()[axis]) - low) / step)), 0, 255)};
+                    while(q_high < 255 && low + static_cast<float>(q_high) * step < children[c]->Max()[axis]) ++q_high;
+
+                    node->child_bounds[c][0][axis] = static_cast<std::uint8_t>(q_low);
+                    node->child_bounds[c][1][axis] = static_cast<std::uint8_t>(q_high);
+                }
+            }
+        }
     };
 
+    using bvh_acceleration_structure = basic_bvh_acceleration_structure<false>;
+
     class bvh_acceleration_structure_factory : public acceleration_structure_factory
     {
     public:
+        explicit bvh_acceleration_structure_factory(bvh_settings const& settings = {})
+            : settings_{settings}
+        { }
+
         virtual std::unique_ptr<acceleration_structure> create(std::vector<entity_primitive> entity_primitives) const override
         {
-            return std::unique_ptr<acceleration_structure>{new bvh_acceleration_structure{std::move(entity_primitives)}};
+            if(settings_.statistics)
+            {
+                return std::unique_ptr<acceleration_structure>{new basic_bvh_acceleration_structure<true>{std::move(entity_primitives), settings_}};
+            }
+            return std::unique_ptr<acceleration_structure>{new bvh_acceleration_structure{std::move(entity_primitives), settings_}};
         }
+
+    private:
+        bvh_settings settings_{};
     };
 }
\ No newline at end of file
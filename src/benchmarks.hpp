@@ -0,0 +1,890 @@
+#pragma once
+#include "images/rgb8_image.hpp"
+#include "textures/image_texture.hpp"
+#include "core/frame.hpp"
+#include "core/simd.hpp"
+#include "surfaces/mesh_surface.hpp"
+#include "acceleration_structures/bvh_acceleration_structure.hpp"
+#include "allocators/fixed_size_allocator.hpp"
+#include "samplers/random_sampler.hpp"
+#include "samplers/stratified_sampler.hpp"
+#include "samplers/sobol_sampler.hpp"
+#include "samplers/blue_noise_sampler.hpp"
+#include "surfaces/plane_surface.hpp"
+#include "surfaces/sphere_surface.hpp"
+#include "materials/diffuse_material.hpp"
+#include "lights/const_diffuse_area_light.hpp"
+#include "textures/const_texture.hpp"
+#include "light_distributions/uniform_light_distribution.hpp"
+#include "light_distributions/power_light_distribution.hpp"
+#include "light_distributions/bvh_light_distribution.hpp"
+#include "integrators/forward_mis_integrator.hpp"
+#include "renderer/cameras/perspective_camera.hpp"
+#include "renderer/renderer.hpp"
+#include "lib/pcg_random.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fc
+{
+    // best of several runs, single runs are too noisy on a loaded machine
+    template<typename F>
+    inline double benchmark_run(F&& f, int repeat_count = 5)
+    {
+        double best{std::numeric_limits<double>::infinity()};
+        for(int i{}; i < repeat_count; ++i)
+        {
+            auto start_time{std::chrono::high_resolution_clock::now()};
+            f();
+            auto end_time{std::chrono::high_resolution_clock::now()};
+            best = std::min(best, std::chrono::duration<double>(end_time - start_time).count());
+        }
+        return best;
+    }
+
+    inline void benchmark_report(std::string const& name, double seconds, std::size_t operation_count)
+    {
+        std::cout << std::setfill(' ') << std::left << std::setw(40) << name << std::right
+            << std::setw(10) << std::fixed << std::setprecision(2) << seconds * 1e9 / operation_count << " ns/op" << std::endl;
+    }
+
+    inline void benchmark_image_layout()
+    {
+        // large enough to miss every cache level, so each lookup pays for the lines it touches
+        vector2i resolution{8192, 8192};
+        constexpr std::size_t lookup_count{1 << 24};
+
+        std::vector<rgb8_pixel> pixels{};
+        pixels.resize(static_cast<std::size_t>(resolution.x) * static_cast<std::size_t>(resolution.y));
+        pcg32 generator{};
+        for(auto& pixel : pixels)
+        {
+            pixel = color8{static_cast<std::uint8_t>(generator()), static_cast<std::uint8_t>(generator()), static_cast<std::uint8_t>(generator())};
+        }
+
+        std::vector<vector2> uvs{};
+        uvs.resize(lookup_count);
+        std::uniform_real_distribution<double> distribution{};
+        for(auto& uv : uvs)
+        {
+            uv = {distribution(generator), distribution(generator)};
+        }
+
+        for(pixel_layout layout : {pixel_layout::linear, pixel_layout::tiled})
+        {
+            auto image{std::make_shared<rgb8_image>(resolution, pixels, layout)};
+            image_texture_2d_rgb texture{image, reconstruction_filter::bilinear, 1};
+
+            vector3 sum{};
+            double seconds{benchmark_run(
+                [&texture, &uvs, &sum] ()
+                {
+                    for(vector2 const& uv : uvs)
+                    {
+                        sum += texture.evaluate(uv);
+                    }
+                }
+            )};
+
+            // distinct cache lines touched by the four taps, independent of timer noise
+            std::size_t line_count{};
+            for(vector2 const& uv : uvs)
+            {
+                int x0{std::clamp(static_cast<int>(std::floor(uv.x * resolution.x - 0.5)), 0, resolution.x - 2)};
+                int y0{std::clamp(static_cast<int>(std::floor(uv.y * resolution.y - 0.5)), 0, resolution.y - 2)};
+
+                std::size_t lines[4]{
+                    image->get_pixel_index({x0, y0}) * sizeof(rgb8_pixel) / 64,
+                    image->get_pixel_index({x0 + 1, y0}) * sizeof(rgb8_pixel) / 64,
+                    image->get_pixel_index({x0, y0 + 1}) * sizeof(rgb8_pixel) / 64,
+                    image->get_pixel_index({x0 + 1, y0 + 1}) * sizeof(rgb8_pixel) / 64
+                };
+                std::sort(std::begin(lines), std::end(lines));
+                line_count += std::unique(std::begin(lines), std::end(lines)) - std::begin(lines);
+            }
+
+            std::string name{layout == pixel_layout::linear ? "image bilinear random uv (linear)" : "image bilinear random uv (tiled)"};
+            benchmark_report(name, seconds, lookup_count);
+            std::cout << "  cache lines per lookup " << std::setprecision(3) << static_cast<double>(line_count) / lookup_count
+                << ", checksum " << sum.x + sum.y + sum.z << std::endl;
+        }
+    }
+
+    inline void benchmark_math()
+    {
+        // small enough to stay in cache, the loops measure arithmetic and not memory
+        constexpr std::size_t vector_count{1 << 16};
+        constexpr int pass_count{64};
+        constexpr std::size_t operation_count{vector_count * pass_count};
+
+        std::vector<vector3> vectors{};
+        vectors.resize(vector_count);
+        pcg32 generator{};
+        std::uniform_real_distribution<double> distribution{-1.0, 1.0};
+        for(auto& v : vectors)
+        {
+            v = {distribution(generator), distribution(generator), distribution(generator)};
+        }
+        std::vector<vector3> results{};
+        results.resize(vector_count);
+
+        auto run{[&vectors, &results] (std::string const& name, auto&& f)
+        {
+            double seconds{benchmark_run(
+                [&vectors, &results, &f] ()
+                {
+                    for(int i{}; i < pass_count; ++i)
+                    {
+                        for(std::size_t j{}; j < vector_count; ++j)
+                        {
+                            results[j] = f(vectors[j], vectors[(j + 1) % vector_count]);
+                        }
+                    }
+                }
+            )};
+
+            vector3 sum{};
+            for(vector3 const& r : results)
+            {
+                sum += r;
+            }
+            benchmark_report(name, seconds, operation_count);
+            std::cout << "  checksum " << std::setprecision(6) << sum.x + sum.y + sum.z << std::endl;
+        }};
+
+        matrix4x4 m{matrix4x4::translate({1.0, 2.0, 3.0}) * matrix4x4::rotate_y(0.3) * matrix4x4::rotate_x(0.2) * matrix4x4::scale({1.0, 2.0, 0.5})};
+        packed_matrix3x4 packed_m{m};
+
+        run("transform point (scalar)", [&m] (vector3 const& p, vector3 const&) -> vector3
+        {
+            return {
+                m.m[0][0] * p.x + m.m[0][1] * p.y + m.m[0][2] * p.z + m.m[0][3],
+                m.m[1][0] * p.x + m.m[1][1] * p.y + m.m[1][2] * p.z + m.m[1][3],
+                m.m[2][0] * p.x + m.m[2][1] * p.y + m.m[2][2] * p.z + m.m[2][3]
+            };
+        });
+        run("transform point (packed)", [&packed_m] (vector3 const& p, vector3 const&)
+        {
+            return packed_m.transform_point(p);
+        });
+
+        run("normalize (scalar)", [] (vector3 const& v, vector3 const&)
+        {
+            return normalize(v);
+        });
+        run("normalize (packed)", [] (vector3 const& v, vector3 const&)
+        {
+            return normalize(packed_vector3{v}).unpack();
+        });
+
+        run("cross (scalar)", [] (vector3 const& a, vector3 const& b)
+        {
+            return cross(a, b);
+        });
+        run("cross (packed)", [] (vector3 const& a, vector3 const& b)
+        {
+            return cross(packed_vector3{a}, packed_vector3{b}).unpack();
+        });
+
+        // world to local and back, as done by bsdf for every evaluation
+        frame f{normalize(vector3{0.3, 0.5, 0.1})};
+        packed_matrix3x4 local_to_world{f.get_tangent(), f.get_normal(), f.get_bitangent()};
+        packed_matrix3x4 world_to_local{local_to_world.transpose3x3()};
+
+        run("frame round trip (scalar)", [&f] (vector3 const& w, vector3 const&)
+        {
+            return f.local_to_world(f.world_to_local(w));
+        });
+        run("frame round trip (packed)", [&local_to_world, &world_to_local] (vector3 const& w, vector3 const&)
+        {
+            return local_to_world.transform_vector(world_to_local.transform_vector(w));
+        });
+    }
+
+    // a room crossed by long diagonal beams, the case where centroid splits leave children overlapping
+    inline std::shared_ptr<mesh> create_benchmark_room_mesh()
+    {
+        std::vector<vector3f> positions{};
+        auto add_quad{[&positions] (vector3f const& a, vector3f const& b, vector3f const& c, vector3f const& d)
+        {
+            positions.insert(positions.end(), {a, b, c, a, c, d});
+        }};
+        auto add_box{[&add_quad] (vector3f const& origin, vector3f const& x, vector3f const& y, vector3f const& z)
+        {
+            add_quad(origin, origin + x, origin + x + y, origin + y);
+            add_quad(origin + z, origin + z + y, origin + z + x + y, origin + z + x);
+            add_quad(origin, origin + z, origin + z + x, origin + x);
+            add_quad(origin + y, origin + y + x, origin + y + x + z, origin + y + z);
+            add_quad(origin, origin + y, origin + y + z, origin + z);
+            add_quad(origin + x, origin + x + z, origin + x + y + z, origin + x + y);
+        }};
+
+        vector3f room{20.0f, 8.0f, 20.0f};
+        add_box({}, {room.x, 0.0f, 0.0f}, {0.0f, room.y, 0.0f}, {0.0f, 0.0f, room.z});
+
+        pcg32 generator{};
+        std::uniform_real_distribution<float> distribution{};
+        auto random_point{[&] (float y)
+        {
+            return vector3f{distribution(generator) * room.x, y, distribution(generator) * room.z};
+        }};
+
+        for(int i{}; i < 60; ++i)
+        {
+            vector3f a{random_point(0.0f)};
+            vector3f b{random_point(room.y)};
+            vector3f d{b - a};
+            vector3f u{};
+            vector3f v{};
+            coordinate_system(normalize(d), &u, &v);
+            add_box(a, d, u * 0.05f, v * 0.05f);
+        }
+
+        for(int i{}; i < 600; ++i)
+        {
+            float size{0.2f + distribution(generator)};
+            add_box(random_point(0.0f), {size, 0.0f, 0.0f}, {0.0f, size, 0.0f}, {0.0f, 0.0f, size});
+        }
+
+        std::uint32_t vertex_count{static_cast<std::uint32_t>(positions.size())};
+        std::unique_ptr<vector3f[]> mesh_positions{new vector3f[vertex_count]};
+        std::unique_ptr<vector3f[]> normals{new vector3f[vertex_count]};
+        std::unique_ptr<vector2f[]> uvs{new vector2f[vertex_count]};
+        std::unique_ptr<std::uint32_t[]> indices{new std::uint32_t[vertex_count]};
+        for(std::uint32_t i{}; i < vertex_count; ++i)
+        {
+            std::uint32_t first{i - i % 3};
+            mesh_positions[i] = positions[i];
+            normals[i] = normalize(cross(positions[first + 1] - positions[first], positions[first + 2] - positions[first]));
+            uvs[i] = {};
+            indices[i] = i;
+        }
+
+        return std::make_shared<default_mesh>(vertex_count, std::move(mesh_positions), std::move(normals), std::move(uvs), vertex_count, std::move(indices));
+    }
+
+    inline void benchmark_bvh_build()
+    {
+        constexpr std::size_t ray_count{1 << 19};
+
+        entity room{std::make_shared<mesh_surface>(prs_transform{}, create_benchmark_room_mesh())};
+        std::vector<entity_primitive> primitives{};
+        for(std::uint32_t i{}; i < room.surface->get_primitive_count(); ++i)
+        {
+            primitives.push_back({&room, i});
+        }
+
+        std::vector<ray3> rays{};
+        rays.reserve(ray_count);
+        pcg32 generator{};
+        std::uniform_real_distribution<double> distribution{};
+        for(std::size_t i{}; i < ray_count; ++i)
+        {
+            vector3 origin{distribution(generator) * 20.0, distribution(generator) * 8.0, distribution(generator) * 20.0};
+            vector3 direction{normalize(vector3{distribution(generator) - 0.5, distribution(generator) - 0.5, distribution(generator) - 0.5})};
+            rays.push_back({origin, direction});
+        }
+
+        fixed_size_allocator allocator{1 << 16};
+        allocator_wrapper allocator_wrapper{&allocator};
+
+        std::pair<std::string, bvh_settings> configurations[]{
+            {"object splits", {bvh_builder::sah}},
+            {"spatial splits", {bvh_builder::sah, bvh_node_layout::standard, true}},
+            {"hlbvh", {bvh_builder::hlbvh}},
+            {"lbvh", {bvh_builder::lbvh}}
+        };
+
+        for(auto const& [configuration, settings] : configurations)
+        {
+            std::unique_ptr<bvh_acceleration_structure> bvh{};
+            double build_seconds{benchmark_run(
+                [&bvh, &primitives, &settings] ()
+                {
+                    bvh = std::make_unique<bvh_acceleration_structure>(primitives, settings);
+                }, 1
+            )};
+
+            double sum{};
+            double closest_seconds{benchmark_run(
+                [&bvh, &rays, &allocator_wrapper, &sum] ()
+                {
+                    sum = 0.0;
+                    for(ray3 const& ray : rays)
+                    {
+                        allocator_wrapper.clear();
+                        if(auto result{bvh->raycast_surface_point(ray, std::numeric_limits<double>::infinity(), allocator_wrapper)})
+                        {
+                            sum += result->p->get_position().x;
+                        }
+                    }
+                }
+            )};
+
+            std::size_t hit_count{};
+            double shadow_seconds{benchmark_run(
+                [&bvh, &rays, &hit_count] ()
+                {
+                    hit_count = 0;
+                    for(ray3 const& ray : rays)
+                    {
+                        hit_count += bvh->raycast(ray, 4.0) ? 1 : 0;
+                    }
+                }
+            )};
+
+            std::string name{"bvh room (" + configuration + ")"};
+            benchmark_report(name + " closest", closest_seconds, ray_count);
+            benchmark_report(name + " shadow", shadow_seconds, ray_count);
+            std::cout << "  sah cost " << std::setprecision(2) << bvh->get_sah_cost() << ", references " << bvh->get_reference_count()
+                << " for " << primitives.size() << " primitives, build " << build_seconds << " s"
+                << ", checksum " << sum << " " << hit_count << std::endl;
+        }
+    }
+
+    // a rolling heightfield of cell_count by cell_count quads, for builds at the scale of large scanned meshes
+    inline std::shared_ptr<mesh> create_benchmark_terrain_mesh(std::uint32_t cell_count)
+    {
+        std::uint32_t side{cell_count + 1};
+        std::uint32_t vertex_count{side * side};
+        std::unique_ptr<vector3f[]> positions{new vector3f[vertex_count]};
+        std::unique_ptr<vector3f[]> normals{new vector3f[vertex_count]};
+        std::unique_ptr<vector2f[]> uvs{new vector2f[vertex_count]};
+        for(std::uint32_t i{}; i < side; ++i)
+        {
+            for(std::uint32_t j{}; j < side; ++j)
+            {
+                float x{static_cast<float>(j) / cell_count};
+                float z{static_cast<float>(i) / cell_count};
+                float height{0.05f * std::sin(40.0f * x) * std::cos(30.0f * z) + 0.01f * std::sin(300.0f * x + 200.0f * z)};
+                positions[i * side + j] = {x, height, z};
+                normals[i * side + j] = {0.0f, 1.0f, 0.0f};
+                uvs[i * side + j] = {x, z};
+            }
+        }
+
+        std::uint32_t index_count{cell_count * cell_count * 6};
+        std::unique_ptr<std::uint32_t[]> indices{new std::uint32_t[index_count]};
+        std::uint32_t* index{indices.get()};
+        for(std::uint32_t i{}; i < cell_count; ++i)
+        {
+            for(std::uint32_t j{}; j < cell_count; ++j)
+            {
+                std::uint32_t v{i * side + j};
+                for(std::uint32_t k : {v, v + side, v + 1, v + 1, v + side, v + side + 1})
+                {
+                    *index++ = k;
+                }
+            }
+        }
+
+        return std::make_shared<default_mesh>(vertex_count, std::move(positions), std::move(normals), std::move(uvs), index_count, std::move(indices));
+    }
+
+    // build times alone, over one and ten million triangles where the morton builders are meant to pay off; the ten
+    // million case is built once per builder, a repeat would not change the picture at that size
+    inline void benchmark_bvh_build_large()
+    {
+        std::pair<std::string, bvh_settings> configurations[]{
+            {"object splits", {bvh_builder::sah}},
+            {"hlbvh", {bvh_builder::hlbvh}},
+            {"lbvh", {bvh_builder::lbvh}},
+            {"hlbvh quantized", {bvh_builder::hlbvh, bvh_node_layout::quantized}},
+            {"lbvh quantized", {bvh_builder::lbvh, bvh_node_layout::quantized}}
+        };
+
+        std::cout << "bvh terrain build on " << std::thread::hardware_concurrency() << " threads" << std::endl;
+        for(std::uint32_t cell_count : {724u, 2237u})
+        {
+            entity terrain{std::make_shared<mesh_surface>(prs_transform{}, create_benchmark_terrain_mesh(cell_count))};
+            std::vector<entity_primitive> primitives{};
+            primitives.reserve(terrain.surface->get_primitive_count());
+            for(std::uint32_t i{}; i < terrain.surface->get_primitive_count(); ++i)
+            {
+                primitives.push_back({&terrain, i});
+            }
+
+            int repeat_count{primitives.size() > 5'000'000 ? 1 : 3};
+            for(auto const& [configuration, settings] : configurations)
+            {
+                std::unique_ptr<bvh_acceleration_structure> bvh{};
+                double build_seconds{benchmark_run(
+                    [&bvh, &primitives, &settings] ()
+                    {
+                        bvh.reset();
+                        bvh = std::make_unique<bvh_acceleration_structure>(primitives, settings);
+                    }, repeat_count
+                )};
+
+                std::cout << "bvh terrain build (" << configuration << "): " << std::setprecision(3) << build_seconds << " s for "
+                    << primitives.size() << " triangles, sah cost " << bvh->get_sah_cost() << std::endl;
+            }
+        }
+    }
+
+    inline void benchmark_bvh_refit()
+    {
+        constexpr int frame_count{8};
+
+        std::shared_ptr<mesh> room_mesh{create_benchmark_room_mesh()};
+        auto room_surface{std::make_shared<mesh_surface>(prs_transform{}, room_mesh)};
+        entity room{room_surface};
+        std::vector<entity_primitive> primitives{};
+        for(std::uint32_t i{}; i < room.surface->get_primitive_count(); ++i)
+        {
+            primitives.push_back({&room, i});
+        }
+
+        // a wave running along the room, which moves every triangle but keeps it close to its neighbours
+        std::vector<vector3f> positions(room_mesh->get_vertex_count());
+        auto set_frame{[&] (int frame)
+        {
+            for(std::size_t i{}; i < positions.size(); ++i)
+            {
+                vector3f p{room_mesh->get_positions()[i]};
+                positions[i] = p + vector3f{0.0f, 0.3f * std::sin(0.5f * p.x + 0.4f * frame), 0.0f};
+            }
+            room_surface->set_positions(positions.data());
+        }};
+
+        for(bvh_builder builder : {bvh_builder::sah, bvh_builder::lbvh})
+        {
+            set_frame(0);
+            bvh_settings settings{builder};
+            bvh_acceleration_structure bvh{primitives, settings};
+
+            for(int frame{1}; frame < frame_count; ++frame)
+            {
+                set_frame(frame);
+                double update_seconds{benchmark_run([&bvh] () { bvh.update(); }, 1)};
+
+                std::unique_ptr<bvh_acceleration_structure> rebuilt_bvh{};
+                double build_seconds{benchmark_run(
+                    [&rebuilt_bvh, &primitives, &settings] ()
+                    {
+                        rebuilt_bvh = std::make_unique<bvh_acceleration_structure>(primitives, settings);
+                    }, 1
+                )};
+
+                std::cout << "bvh room refit (" << (builder == bvh_builder::sah ? "sah" : "lbvh") << ") frame " << frame
+                    << std::setprecision(3) << ": update " << update_seconds * 1e3 << " ms, sah cost " << bvh.get_sah_cost()
+                    << ", rebuild " << build_seconds * 1e3 << " ms, sah cost " << rebuilt_bvh->get_sah_cost() << std::endl;
+            }
+        }
+    }
+
+    // binary search over the cdf against the alias table, for tables from the size of a mesh light to that of an
+    // environment map and beyond; the weights are skewed like the areas of a tessellated mesh
+    inline void benchmark_distribution_sampling()
+    {
+        constexpr std::size_t sample_count{1 << 22};
+
+        pcg32 generator{};
+        std::uniform_real_distribution<double> distribution{};
+
+        std::vector<double> us(sample_count);
+        for(double& u : us)
+        {
+            u = distribution(generator);
+        }
+
+        for(std::size_t size : {std::size_t{1000}, std::size_t{10000}, std::size_t{100000}, std::size_t{1000000}, std::size_t{10000000}})
+        {
+            std::vector<double> function(size);
+            for(double& f : function)
+            {
+                double x{distribution(generator)};
+                f = x * x * x * x;
+            }
+
+            auto run{[&] (std::string const& name, auto const& d)
+            {
+                double sum{};
+                double discrete_seconds{benchmark_run(
+                    [&d, &us, &sum] ()
+                    {
+                        for(double u : us)
+                        {
+                            auto sample{d.sample_discrete(u)};
+                            sum += sample.pdf_index;
+                        }
+                    }, 3
+                )};
+
+                double continuous_seconds{benchmark_run(
+                    [&d, &us, &sum] ()
+                    {
+                        for(double u : us)
+                        {
+                            auto sample{d.sample_continuous(u)};
+                            sum += sample.x;
+                        }
+                    }, 3
+                )};
+
+                benchmark_report(name + " " + std::to_string(size) + " discrete", discrete_seconds, sample_count);
+                benchmark_report(name + " " + std::to_string(size) + " continuous", continuous_seconds, sample_count);
+                std::cout << "  checksum " << std::setprecision(6) << sum << std::endl;
+            }};
+
+            std::unique_ptr<distribution_1d> cdf{};
+            std::unique_ptr<alias_distribution_1d> alias{};
+            double cdf_build_seconds{benchmark_run([&cdf, &function] () { cdf.reset(new distribution_1d{function}); }, 1)};
+            double alias_build_seconds{benchmark_run([&alias, &function] () { alias.reset(new alias_distribution_1d{function}); }, 1)};
+
+            run("distribution cdf", *cdf);
+            run("distribution alias", *alias);
+            std::cout << "  build cdf " << std::setprecision(3) << cdf_build_seconds * 1e3 << " ms, alias " << alias_build_seconds * 1e3 << " ms" << std::endl;
+        }
+    }
+
+    // rms error of per pixel estimates of integrals with known values, a discontinuous one over the first dimension
+    // and a product over three, across pixels as independent trials; the error of the disk averaged over blocks of
+    // 2x2 pixels is low when neighbouring pixels have errors of opposite signs, as with blue noise
+    inline void benchmark_sampler_convergence()
+    {
+        constexpr int resolution{32};
+        constexpr int pixel_count{resolution * resolution};
+
+        auto disk{[] (vector2 const& u) { return u.x * u.x + u.y * u.y < 1.0 ? 1.0 : 0.0; }};
+        auto product{[&disk] (vector2 const& u0, vector2 const& u1, vector2 const& u2) { return disk(u0) * 4.0 * u1.x * u1.y * (u2.x + u2.y); }};
+
+        auto run{[&] (std::string const& name, sampler_source& sampler)
+        {
+            int sample_count{sampler.get_sample_count()};
+            std::vector<double> disk_errors(pixel_count);
+            double product_error{};
+            for(int i{}; i < pixel_count; ++i)
+            {
+                double disk_sum{};
+                double product_sum{};
+                for(int j{}; j < sample_count; ++j)
+                {
+                    sampler.set_sample({i % resolution, i / resolution}, j);
+                    vector2 u0{sampler.get()};
+                    vector2 u1{sampler.get()};
+                    vector2 u2{sampler.get()};
+                    disk_sum += disk(u0);
+                    product_sum += product(u0, u1, u2);
+                }
+
+                disk_errors[i] = disk_sum / sample_count - math::pi / 4.0;
+                product_error += sqr(product_sum / sample_count - math::pi / 4.0);
+            }
+
+            double disk_error{};
+            double block_error{};
+            for(int i{}; i < pixel_count; ++i)
+            {
+                disk_error += sqr(disk_errors[i]);
+
+                int x{i % resolution};
+                int y{i / resolution};
+                if(x % 2 == 0 && y % 2 == 0)
+                {
+                    block_error += sqr((disk_errors[i] + disk_errors[i + 1] + disk_errors[i + resolution] + disk_errors[i + resolution + 1]) / 4.0);
+                }
+            }
+
+            std::cout << std::setfill(' ') << std::left << std::setw(24) << name << std::right << std::setw(6) << sample_count << " spp"
+                << std::scientific << std::setprecision(2) << "  rmse disk " << std::sqrt(disk_error / pixel_count)
+                << ", disk 2x2 " << std::sqrt(block_error / (pixel_count / 4)) << ", product " << std::sqrt(product_error / pixel_count)
+                << std::defaultfloat << std::endl;
+        }};
+
+        for(int sample_count : {4, 16, 64, 256, 1024})
+        {
+            random_sampler random{sample_count};
+            stratified_sampler stratified{sample_count};
+            sobol_sampler sobol{sample_count};
+            blue_noise_sampler blue_noise{sample_count};
+            run("random", random);
+            run("stratified", stratified);
+            run("sobol", sobol);
+            run("blue noise", blue_noise);
+        }
+    }
+
+    // values per pixel sample as a path of depth 8 would draw them, one virtual get() at a time or in one batch
+    inline void benchmark_sampler_throughput()
+    {
+        constexpr int pixel_count{256 * 256};
+        constexpr int dimension_count{24};
+
+        auto run{[] (std::string const& name, sampler_source const& prototype)
+        {
+            // a clone like the renderer's, so the calls stay virtual
+            std::unique_ptr<sampler_source> source{prototype.clone()};
+            sampler_source& sampler{*source};
+            int sample_count{sampler.get_sample_count()};
+            std::size_t value_count{static_cast<std::size_t>(pixel_count) * sample_count * dimension_count};
+
+            double sum{};
+            double get_seconds{benchmark_run(
+                [&sampler, &sum, sample_count] ()
+                {
+                    for(int i{}; i < pixel_count; ++i)
+                    {
+                        for(int j{}; j < sample_count; ++j)
+                        {
+                            sampler.set_sample({i % 256, i / 256}, j);
+                            for(int k{}; k < dimension_count; ++k)
+                            {
+                                vector2 value{sampler.get()};
+                                sum += value.x + value.y;
+                            }
+                        }
+                    }
+                }, 3
+            )};
+
+            std::array<vector2, dimension_count> values{};
+            double batch_seconds{benchmark_run(
+                [&sampler, &sum, &values, sample_count] ()
+                {
+                    for(int i{}; i < pixel_count; ++i)
+                    {
+                        for(int j{}; j < sample_count; ++j)
+                        {
+                            sampler.set_sample({i % 256, i / 256}, j);
+                            sampler.get_batch(values);
+                            for(vector2 const& value : values)
+                            {
+                                sum += value.x + value.y;
+                            }
+                        }
+                    }
+                }, 3
+            )};
+
+            benchmark_report(name + " get", get_seconds, value_count);
+            benchmark_report(name + " get_batch", batch_seconds, value_count);
+            std::cout << "  checksum " << sum << std::endl;
+        }};
+
+        random_sampler random{4};
+        stratified_sampler stratified{4};
+        sobol_sampler sobol{4};
+        blue_noise_sampler blue_noise{4};
+        run("sampler random", random);
+        run("sampler stratified", stratified);
+        run("sampler sobol", sobol);
+        run("sampler blue noise", blue_noise);
+    }
+
+    // time against rms error to a reference for each mode of the russian roulette, in a closed room where paths only
+    // end at the maximum length; the efficiency mode pays for its coarse estimate render
+    inline void benchmark_russian_roulette()
+    {
+        vector2i resolution{48, 48};
+        constexpr int max_path_length{20};
+
+        auto white{std::make_shared<diffuse_material>(std::make_shared<const_texture_2d_rgb>(vector3{0.8, 0.8, 0.8}), nullptr)};
+        std::vector<entity> entities{};
+        entities.push_back({std::make_shared<plane_surface>(pr_transform{{10.0, 0.0, 10.0}}, vector2{20.0, 20.0}), white});
+        entities.push_back({std::make_shared<plane_surface>(pr_transform{{10.0, 8.0, 10.0}, {math::deg_to_rad(180.0), 0.0, 0.0}}, vector2{20.0, 20.0}), white});
+        entities.push_back({std::make_shared<plane_surface>(pr_transform{{10.0, 4.0, 0.0}, {math::deg_to_rad(90.0), 0.0, 0.0}}, vector2{20.0, 8.0}), white});
+        entities.push_back({std::make_shared<plane_surface>(pr_transform{{10.0, 4.0, 20.0}, {math::deg_to_rad(-90.0), 0.0, 0.0}}, vector2{20.0, 8.0}), white});
+        entities.push_back({std::make_shared<plane_surface>(pr_transform{{0.0, 4.0, 10.0}, {0.0, 0.0, math::deg_to_rad(-90.0)}}, vector2{8.0, 20.0}), white});
+        entities.push_back({std::make_shared<plane_surface>(pr_transform{{20.0, 4.0, 10.0}, {0.0, 0.0, math::deg_to_rad(90.0)}}, vector2{8.0, 20.0}), white});
+        for(int i{}; i < 5; ++i)
+        {
+            entities.push_back({std::make_shared<sphere_surface>(pr_transform{{4.0 + 3.0 * i, 1.5, 8.0 + 2.0 * (i % 2)}}, 1.5), white});
+        }
+
+        auto light_surface{std::make_shared<plane_surface>(pr_transform{{10.0, 7.9, 10.0}, {math::deg_to_rad(180.0), 0.0, 0.0}}, vector2{2.0, 2.0})};
+        entities.push_back({
+            light_surface,
+            std::make_shared<diffuse_material>(std::make_shared<const_texture_2d_rgb>(vector3{0.0, 0.0, 0.0}), nullptr),
+            std::make_shared<const_diffuse_area_light>(light_surface.get(), vector3{1.0, 1.0, 1.0}, 50.0)
+        });
+
+        bvh_acceleration_structure_factory acceleration_structure_factory{};
+        uniform_light_distribution_factory uldf{};
+        uniform_spatial_light_distribution_factory usldf{};
+        auto scene{std::make_shared<entity_scene>(std::move(entities), nullptr, acceleration_structure_factory, uldf, usldf)};
+
+        perspective_camera_factory camera_factory{{{10.0, 4.0, 1.0}, {math::deg_to_rad(10.0), 0.0, 0.0}}, math::deg_to_rad(70.0)};
+
+        auto render{[&] (russian_roulette const& russian_roulette, int sample_count, std::vector<double> pixel_estimates, double* seconds)
+        {
+            stratified_sampler sampler{sample_count};
+            auto integrator{std::make_shared<forward_mis_integrator>(max_path_length, false, russian_roulette)};
+            renderer renderer{resolution, camera_factory, integrator, scene, 1, sampler};
+            renderer.set_pixel_estimates(std::move(pixel_estimates));
+
+            auto start_time{std::chrono::high_resolution_clock::now()};
+            for(int y{}; y < resolution.y; ++y)
+            {
+                for(int x{}; x < resolution.x; ++x)
+                {
+                    renderer.run_pixel({x, y});
+                }
+            }
+            *seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
+            return renderer;
+        }};
+
+        double reference_seconds{};
+        std::vector<vector3> reference{render({russian_roulette_mode::none}, 1024, {}, &reference_seconds).get_image()};
+
+        double none_cost{};
+        for(russian_roulette_mode mode : {russian_roulette_mode::none, russian_roulette_mode::throughput, russian_roulette_mode::efficiency})
+        {
+            double seconds{};
+            std::vector<double> pixel_estimates{};
+            if(mode == russian_roulette_mode::efficiency)
+            {
+                pixel_estimates = render({russian_roulette_mode::throughput}, 4, {}, &seconds).get_pixel_estimates();
+            }
+
+            double render_seconds{};
+            std::vector<vector3> image{render({mode}, 64, std::move(pixel_estimates), &render_seconds).get_image()};
+            seconds += render_seconds;
+
+            double error{};
+            for(std::size_t i{}; i < image.size(); ++i)
+            {
+                error += sqr(luminance(image[i] - reference[i]));
+            }
+            error /= static_cast<double>(image.size());
+
+            // the time to reach the error of none is proportional to time times the mean squared error
+            double cost{seconds * error};
+            if(mode == russian_roulette_mode::none) none_cost = cost;
+
+            std::string name{mode == russian_roulette_mode::none ? "none" : mode == russian_roulette_mode::throughput ? "throughput" : "efficiency"};
+            std::cout << std::setfill(' ') << "russian roulette " << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(2)
+                << seconds << " s, rmse " << std::scientific << std::sqrt(error) << std::fixed << ", time to equal error " << cost / none_cost
+                << std::defaultfloat << std::endl;
+        }
+    }
+
+    // a floor lit by hundreds of small lights of different colors and a ribbon of emissive triangles facing its center,
+    // where picking lights uniformly wastes most samples on lights far away or facing elsewhere; all of them hang above
+    // the camera, so the error is that of their light and not of their edges
+    inline void benchmark_many_lights()
+    {
+        vector2i resolution{128, 96};
+        constexpr int max_path_length{4};
+
+        auto white{std::make_shared<diffuse_material>(std::make_shared<const_texture_2d_rgb>(vector3{0.8, 0.8, 0.8}), nullptr)};
+        auto black{std::make_shared<diffuse_material>(std::make_shared<const_texture_2d_rgb>(vector3{0.0, 0.0, 0.0}), nullptr)};
+
+        std::vector<entity> entities{};
+        entities.push_back({std::make_shared<plane_surface>(pr_transform{{0.0, 0.0, 0.0}}, vector2{40.0, 40.0}), white});
+
+        pcg32 generator{};
+        std::uniform_real_distribution<double> distribution{};
+        for(int i{}; i < 10; ++i)
+        {
+            entities.push_back({std::make_shared<sphere_surface>(pr_transform{{distribution(generator) * 20.0 - 10.0, 1.0, distribution(generator) * 20.0 - 10.0}}, 1.0), white});
+        }
+
+        for(int i{}; i < 500; ++i)
+        {
+            vector3 position{distribution(generator) * 36.0 - 18.0, 2.5 + distribution(generator) * 1.5, distribution(generator) * 36.0 - 18.0};
+            vector3 color{distribution(generator), distribution(generator), distribution(generator)};
+            auto light_surface{std::make_shared<sphere_surface>(pr_transform{position}, 0.05 + 0.1 * distribution(generator))};
+            entities.push_back({light_surface, black, std::make_shared<const_diffuse_area_light>(light_surface.get(), color, 40.0)});
+        }
+
+        // a quarter of a cylinder around the center facing inwards, 256 by 2 quads
+        constexpr std::uint32_t ribbon_columns{256};
+        std::uint32_t ribbon_vertex_count{(ribbon_columns + 1) * 3};
+        std::unique_ptr<vector3f[]> ribbon_positions{new vector3f[ribbon_vertex_count]};
+        std::unique_ptr<vector3f[]> ribbon_normals{new vector3f[ribbon_vertex_count]};
+        std::unique_ptr<vector2f[]> ribbon_uvs{new vector2f[ribbon_vertex_count]};
+        for(std::uint32_t i{}; i <= ribbon_columns; ++i)
+        {
+            float angle{mathf::pi * 0.5f * static_cast<float>(i) / static_cast<float>(ribbon_columns)};
+            for(std::uint32_t j{}; j < 3; ++j)
+            {
+                std::uint32_t vertex{i * 3 + j};
+                ribbon_positions[vertex] = {8.0f * std::cos(angle), 2.5f + static_cast<float>(j), 8.0f * std::sin(angle)};
+                ribbon_normals[vertex] = {-std::cos(angle), 0.0f, -std::sin(angle)};
+                ribbon_uvs[vertex] = {static_cast<float>(i) / static_cast<float>(ribbon_columns), static_cast<float>(j) * 0.5f};
+            }
+        }
+        std::uint32_t ribbon_index_count{ribbon_columns * 2 * 6};
+        std::unique_ptr<std::uint32_t[]> ribbon_indices{new std::uint32_t[ribbon_index_count]};
+        for(std::uint32_t i{}; i < ribbon_columns; ++i)
+        {
+            for(std::uint32_t j{}; j < 2; ++j)
+            {
+                std::uint32_t a{i * 3 + j};
+                std::uint32_t first{(i * 2 + j) * 6};
+                std::uint32_t quad[]{a, a + 4, a + 1, a, a + 3, a + 4};
+                std::copy(std::begin(quad), std::end(quad), ribbon_indices.get() + first);
+            }
+        }
+        auto ribbon_mesh{std::make_shared<default_mesh>(ribbon_vertex_count, std::move(ribbon_positions), std::move(ribbon_normals), std::move(ribbon_uvs),
+            ribbon_index_count, std::move(ribbon_indices))};
+        auto ribbon_surface{std::make_shared<mesh_surface>(prs_transform{}, ribbon_mesh)};
+        entities.push_back({ribbon_surface, black, std::make_shared<const_diffuse_area_light>(ribbon_surface.get(), vector3{1.0, 0.6, 0.3}, 4.0)});
+
+        bvh_acceleration_structure_factory acceleration_structure_factory{};
+        uniform_light_distribution_factory uldf{};
+        uniform_spatial_light_distribution_factory usldf{};
+        power_spatial_light_distribution_factory psldf{};
+        bvh_spatial_light_distribution_factory bsldf{};
+        std::pair<std::string, std::shared_ptr<entity_scene>> scenes[]{
+            {"uniform", std::make_shared<entity_scene>(entities, nullptr, acceleration_structure_factory, uldf, usldf)},
+            {"power", std::make_shared<entity_scene>(entities, nullptr, acceleration_structure_factory, uldf, psldf)},
+            {"bvh", std::make_shared<entity_scene>(std::move(entities), nullptr, acceleration_structure_factory, uldf, bsldf)}
+        };
+
+        perspective_camera_factory camera_factory{{{0.0, 2.0, -16.0}, {math::deg_to_rad(30.0), 0.0, 0.0}}, math::deg_to_rad(50.0)};
+
+        auto render{[&] (std::shared_ptr<entity_scene> const& scene, int sample_count, double* seconds)
+        {
+            random_sampler sampler{sample_count};
+            auto integrator{std::make_shared<forward_mis_integrator>(max_path_length, false)};
+            renderer renderer{resolution, camera_factory, integrator, scene, 1, sampler};
+
+            auto start_time{std::chrono::high_resolution_clock::now()};
+            for(int y{}; y < resolution.y; ++y)
+            {
+                for(int x{}; x < resolution.x; ++x)
+                {
+                    renderer.run_pixel({x, y});
+                }
+            }
+            *seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
+            return renderer.get_image();
+        }};
+
+        double reference_seconds{};
+        std::vector<vector3> reference{render(scenes[2].second, 256, &reference_seconds)};
+
+        double uniform_cost{};
+        for(auto const& [name, scene] : scenes)
+        {
+            double seconds{};
+            std::vector<vector3> image{render(scene, 16, &seconds)};
+
+            double error{};
+            for(std::size_t i{}; i < image.size(); ++i)
+            {
+                error += sqr(luminance(image[i] - reference[i]));
+            }
+            error /= static_cast<double>(image.size());
+
+            double cost{seconds * error};
+            if(name == "uniform") uniform_cost = cost;
+
+            std::cout << std::setfill(' ') << "many lights " << std::left << std::setw(8) << name << std::right << std::fixed << std::setprecision(2)
+                << seconds << " s, rmse " << std::scientific << std::sqrt(error) << std::fixed << ", time to equal error " << cost / uniform_cost
+                << std::defaultfloat << std::endl;
+        }
+    }
+}
\ No newline at end of file
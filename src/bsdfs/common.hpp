@@ -5,6 +5,12 @@
 
 namespace fc
 {
+    enum class fresnel_type
+    {
+        one,
+        dielectric
+    };
+
     inline double fr_dielectric(double cos_theta_i, double eta_i, double eta_t)
     {
         cos_theta_i = std::clamp(cos_theta_i, -1.0, 1.0);
@@ -19,6 +25,25 @@ namespace fc
         return (r_parl * r_parl + r_perp * r_perp) / 2.0;
     }
 
+    class fresnel
+    {
+    public:
+        explicit fresnel(fresnel_type type)
+            : type_{type}
+        { }
+
+        vector3 evaluate(double cos_theta_i, double eta_a, double eta_b) const
+        {
+            if(type_ == fresnel_type::one) return {1.0, 1.0, 1.0};
+
+            double a{fr_dielectric(cos_theta_i, eta_a, eta_b)};
+            return {a, a, a};
+        }
+
+    private:
+        fresnel_type type_{};
+    };
+
     inline vector3 reflect(vector3 const& w, vector3 const& n)
     {
         return -w + 2.0 * dot(w, n) * n;
@@ -1,5 +1,4 @@
 #pragma once
-#include "../core/bsdf.hpp"
 #include "../core/sampling.hpp"
 #include "../core/bxdf.hpp"
 
@@ -8,6 +7,8 @@ namespace fc
     class lambertian_reflection
     {
     public:
+        lambertian_reflection() = default;
+
         explicit lambertian_reflection(vector3 const& reflectance)
             : reflectance_{reflectance}
         { }
@@ -23,6 +24,19 @@ namespace fc
             return reflectance_ * math::inv_pi;
         }
 
+        vector3 evaluate_with_pdf(vector3 const& i, vector3 const& o, double eta_a, double eta_b, double* pdf_o, double* pdf_i) const
+        {
+            *pdf_o = 0.0;
+            *pdf_i = 0.0;
+
+            if(i.y <= 0.0 || o.y <= 0.0) return {};
+
+            *pdf_o = o.y * math::inv_pi;
+            *pdf_i = i.y * math::inv_pi;
+
+            return reflectance_ * math::inv_pi;
+        }
+
         sample_result sample(vector3 const& i, double eta_a, double eta_b, vector2 const& u1, vector2 const& u2,
             vector3* o, vector3* value, double* pdf_o, double* pdf_i) const
         {
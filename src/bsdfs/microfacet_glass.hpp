@@ -1,7 +1,6 @@
 #pragma once
 #include "../core/bxdf.hpp"
 #include "../core/microfacet.hpp"
-#include "../core/bsdf.hpp"
 #include "common.hpp"
 
 namespace fc
@@ -10,8 +9,8 @@ namespace fc
     class microfacet_glass
     {
     public:
-        explicit microfacet_glass(vector3 const& reflectance, vector3 const& transmittance, microfacet_model const& microfacet_model)
-            : reflectance_{reflectance}, transmittance_{transmittance}, microfacet_model_{&microfacet_model}
+        explicit microfacet_glass(vector3 const& reflectance, vector3 const& transmittance, smith_ggx_microfacet_model const& microfacet_model)
+            : reflectance_{reflectance}, transmittance_{transmittance}, microfacet_model_{microfacet_model}
         { }
 
         bxdf_type get_type() const
@@ -27,8 +26,8 @@ namespace fc
             {
                 vector3 h{normalize(i + o)};
 
-                double g{microfacet_model_->masking(i, o, h)};
-                double d{microfacet_model_->distribution(h)};
+                double g{microfacet_model_.masking(i, o, h)};
+                double d{microfacet_model_.distribution(h)};
                 double fresnel{fr_dielectric(dot(i, h), eta_a, eta_b)};
 
                 return reflectance_ * (g * d * fresnel / (4.0 * i.y * o.y));
@@ -52,21 +51,81 @@ namespace fc
 
                 double eta{eta_a / eta_b};
                 double jacobian{-o_dot_h / (sqr(eta * i_dot_h + o_dot_h))};
-                double g2{microfacet_model_->masking(i, o, h)};
-                double d{microfacet_model_->distribution(h)};
+                double g2{microfacet_model_.masking(i, o, h)};
+                double d{microfacet_model_.distribution(h)};
                 double fresnel{fr_dielectric(i_dot_h, eta_a, eta_b)};
 
                 return transmittance_ * (i_dot_h * g2 * d * jacobian * (1.0 - fresnel) / (i.y * -o.y));
             }
         }
 
+        vector3 evaluate_with_pdf(vector3 const& i, vector3 const& o, double eta_a, double eta_b, double* pdf_o, double* pdf_i) const
+        {
+            *pdf_o = 0.0;
+            *pdf_i = 0.0;
+
+            if(i.y == 0.0 || o.y == 0.0) return {};
+
+            if(o.y > 0.0)
+            {
+                vector3 h{normalize(i + o)};
+
+                double g{};
+                double d{};
+                double pdf_i_h{};
+                double pdf_o_h{};
+                microfacet_model_.evaluate(i, o, h, &g, &d, &pdf_i_h, &pdf_o_h);
+                double fresnel{fr_dielectric(dot(i, h), eta_a, eta_b)};
+
+                *pdf_o = pdf_i_h / (4.0 * dot(i, h)) * fresnel;
+                *pdf_i = pdf_o_h / (4.0 * dot(o, h)) * fr_dielectric(dot(o, h), eta_a, eta_b);
+
+                return reflectance_ * (g * d * fresnel / (4.0 * i.y * o.y));
+            }
+            else
+            {
+                vector3 h{normalize(-(eta_a * i + eta_b * o))};
+                if(eta_a <= eta_b)
+                {
+                    if(h.y <= 0.0) return {};
+                }
+                else
+                {
+                    if(h.y >= 0.0) return {};
+                    h = -h;
+                }
+
+                double i_dot_h{dot(i, h)};
+                double o_dot_h{dot(o, h)};
+                if(i_dot_h <= 0.0 || o_dot_h >= 0.0) return {};
+
+                double eta{eta_a / eta_b};
+                double jacobian{-o_dot_h / (sqr(eta * i_dot_h + o_dot_h))};
+
+                double g2{};
+                double d{};
+                double pdf_i_h{};
+                double pdf_o_h{};
+                microfacet_model_.evaluate(i, -o, h, &g2, &d, &pdf_i_h, &pdf_o_h);
+                double fresnel{fr_dielectric(i_dot_h, eta_a, eta_b)};
+
+                double reverse_eta{eta_b / eta_a};
+                double reverse_jacobian{i_dot_h / (sqr(reverse_eta * -o_dot_h - i_dot_h))};
+
+                *pdf_o = pdf_i_h * jacobian * (1.0 - fresnel);
+                *pdf_i = pdf_o_h * reverse_jacobian * (1.0 - fr_dielectric(-o_dot_h, eta_b, eta_a));
+
+                return transmittance_ * (i_dot_h * g2 * d * jacobian * (1.0 - fresnel) / (i.y * -o.y));
+            }
+        }
+
         sample_result sample(vector3 const& i, double eta_a, double eta_b, vector2 const& u1, vector2 const& u2,
             vector3* o, vector3* value, double* pdf_o, double* pdf_i) const
         {
             if(i.y == 0.0) return sample_result::fail;
 
             // sample half vector
-            vector3 h{microfacet_model_->sample(i, u1)};
+            vector3 h{microfacet_model_.sample(i, u1)};
 
             // check if backfacing
             double i_dot_h{dot(i, h)};
@@ -82,13 +141,13 @@ namespace fc
 
                 if(o->y <= 0.0) return sample_result::fail;
 
-                double g{microfacet_model_->masking(i, *o, h)};
-                double d{microfacet_model_->distribution(h)};
+                double g{microfacet_model_.masking(i, *o, h)};
+                double d{microfacet_model_.distribution(h)};
 
                 *value = reflectance_ * (g * d * fresnel / (4.0 * i.y * o->y));
 
                 double jacobian{1.0 / (4.0 * i_dot_h)};
-                *pdf_o = microfacet_model_->pdf(i, h) * jacobian * fresnel;
+                *pdf_o = microfacet_model_.pdf(i, h) * jacobian * fresnel;
 
                 if(pdf_i != nullptr)
                     *pdf_i = pdf(*o, i, eta_a, eta_b);
@@ -107,11 +166,11 @@ namespace fc
                 double o_dot_h(dot(*o, h));
                 double jacobian{-o_dot_h / (sqr(eta * i_dot_h + o_dot_h))};
 
-                double g2{microfacet_model_->masking(i, *o, h)};
-                double d{microfacet_model_->distribution(h)};
+                double g2{microfacet_model_.masking(i, *o, h)};
+                double d{microfacet_model_.distribution(h)};
                 *value = transmittance_ * (i_dot_h * g2 * d * jacobian * (1.0 - fresnel) / (i.y * -o->y));
 
-                *pdf_o = microfacet_model_->pdf(i, h) * jacobian * (1.0 - fresnel);
+                *pdf_o = microfacet_model_.pdf(i, h) * jacobian * (1.0 - fresnel);
 
                 if(pdf_i != nullptr)
                     *pdf_i = pdf(-*o, -i, eta_b, eta_a);
@@ -132,7 +191,7 @@ namespace fc
                 double fresnel{fr_dielectric(i_dot_h, eta_a, eta_b)};
                 double jacobian{1.0 / (4.0 * dot(i, h))};
 
-                return microfacet_model_->pdf(i, h) * jacobian * fresnel;
+                return microfacet_model_.pdf(i, h) * jacobian * fresnel;
             }
             else
             {
@@ -155,14 +214,13 @@ namespace fc
                 double fresnel{fr_dielectric(i_dot_h, eta_a, eta_b)};
                 double jacobian{-o_dot_h / (sqr(eta * i_dot_h + o_dot_h))};
 
-                return microfacet_model_->pdf(i, h) * jacobian * (1.0 - fresnel);
+                return microfacet_model_.pdf(i, h) * jacobian * (1.0 - fresnel);
             }
         }
 
     private:
         vector3 reflectance_{};
         vector3 transmittance_{};
-        vector2 alpha_{};
-        microfacet_model const* microfacet_model_{};
+        smith_ggx_microfacet_model microfacet_model_;
     };
 }
\ No newline at end of file
@@ -1,7 +1,6 @@
 #pragma once
 #include "../core/bxdf.hpp"
 #include "../core/microfacet.hpp"
-#include "../core/bsdf.hpp"
 #include "common.hpp"
 
 namespace fc
@@ -9,8 +8,8 @@ namespace fc
     class microfacet_transmission
     {
     public:
-        explicit microfacet_transmission(vector3 const& transmittance, microfacet_model const& microfacet_model)
-            : transmittance_{transmittance}, microfacet_model_{&microfacet_model}
+        explicit microfacet_transmission(vector3 const& transmittance, smith_ggx_microfacet_model const& microfacet_model)
+            : transmittance_{transmittance}, microfacet_model_{microfacet_model}
         { }
 
         bxdf_type get_type() const
@@ -39,8 +38,49 @@ namespace fc
 
             double eta{eta_a / eta_b};
             double jacobian{-o_dot_h / (sqr(eta * i_dot_h + o_dot_h))};
-            double g2{microfacet_model_->masking(i, o, h)};
-            double d{microfacet_model_->distribution(h)};
+            double g2{microfacet_model_.masking(i, o, h)};
+            double d{microfacet_model_.distribution(h)};
+
+            return transmittance_ * (i_dot_h * g2 * d * jacobian / (i.y * -o.y));
+        }
+
+        vector3 evaluate_with_pdf(vector3 const& i, vector3 const& o, double eta_a, double eta_b, double* pdf_o, double* pdf_i) const
+        {
+            *pdf_o = 0.0;
+            *pdf_i = 0.0;
+
+            if(o.y >= 0.0) return {};
+
+            vector3 h{normalize(-(eta_a * i + eta_b * o))};
+            if(eta_a <= eta_b)
+            {
+                if(h.y <= 0.0) return {};
+            }
+            else
+            {
+                if(h.y >= 0.0) return {};
+                h = -h;
+            }
+
+            double i_dot_h{dot(i, h)};
+            double o_dot_h{dot(o, h)};
+            if(i_dot_h <= 0.0 || o_dot_h >= 0.0) return {};
+
+            double eta{eta_a / eta_b};
+            double jacobian{-o_dot_h / (sqr(eta * i_dot_h + o_dot_h))};
+
+            // the reverse direction sees the same half vector from below
+            double g2{};
+            double d{};
+            double pdf_i_h{};
+            double pdf_o_h{};
+            microfacet_model_.evaluate(i, -o, h, &g2, &d, &pdf_i_h, &pdf_o_h);
+
+            double reverse_eta{eta_b / eta_a};
+            double reverse_jacobian{i_dot_h / (sqr(reverse_eta * -o_dot_h - i_dot_h))};
+
+            *pdf_o = pdf_i_h * jacobian;
+            *pdf_i = pdf_o_h * reverse_jacobian;
 
             return transmittance_ * (i_dot_h * g2 * d * jacobian / (i.y * -o.y));
         }
@@ -51,7 +91,7 @@ namespace fc
             if(i.y == 0.0) return sample_result::fail;
 
             // sample half vector
-            vector3 h{microfacet_model_->sample(i, u1)};
+            vector3 h{microfacet_model_.sample(i, u1)};
 
             // check if backfacing
             double i_dot_h{dot(i, h)};
@@ -70,11 +110,11 @@ namespace fc
             double jacobian{-o_dot_h / (sqr(eta * i_dot_h + o_dot_h))};
 
 
-            double g2{microfacet_model_->masking(i, *o, h)};
-            double d{microfacet_model_->distribution(h)};
+            double g2{microfacet_model_.masking(i, *o, h)};
+            double d{microfacet_model_.distribution(h)};
             *value = transmittance_ * (i_dot_h * g2 * d * jacobian / (i.y * -o->y));
 
-            *pdf_o = microfacet_model_->pdf(i, h) * jacobian;
+            *pdf_o = microfacet_model_.pdf(i, h) * jacobian;
 
             if(pdf_i != nullptr)
                 *pdf_i = pdf(-*o, -i, eta_b, eta_a);
@@ -104,12 +144,11 @@ namespace fc
             double eta{eta_a / eta_b};
             double jacobian{-o_dot_h / (sqr(eta * i_dot_h + o_dot_h))};
 
-            return microfacet_model_->pdf(i, h) * jacobian;
+            return microfacet_model_.pdf(i, h) * jacobian;
         }
 
     private:
         vector3 transmittance_{};
-        vector2 alpha_{};
-        microfacet_model const* microfacet_model_{};
+        smith_ggx_microfacet_model microfacet_model_;
     };
 }
\ No newline at end of file
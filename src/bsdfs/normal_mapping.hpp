@@ -144,6 +144,203 @@ namespace fc
             }
         }
 
+        // the reverse pdf pdf(o, i) uses the same lobe pairs in the opposite direction, so the inner reverse pdfs are shared too
+        vector3 evaluate_with_pdf(vector3 const& i, vector3 const& o, double eta_a, double eta_b, double* pdf_o, double* pdf_i) const
+        {
+            if(skip_)
+                return bxdf_.evaluate_with_pdf(i, o, eta_a, eta_b, pdf_o, pdf_i);
+
+            *pdf_o = 0.0;
+            *pdf_i = 0.0;
+
+
+            double i_dot_p{dot(i, p_)};
+            double i_dot_t{dot(i, t_)};
+
+            double o_dot_p{dot(o, p_)};
+            double o_dot_t{dot(o, t_)};
+
+            int ii{i_dot_p <= 0.0 ? 0 : i_dot_t > 0.0 ? 1 : 2};
+            int oo{o_dot_p <= 0.0 ? 0 : o_dot_t > 0.0 ? 1 : 2};
+
+            double sin{std::sqrt(1.0 - p_.y * p_.y)};
+            vector3 f{};
+
+            if(ii == 0)
+            {
+                if(oo != 0)
+                {
+                    vector3 ri{i - 2.0 * i_dot_t * t_};
+                    double ri_dot_p{dot(ri, p_)};
+                    double gp_ri{ri.y * p_.y / ri_dot_p};
+
+                    double pdf_ri_o{};
+                    double pdf_o_ri{};
+                    vector3 f_ri_o{bxdf_.evaluate_with_pdf(p_frame_.world_to_local(ri), p_frame_.world_to_local(o), eta_a, eta_b, &pdf_ri_o, &pdf_o_ri)};
+
+                    *pdf_o = pdf_ri_o;
+
+                    if(oo == 1)
+                    {
+                        double alpha_p_o{o_dot_p / p_.y};
+                        double alpha_t_o{o_dot_t * sin / p_.y};
+                        double lambda_p_o{alpha_p_o / (alpha_p_o + alpha_t_o)};
+
+                        f = f_ri_o * (o_dot_p / o.y);
+                        *pdf_i = lambda_p_o * pdf_o_ri * (1.0 - gp_ri);
+                    }
+                    else
+                    {
+                        double gp_o{o.y * p_.y / o_dot_p};
+
+                        f = f_ri_o * (gp_o * o_dot_p / o.y);
+                        *pdf_i = pdf_o_ri * (1.0 - gp_ri);
+                    }
+                }
+            }
+            else if(ii == 1)
+            {
+                double alpha_p_i{i_dot_p / p_.y};
+                double alpha_t_i{i_dot_t * sin / p_.y};
+                double lambda_p_i{alpha_p_i / (alpha_p_i + alpha_t_i)};
+
+                if(oo == 0)
+                {
+                    vector3 ro{o - 2.0 * o_dot_t * t_};
+
+                    double ro_dot_p{dot(ro, p_)};
+                    double gp_ro{ro.y * p_.y / ro_dot_p};
+                    double gt_o{o.y * p_.y / (o_dot_t * sin)};
+
+                    double pdf_i_ro{};
+                    double pdf_ro_i{};
+                    vector3 f_i_ro{bxdf_.evaluate_with_pdf(p_frame_.world_to_local(i), p_frame_.world_to_local(ro), eta_a, eta_b, &pdf_i_ro, &pdf_ro_i)};
+
+                    f = f_i_ro * (lambda_p_i * (1.0 - gp_ro) * gt_o * ro_dot_p / o.y);
+                    *pdf_o = lambda_p_i * pdf_i_ro * (1.0 - gp_ro);
+                    *pdf_i = pdf_ro_i;
+                }
+                else if(oo == 1)
+                {
+                    vector3 ri{i - 2.0 * i_dot_t * t_};
+                    vector3 ro{o - 2.0 * o_dot_t * t_};
+
+                    double ri_dot_p{dot(ri, p_)};
+                    double gp_ri{ri.y * p_.y / ri_dot_p};
+                    double ro_dot_p{dot(ro, p_)};
+                    double gp_ro{ro.y * p_.y / ro_dot_p};
+
+                    double alpha_p_o{o_dot_p / p_.y};
+                    double alpha_t_o{o_dot_t * sin / p_.y};
+                    double lambda_p_o{alpha_p_o / (alpha_p_o + alpha_t_o)};
+
+                    vector3 local_i{p_frame_.world_to_local(i)};
+                    vector3 local_o{p_frame_.world_to_local(o)};
+
+                    double pdf_i_o{};
+                    double pdf_o_i{};
+                    double pdf_ri_o{};
+                    double pdf_o_ri{};
+                    double pdf_i_ro{};
+                    double pdf_ro_i{};
+                    vector3 fp{bxdf_.evaluate_with_pdf(local_i, local_o, eta_a, eta_b, &pdf_i_o, &pdf_o_i)};
+                    vector3 ft{bxdf_.evaluate_with_pdf(p_frame_.world_to_local(ri), local_o, eta_a, eta_b, &pdf_ri_o, &pdf_o_ri)};
+                    vector3 fr{bxdf_.evaluate_with_pdf(local_i, p_frame_.world_to_local(ro), eta_a, eta_b, &pdf_i_ro, &pdf_ro_i)};
+
+                    f = (fp * (lambda_p_i * o_dot_p)
+                        + ft * ((1.0 - lambda_p_i) * o_dot_p)
+                        + fr * (lambda_p_i * (1.0 - gp_ro) * ro_dot_p)) / o.y;
+                    *pdf_o = lambda_p_i * pdf_i_ro * (1.0 - gp_ro)
+                        + lambda_p_i * pdf_i_o
+                        + (1.0 - lambda_p_i) * pdf_ri_o;
+                    *pdf_i = lambda_p_o * pdf_o_ri * (1.0 - gp_ri)
+                        + lambda_p_o * pdf_o_i
+                        + (1.0 - lambda_p_o) * pdf_ro_i;
+                }
+                else
+                {
+                    vector3 ri{i - 2.0 * i_dot_t * t_};
+                    double ri_dot_p{dot(ri, p_)};
+                    double gp_ri{ri.y * p_.y / ri_dot_p};
+                    double gp_o{o.y * p_.y / o_dot_p};
+
+                    vector3 local_o{p_frame_.world_to_local(o)};
+
+                    double pdf_i_o{};
+                    double pdf_o_i{};
+                    double pdf_ri_o{};
+                    double pdf_o_ri{};
+                    vector3 fp{bxdf_.evaluate_with_pdf(p_frame_.world_to_local(i), local_o, eta_a, eta_b, &pdf_i_o, &pdf_o_i)};
+                    vector3 ft{bxdf_.evaluate_with_pdf(p_frame_.world_to_local(ri), local_o, eta_a, eta_b, &pdf_ri_o, &pdf_o_ri)};
+
+                    f = (lambda_p_i * fp + (1.0 - lambda_p_i) * ft) * (o_dot_p * gp_o / o.y);
+                    *pdf_o = lambda_p_i * pdf_i_o * gp_o + (1.0 - lambda_p_i) * pdf_ri_o;
+                    *pdf_i = pdf_o_i + pdf_o_ri * (1.0 - gp_ri);
+                }
+            }
+            else
+            {
+                double gp_i{i.y * p_.y / i_dot_p};
+
+                if(oo == 0)
+                {
+                    vector3 ro{o - 2.0 * o_dot_t * t_};
+                    double ro_dot_p{dot(ro, p_)};
+                    double gp_ro{ro.y * p_.y / ro_dot_p};
+                    double gt_o{o.y * p_.y / (o_dot_t * sin)};
+
+                    double pdf_i_ro{};
+                    double pdf_ro_i{};
+                    vector3 f_i_ro{bxdf_.evaluate_with_pdf(p_frame_.world_to_local(i), p_frame_.world_to_local(ro), eta_a, eta_b, &pdf_i_ro, &pdf_ro_i)};
+
+                    f = f_i_ro * ((1.0 - gp_ro) * gt_o * ro_dot_p / o.y);
+                    *pdf_o = pdf_i_ro * (1.0 - gp_ro);
+                    *pdf_i = pdf_ro_i;
+                }
+                else if(oo == 1)
+                {
+                    vector3 ro{o - 2.0 * o_dot_t * t_};
+                    double ro_dot_p{dot(ro, p_)};
+                    double gp_ro{ro.y * p_.y / ro_dot_p};
+
+                    double alpha_p_o{o_dot_p / p_.y};
+                    double alpha_t_o{o_dot_t * sin / p_.y};
+                    double lambda_p_o{alpha_p_o / (alpha_p_o + alpha_t_o)};
+
+                    vector3 local_i{p_frame_.world_to_local(i)};
+
+                    double pdf_i_o{};
+                    double pdf_o_i{};
+                    double pdf_i_ro{};
+                    double pdf_ro_i{};
+                    vector3 fp{bxdf_.evaluate_with_pdf(local_i, p_frame_.world_to_local(o), eta_a, eta_b, &pdf_i_o, &pdf_o_i)};
+                    vector3 ft{bxdf_.evaluate_with_pdf(local_i, p_frame_.world_to_local(ro), eta_a, eta_b, &pdf_i_ro, &pdf_ro_i)};
+
+                    f = (fp * o_dot_p + ft * (1.0 - gp_ro) * ro_dot_p) / o.y;
+                    *pdf_o = pdf_i_o + pdf_i_ro * (1.0 - gp_ro);
+                    *pdf_i = lambda_p_o * pdf_o_i * gp_i + (1.0 - lambda_p_o) * pdf_ro_i;
+                }
+                else
+                {
+                    double gp_o{o.y * p_.y / o_dot_p};
+
+                    double pdf_i_o{};
+                    double pdf_o_i{};
+                    vector3 f_i_o{bxdf_.evaluate_with_pdf(p_frame_.world_to_local(i), p_frame_.world_to_local(o), eta_a, eta_b, &pdf_i_o, &pdf_o_i)};
+
+                    f = f_i_o * (gp_o * o_dot_p / o.y);
+                    *pdf_o = pdf_i_o * gp_o;
+                    *pdf_i = pdf_o_i * gp_i;
+                }
+            }
+
+            // below the surface the reverse pdf is taken from the other side with swapped media
+            if(o.y < 0.0)
+                *pdf_i = pdf(-o, -i, eta_b, eta_a);
+
+            return f;
+        }
+
         sample_result sample(vector3 const& i, double eta_a, double eta_b, vector2 const& u1, vector2 const& u2,
             vector3* o, vector3* value, double* pdf_o, double* pdf_i) const
         {
@@ -755,7 +952,7 @@ namespace fc
                 vector3 bitangent{normalize(cross(vector3{1.0, 0.0, 0.0}, p_))};
                 vector3 tangent{cross(p_, bitangent)};
 
-                p_frame_ = {tangent, p_, bitangent};
+                p_frame_ = frame{tangent, p_, bitangent};
             }
         }
     };
@@ -1,5 +1,4 @@
 #pragma once
-#include "../core/bsdf.hpp"
 #include "common.hpp"
 #include "../core/bxdf.hpp"
 
@@ -22,6 +21,14 @@ namespace fc
             return {};
         }
 
+        vector3 evaluate_with_pdf(vector3 const& i, vector3 const& o, double eta_a, double eta_b, double* pdf_o, double* pdf_i) const
+        {
+            *pdf_o = 0.0;
+            *pdf_i = 0.0;
+
+            return {};
+        }
+
         sample_result sample(vector3 const& i, double eta_a, double eta_b, vector2 const& u1, vector2 const& u2,
             vector3* o, vector3* value, double* pdf_o, double* pdf_i) const
         {
@@ -1,5 +1,4 @@
 #pragma once
-#include "../core/bsdf.hpp"
 #include "common.hpp"
 #include "../core/bxdf.hpp"
 
@@ -9,7 +8,7 @@ namespace fc
     {
     public:
         explicit specular_reflection(vector3 const& reflectance, fresnel const& fresnel, double ior)
-            : reflectance_{reflectance}, fresnel_{&fresnel}, ior_{ior}
+            : reflectance_{reflectance}, fresnel_{fresnel}, ior_{ior}
         { }
 
         bxdf_type get_type() const
@@ -22,12 +21,20 @@ namespace fc
             return {};
         }
 
+        vector3 evaluate_with_pdf(vector3 const& i, vector3 const& o, double eta_a, double eta_b, double* pdf_o, double* pdf_i) const
+        {
+            *pdf_o = 0.0;
+            *pdf_i = 0.0;
+
+            return {};
+        }
+
         sample_result sample(vector3 const& i, double eta_a, double eta_b, vector2 const& u1, vector2 const& u2,
             vector3* o, vector3* value, double* pdf_o, double* pdf_i) const
         {
             if(i.y == 0.0) return sample_result::fail;
 
-            vector3 fresnel{fresnel_->evaluate(i.y, eta_a, ior_)};
+            vector3 fresnel{fresnel_.evaluate(i.y, eta_a, ior_)};
 
             *o = {-i.x, i.y, -i.z};
             *value = fresnel * reflectance_ / o->y;
@@ -46,7 +53,7 @@ namespace fc
 
     private:
         vector3 reflectance_{};
-        fresnel const* fresnel_{};
+        fresnel fresnel_;
         double ior_{};
     };
 }
\ No newline at end of file
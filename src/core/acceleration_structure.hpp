@@ -29,6 +29,37 @@ namespace fc
         surface_point* p{};
     };
 
+    // counted by acceleration structures built with statistics, per thread, so the renderer can collect them per pixel
+    struct raycast_statistics
+    {
+        std::uint64_t ray_count{};
+        std::uint64_t node_count{};
+        std::uint64_t leaf_count{};
+        std::uint64_t primitive_test_count{};
+        std::uint64_t hit_count{};
+
+        raycast_statistics& operator+=(raycast_statistics const& b)
+        {
+            ray_count += b.ray_count;
+            node_count += b.node_count;
+            leaf_count += b.leaf_count;
+            primitive_test_count += b.primitive_test_count;
+            hit_count += b.hit_count;
+            return *this;
+        }
+
+        raycast_statistics operator-(raycast_statistics const& b) const
+        {
+            return {ray_count - b.ray_count, node_count - b.node_count, leaf_count - b.leaf_count, primitive_test_count - b.primitive_test_count, hit_count - b.hit_count};
+        }
+    };
+
+    inline raycast_statistics& get_raycast_statistics()
+    {
+        thread_local raycast_statistics statistics{};
+        return statistics;
+    }
+
     class acceleration_structure
     {
     public:
@@ -37,6 +68,9 @@ namespace fc
         virtual bounds3 get_bounds() const = 0;
         virtual std::optional<acceleration_structure_raycast_surface_point_result> raycast_surface_point(ray3 const& ray, double t_max, allocator_wrapper& allocator) const = 0;
         virtual bool raycast(ray3 const& ray, double t_max) const = 0;
+
+        // catches up with surfaces that moved their primitives, the primitives themselves stay the same
+        virtual void update() = 0;
     };
 
     class acceleration_structure_factory
@@ -104,7 +104,7 @@ struct mesh_header
 std::shared_ptr<mesh> assets::load_mesh(std::string const& name)
 {
     // read metadata
-    std::filesystem::path path{std::filesystem::current_path() / "assets" / (name + ".mesh")};
+    std::filesystem::path path{root_ / (name + ".mesh")};
     if(!std::filesystem::exists(path)) throw;
     std::ifstream fin{path, std::ios::in | std::ios::binary};
     if(!fin) throw;
@@ -162,7 +162,7 @@ std::shared_ptr<mesh> assets::load_mesh(std::string const& name)
 std::shared_ptr<image> assets::load_image(std::string const& name)
 {
     // read metadata
-    std::filesystem::path metadata_path{std::filesystem::current_path() / "assets" / "images" / (name + ".metadata")};
+    std::filesystem::path metadata_path{root_ / "images" / (name + ".metadata")};
     if(!std::filesystem::exists(metadata_path)) throw;
     std::ifstream metadata_file{metadata_path, std::ios::in};
     if(!metadata_file) throw;
@@ -173,7 +173,7 @@ std::shared_ptr<image> assets::load_image(std::string const& name)
     image_description const& description{std::get<image_description>(metadata)};
 
     // read image
-    std::filesystem::path image_path{std::filesystem::current_path() / "assets" / "images" / (name + ".asset")};
+    std::filesystem::path image_path{root_ / "images" / (name + ".asset")};
     if(!std::filesystem::exists(image_path)) throw;
 
     std::size_t expected_size{};
@@ -204,28 +204,28 @@ std::shared_ptr<image> assets::load_image(std::string const& name)
         std::vector<r8_pixel> pixels{};
         pixels.resize(static_cast<std::size_t>(description.width) * static_cast<std::size_t>(description.height));
         image_file.read(reinterpret_cast<char*>(pixels.data()), expected_size);
-        return std::shared_ptr<r8_image>{new r8_image{{description.width, description.height}, std::move(pixels)}};
+        return std::shared_ptr<r8_image>{new r8_image{{description.width, description.height}, std::move(pixels), image_layout_}};
     }
     else if(description.format == image_format::rgb8)
     {
         std::vector<rgb8_pixel> pixels{};
         pixels.resize(static_cast<std::size_t>(description.width) * static_cast<std::size_t>(description.height));
         image_file.read(reinterpret_cast<char*>(pixels.data()), expected_size);
-        return std::shared_ptr<rgb8_image>{new rgb8_image{{description.width, description.height}, std::move(pixels)}};
+        return std::shared_ptr<rgb8_image>{new rgb8_image{{description.width, description.height}, std::move(pixels), image_layout_}};
     }
     else if(description.format == image_format::srgb8)
     {
         std::vector<srgb8_pixel> pixels{};
         pixels.resize(static_cast<std::size_t>(description.width) * static_cast<std::size_t>(description.height));
         image_file.read(reinterpret_cast<char*>(pixels.data()), expected_size);
-        return std::shared_ptr<srgb8_image>{new srgb8_image{{description.width, description.height}, std::move(pixels)}};
+        return std::shared_ptr<srgb8_image>{new srgb8_image{{description.width, description.height}, std::move(pixels), image_layout_}};
     }
     else if(description.format == image_format::rgb32)
     {
         std::vector<rgb32_pixel> pixels{};
         pixels.resize(static_cast<std::size_t>(description.width) * static_cast<std::size_t>(description.height));
         image_file.read(reinterpret_cast<char*>(pixels.data()), expected_size);
-        return std::shared_ptr<rgb32_image>{new rgb32_image{{description.width, description.height}, std::move(pixels)}};
+        return std::shared_ptr<rgb32_image>{new rgb32_image{{description.width, description.height}, std::move(pixels), image_layout_}};
     }
     else
     {
@@ -1,16 +1,29 @@
 #pragma once
 #include "image.hpp"
 #include "mesh.hpp"
+#include "../textures/packed_texture.hpp"
 
+#include <filesystem>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace fc
 {
     class assets
     {
     public:
+        explicit assets(pixel_layout image_layout = pixel_layout::tiled, std::filesystem::path root = std::filesystem::current_path() / "assets")
+            : image_layout_{image_layout}, root_{std::move(root)}
+        { }
+
+        // data derived from the assets that is expensive to compute, kept with them between runs
+        std::filesystem::path get_cache_directory() const
+        {
+            return root_ / "cache";
+        }
+
         std::shared_ptr<mesh> get_mesh(std::string const& name)
         {
             auto it{meshes_.find(name)};
@@ -39,9 +52,43 @@ namespace fc
             return image;
         }
 
+        // the images packed into one texture, for materials that read them all at the same uv; images that were not
+        // loaded yet are read for packing only and not kept
+        std::shared_ptr<packed_texture_2d> get_packed_texture(std::vector<std::string> const& names, reconstruction_filter reconstruction_filter, int integral_sample_count)
+        {
+            std::string key{std::to_string(static_cast<int>(reconstruction_filter)) + ":" + std::to_string(integral_sample_count)};
+            for(std::string const& name : names)
+            {
+                key += ":" + name;
+            }
+
+            auto it{packed_textures_.find(key)};
+            if(it != packed_textures_.end())
+            {
+                return it->second;
+            }
+
+            std::vector<std::shared_ptr<image>> images{};
+            packed_texture_2d_builder builder{};
+            for(std::string const& name : names)
+            {
+                auto image_it{images_.find(name)};
+                images.push_back(image_it != images_.end() ? image_it->second : load_image(name));
+                if(builder.add(*images.back()) < 0) throw;
+            }
+
+            auto packed_texture{builder.build(reconstruction_filter, integral_sample_count)};
+            packed_textures_.insert({key, packed_texture});
+
+            return packed_texture;
+        }
+
     private:
+        pixel_layout image_layout_{};
+        std::filesystem::path root_{};
         std::unordered_map<std::string, std::shared_ptr<mesh>> meshes_{};
         std::unordered_map<std::string, std::shared_ptr<image>> images_{};
+        std::unordered_map<std::string, std::shared_ptr<packed_texture_2d>> packed_textures_{};
 
         std::shared_ptr<mesh> load_mesh(std::string const& name);
         std::shared_ptr<image> load_image(std::string const& name);
@@ -2,21 +2,118 @@
 #include "math.hpp"
 #include "sampling.hpp"
 #include "bxdf.hpp"
+#include "../bsdfs/lambertian_reflection.hpp"
+#include "../bsdfs/specular_reflection.hpp"
+#include "../bsdfs/microfacet_reflection.hpp"
+#include "../bsdfs/specular_glass.hpp"
+#include "../bsdfs/microfacet_glass.hpp"
+#include "../bsdfs/specular_transmission.hpp"
+#include "../bsdfs/microfacet_transmission.hpp"
+#include "../bsdfs/normal_mapping.hpp"
+
+#include <cassert>
+#include <type_traits>
+#include <variant>
 
 namespace fc
 {
+    // closed set of lobes stored by value, dispatched with a switch instead of virtual calls
+    class bxdf
+    {
+    public:
+        bxdf() = default;
+
+        template<typename T>
+        explicit bxdf(T const& bxdf)
+            : bxdf_{bxdf_adapter<T>{bxdf}}
+        { }
+
+        bxdf_type get_type() const
+        {
+            return visit([] (auto const& bxdf) { return bxdf.get_type(); });
+        }
+
+        vector3 evaluate(vector3 const& wo, vector3 const& wi, double eta_a, double eta_b) const
+        {
+            return visit([&] (auto const& bxdf) { return bxdf.evaluate(wo, wi, eta_a, eta_b); });
+        }
+
+        vector3 evaluate_with_pdf(vector3 const& wo, vector3 const& wi, double eta_a, double eta_b, double* pdf_wi, double* pdf_wo) const
+        {
+            return visit([&] (auto const& bxdf) { return bxdf.evaluate_with_pdf(wo, wi, eta_a, eta_b, pdf_wi, pdf_wo); });
+        }
+
+        sample_result sample_wi(vector3 const& wo, double eta_a, double eta_b, vector2 const& u1, vector2 const& u2,
+            vector3* wi, vector3* weight, double* pdf_wi, double* pdf_wo = nullptr) const
+        {
+            return visit([&] (auto const& bxdf) { return bxdf.sample_wi(wo, eta_a, eta_b, u1, u2, wi, weight, pdf_wi, pdf_wo); });
+        }
+
+        sample_result sample_wo(vector3 const& wi, double eta_a, double eta_b, vector2 const& u1, vector2 const& u2,
+            vector3* wo, vector3* weight, double* pdf_wo, double* pdf_wi = nullptr) const
+        {
+            return visit([&] (auto const& bxdf) { return bxdf.sample_wo(wi, eta_a, eta_b, u1, u2, wo, weight, pdf_wo, pdf_wi); });
+        }
+
+        double pdf_wi(vector3 const& wo, vector3 const& wi, double eta_a, double eta_b) const
+        {
+            return visit([&] (auto const& bxdf) { return bxdf.pdf_wi(wo, wi, eta_a, eta_b); });
+        }
+
+        double pdf_wo(vector3 const& wo, vector3 const& wi, double eta_a, double eta_b) const
+        {
+            return visit([&] (auto const& bxdf) { return bxdf.pdf_wo(wo, wi, eta_a, eta_b); });
+        }
+
+    private:
+        std::variant<
+            bxdf_adapter<lambertian_reflection>,
+            bxdf_adapter<specular_reflection>,
+            bxdf_adapter<microfacet_reflection>,
+            bxdf_adapter<specular_glass>,
+            bxdf_adapter<microfacet_glass>,
+            bxdf_adapter<specular_transmission>,
+            bxdf_adapter<microfacet_transmission>,
+            bxdf_adapter<normal_mapping<lambertian_reflection>>,
+            bxdf_adapter<normal_mapping<specular_reflection>>,
+            bxdf_adapter<normal_mapping<microfacet_reflection>>
+        > bxdf_{};
+
+        // std::visit goes through a table of function pointers, a plain switch lets every case inline
+        template<typename F>
+        std::invoke_result_t<F, bxdf_adapter<lambertian_reflection> const&> visit(F&& f) const
+        {
+            static_assert(std::variant_size_v<decltype(bxdf_)> == 10);
+
+            switch(bxdf_.index())
+            {
+            case 0: return f(*std::get_if<0>(&bxdf_));
+            case 1: return f(*std::get_if<1>(&bxdf_));
+            case 2: return f(*std::get_if<2>(&bxdf_));
+            case 3: return f(*std::get_if<3>(&bxdf_));
+            case 4: return f(*std::get_if<4>(&bxdf_));
+            case 5: return f(*std::get_if<5>(&bxdf_));
+            case 6: return f(*std::get_if<6>(&bxdf_));
+            case 7: return f(*std::get_if<7>(&bxdf_));
+            case 8: return f(*std::get_if<8>(&bxdf_));
+            default: return f(*std::get_if<9>(&bxdf_));
+            }
+        }
+    };
+
+
     class bsdf
     {
+    public:
         static constexpr int bxdf_capacity{4};
 
-    public:
         explicit bsdf(
             vector3 const& shading_tangent,
             vector3 const& shading_normal,
             vector3 const& shading_bitangent,
             vector3 const& geometric_normal,
             int bxdf_count,
-            bxdf const* const* bxdfs,
+            bxdf const* bxdfs,
             double const* scales,
             double const* weights)
             : shading_tangent_{shading_tangent}
@@ -56,7 +153,7 @@ namespace fc
 
         bxdf_type get_type(int bxdf) const
         {
-            return bxdfs_[bxdf].bxdf->get_type();
+            return bxdfs_[bxdf].bxdf.get_type();
         }
 
         vector3 evaluate(int bxdf, vector3 const& wo, vector3 const& wi, double eta_a, double eta_b) const
@@ -68,7 +165,27 @@ namespace fc
             if(wo_wg * wo_ws <= 0.0 || wi_wg * wi_ws <= 0.0) return {};
 
             double c{std::abs(wi_ws) * bxdfs_[bxdf].scale / (std::abs(wi_wg) * bxdfs_[bxdf].pdf)};
-            return c * bxdfs_[bxdf].bxdf->evaluate(world_to_local(wo), world_to_local(wi), eta_a, eta_b);
+            return c * bxdfs_[bxdf].bxdf.evaluate(world_to_local(wo), world_to_local(wi), eta_a, eta_b);
+        }
+
+        // evaluate and pdf_wi in one pass, optionally with pdf_wo for bidirectional methods
+        vector3 evaluate_with_pdf(int bxdf, vector3 const& wo, vector3 const& wi, double eta_a, double eta_b, double* pdf_wi, double* pdf_wo = nullptr) const
+        {
+            double local_pdf_wo{};
+            if(pdf_wo == nullptr)
+                pdf_wo = &local_pdf_wo;
+
+            *pdf_wi = 0.0;
+            *pdf_wo = 0.0;
+
+            double wo_wg{dot(wo, geometric_normal_)};
+            double wo_ws{dot(wo, shading_normal_)};
+            double wi_wg{dot(wi, geometric_normal_)};
+            double wi_ws{dot(wi, shading_normal_)};
+            if(wo_wg * wo_ws <= 0.0 || wi_wg * wi_ws <= 0.0) return {};
+
+            double c{std::abs(wi_ws) * bxdfs_[bxdf].scale / (std::abs(wi_wg) * bxdfs_[bxdf].pdf)};
+            return c * bxdfs_[bxdf].bxdf.evaluate_with_pdf(world_to_local(wo), world_to_local(wi), eta_a, eta_b, pdf_wi, pdf_wo);
         }
 
         sample_result sample_wi(int bxdf, vector3 const& wo, double eta_a, double eta_b, vector2 const& u1, vector2 const& u2,
@@ -84,7 +201,7 @@ namespace fc
                 pdf_wi = &local_pdf_wi;
 
 
-            auto result{bxdfs_[bxdf].bxdf->sample_wi(world_to_local(wo), eta_a, eta_b, u1, u2, wi, value, pdf_wi, pdf_wo)};
+            auto result{bxdfs_[bxdf].bxdf.sample_wi(world_to_local(wo), eta_a, eta_b, u1, u2, wi, value, pdf_wi, pdf_wo)};
             if(result == sample_result::success)
             {
                 *wi = local_to_world(*wi);
@@ -112,7 +229,7 @@ namespace fc
                 pdf_wo = &local_pdf_wo;
 
 
-            auto result{bxdfs_[bxdf].bxdf->sample_wo(world_to_local(wi), eta_a, eta_b, u1, u2, wo, value, pdf_wo, pdf_wi)};
+            auto result{bxdfs_[bxdf].bxdf.sample_wo(world_to_local(wi), eta_a, eta_b, u1, u2, wo, value, pdf_wo, pdf_wi)};
             if(result == sample_result::success)
             {
                 *wo = local_to_world(*wo);
@@ -137,7 +254,7 @@ namespace fc
             if(wo_wg * wo_ws <= 0.0 || wi_wg * wi_ws <= 0.0) return {};
 
 
-            return bxdfs_[bxdf].bxdf->pdf_wi(world_to_local(wo), world_to_local(wi), eta_a, eta_b);
+            return bxdfs_[bxdf].bxdf.pdf_wi(world_to_local(wo), world_to_local(wi), eta_a, eta_b);
         }
 
         double pdf_wo(int bxdf, vector3 const& wo, vector3 const& wi, double eta_a, double eta_b) const
@@ -149,7 +266,7 @@ namespace fc
             if(wo_wg * wo_ws <= 0.0 || wi_wg * wi_ws <= 0.0) return {};
 
 
-            return bxdfs_[bxdf].bxdf->pdf_wo(world_to_local(wo), world_to_local(wi), eta_a, eta_b);
+            return bxdfs_[bxdf].bxdf.pdf_wo(world_to_local(wo), world_to_local(wi), eta_a, eta_b);
         }
 
     private:
@@ -179,7 +296,7 @@ namespace fc
         int bxdf_count_{};
         struct bsdf_bxdf
         {
-            bxdf const* bxdf{};
+            bxdf bxdf{};
             double scale{};
             double pdf{};
             double weight{};
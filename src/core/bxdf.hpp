@@ -16,31 +16,14 @@ namespace fc
         delta
     };
 
-    class bxdf
-    {
-    public:
-        virtual ~bxdf() = default;
-
-        virtual bxdf_type get_type() const = 0;
-
-        virtual vector3 evaluate(vector3 const& wo, vector3 const& wi, double eta_a, double eta_b) const = 0;
-
-        virtual sample_result sample_wi(vector3 const& wo, double eta_a, double eta_b, vector2 const& u1, vector2 const& u2,
-            vector3* wi, vector3* weight, double* pdf_wi, double* pdf_wo = nullptr) const = 0;
-
-        virtual sample_result sample_wo(vector3 const& wi, double eta_a, double eta_b, vector2 const& u1, vector2 const& u2,
-            vector3* wo, vector3* weight, double* pdf_wo, double* pdf_wi = nullptr) const = 0;
-
-        virtual double pdf_wi(vector3 const& wo, vector3 const& wi, double eta_a, double eta_b) const = 0;
-
-        virtual double pdf_wo(vector3 const& wo, vector3 const& wi, double eta_a, double eta_b) const = 0;
-    };
-
-
+    // turns a lobe defined for the upper hemisphere into one defined for both,
+    // a bxdf holds one of these by value
     template<typename T>
-    class bxdf_adapter : public bxdf
+    class bxdf_adapter
     {
     public:
+        bxdf_adapter() = default;
+
         explicit bxdf_adapter(T const& bxdf)
             : bxdf_{bxdf}
         { }
@@ -49,12 +32,12 @@ namespace fc
             : bxdf_{std::move(bxdf)}
         { }
 
-        virtual bxdf_type get_type() const override
+        bxdf_type get_type() const
         {
             return bxdf_.get_type();
         }
 
-        virtual vector3 evaluate(vector3 const& wo, vector3 const& wi, double eta_a, double eta_b) const override
+        vector3 evaluate(vector3 const& wo, vector3 const& wi, double eta_a, double eta_b) const
         {
             if(wi.y >= 0.0)
             {
@@ -66,8 +49,20 @@ namespace fc
             }
         }
 
-        virtual sample_result sample_wi(vector3 const& wo, double eta_a, double eta_b, vector2 const& u1, vector2 const& u2,
-            vector3* wi, vector3* value, double* pdf_wi, double* pdf_wo = nullptr) const override
+        vector3 evaluate_with_pdf(vector3 const& wo, vector3 const& wi, double eta_a, double eta_b, double* pdf_wi, double* pdf_wo) const
+        {
+            if(wi.y >= 0.0)
+            {
+                return bxdf_.evaluate_with_pdf(wi, wo, eta_a, eta_b, pdf_wo, pdf_wi);
+            }
+            else
+            {
+                return bxdf_.evaluate_with_pdf(-wi, -wo, eta_b, eta_a, pdf_wo, pdf_wi);
+            }
+        }
+
+        sample_result sample_wi(vector3 const& wo, double eta_a, double eta_b, vector2 const& u1, vector2 const& u2,
+            vector3* wi, vector3* value, double* pdf_wi, double* pdf_wo = nullptr) const
         {
             if(wo.y >= 0.0)
             {
@@ -96,8 +91,8 @@ namespace fc
             }
         }
 
-        virtual sample_result sample_wo(vector3 const& wi, double eta_a, double eta_b, vector2 const& u1, vector2 const& u2,
-            vector3* wo, vector3* value, double* pdf_wo, double* pdf_wi = nullptr) const override
+        sample_result sample_wo(vector3 const& wi, double eta_a, double eta_b, vector2 const& u1, vector2 const& u2,
+            vector3* wo, vector3* value, double* pdf_wo, double* pdf_wi = nullptr) const
         {
             if(wi.y >= 0.0)
             {
@@ -114,7 +109,7 @@ namespace fc
             }
         }
 
-        virtual double pdf_wi(vector3 const& wo, vector3 const& wi, double eta_a, double eta_b) const override
+        double pdf_wi(vector3 const& wo, vector3 const& wi, double eta_a, double eta_b) const
         {
             if(wo.y >= 0.0)
             {
@@ -126,7 +121,7 @@ namespace fc
             }
         }
 
-        virtual double pdf_wo(vector3 const& wo, vector3 const& wi, double eta_a, double eta_b) const override
+        double pdf_wo(vector3 const& wo, vector3 const& wi, double eta_a, double eta_b) const
         {
             if(wi.y >= 0.0)
             {
@@ -139,6 +134,6 @@ namespace fc
         }
 
     private:
-        T bxdf_;
+        T bxdf_{};
     };
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include "math.hpp"
 
+#include <cstdint>
+
 namespace fc
 {
     using color8 = TVector3<std::uint8_t>;
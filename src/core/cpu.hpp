@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// x86 and x64 builds, every other target only gets the portable kernels
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define FC_X86
+#endif
+
+#if defined(FC_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(FC_X86)
+#include <cpuid.h>
+#endif
+
+// functions using instructions above the baseline, msvc accepts any intrinsic without a flag
+#if defined(_MSC_VER) && !defined(__clang__)
+#define FC_TARGET_AVX2
+#else
+#define FC_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace fc
+{
+    enum class cpu_isa
+    {
+        sse2,
+        avx2
+    };
+
+    inline char const* to_string(cpu_isa isa)
+    {
+        switch(isa)
+        {
+        case cpu_isa::avx2: return "avx2";
+        case cpu_isa::sse2:
+        default: return "sse2";
+        }
+    }
+
+#if defined(FC_X86)
+    inline void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int* registers)
+    {
+#if defined(_MSC_VER)
+        int r[4]{};
+        __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for(int i{}; i < 4; ++i) registers[i] = static_cast<unsigned int>(r[i]);
+#else
+        __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+    }
+
+    // register state the os saves on context switches, wide registers are useless without it
+    inline unsigned long long xgetbv0()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        unsigned int eax{};
+        unsigned int edx{};
+        __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+    }
+#endif
+
+    inline cpu_isa detect_cpu_isa()
+    {
+#if !defined(FC_X86)
+        return cpu_isa::sse2;
+#else
+        unsigned int r[4]{};
+        cpuid(0, 0, r);
+        unsigned int max_leaf{r[0]};
+        if(max_leaf < 7) return cpu_isa::sse2;
+
+        cpuid(1, 0, r);
+        bool osxsave{(r[2] & (1u << 27)) != 0};
+        bool avx{(r[2] & (1u << 28)) != 0};
+        if(!osxsave || !avx) return cpu_isa::sse2;
+
+        unsigned long long xcr0{xgetbv0()};
+        bool ymm_state{(xcr0 & 0x6) == 0x6};
+
+        cpuid(7, 0, r);
+        bool avx2{(r[1] & (1u << 5)) != 0};
+
+        if(ymm_state && avx2) return cpu_isa::avx2;
+        return cpu_isa::sse2;
+#endif
+    }
+
+    inline std::string get_environment_variable(char const* name)
+    {
+#if defined(_MSC_VER)
+        char* value{};
+        std::size_t size{};
+        if(_dupenv_s(&value, &size, name) != 0 || value == nullptr) return {};
+        std::string result{value};
+        std::free(value);
+        return result;
+#else
+        char const* value{std::getenv(name)};
+        return value != nullptr ? std::string{value} : std::string{};
+#endif
+    }
+
+    // detected once, FC_ISA=sse2|avx2 forces a lower path for comparisons
+    inline cpu_isa get_cpu_isa()
+    {
+        static cpu_isa const isa{[] ()
+        {
+            cpu_isa detected{detect_cpu_isa()};
+            cpu_isa selected{detected};
+
+            std::string forced{get_environment_variable("FC_ISA")};
+            if(!forced.empty())
+            {
+                for(cpu_isa candidate : {cpu_isa::sse2, cpu_isa::avx2})
+                {
+                    if(forced == to_string(candidate)) selected = candidate;
+                }
+
+                if(forced != to_string(selected))
+                {
+                    std::cout << "cpu: unknown FC_ISA value " << forced << std::endl;
+                }
+                else if(selected > detected)
+                {
+                    std::cout << "cpu: FC_ISA=" << forced << " is not supported by this cpu" << std::endl;
+                    selected = detected;
+                }
+            }
+
+            std::cout << "cpu: using " << to_string(selected) << " kernels (detected " << to_string(detected) << ")" << std::endl;
+            return selected;
+        }()};
+        return isa;
+    }
+}
\ No newline at end of file
@@ -115,53 +115,230 @@ namespace fc
         double function_integral_{};
     };
 
+    // the same distribution as distribution_1d, sampled in O(1) from an alias table instead of a binary search over the
+    // cdf: bin i keeps i with probability q and gives its alias otherwise, the bins are filled by pairing a cell below the
+    // mean with one above it [Vose 1991]; the remainder of u in the bin places continuous samples in their cell, but
+    // neighbouring u no longer map to neighbouring x, so stratified samples lose their stratification
+    class alias_distribution_1d
+    {
+        static constexpr double double_one_minus_epsilon{0x1.fffffffffffffp-1};
+
+    public:
+        explicit alias_distribution_1d(std::vector<double> const& function)
+        {
+            std::size_t n{function.size()};
+            bins_.resize(n);
+
+            // summed in the order of the cdf of distribution_1d, so the pdfs are the same to the last bit
+            double sum{};
+            for(std::size_t i{}; i < n; ++i)
+            {
+                sum += function[i];
+                bins_[i].function = function[i];
+            }
+            function_integral_ = sum / static_cast<double>(n);
+
+            if(function_integral_ == 0.0)
+            {
+                function_integral_ = 1.0;
+                for(bin& b : bins_)
+                {
+                    b.function = 1.0;
+                }
+            }
+
+            std::vector<double> q(n);
+            std::vector<std::uint32_t> under{};
+            std::vector<std::uint32_t> over{};
+            for(std::size_t i{}; i < n; ++i)
+            {
+                q[i] = bins_[i].function / function_integral_;
+                bins_[i].alias = static_cast<std::uint32_t>(i);
+                (q[i] < 1.0 ? under : over).push_back(static_cast<std::uint32_t>(i));
+            }
+
+            while(!under.empty() && !over.empty())
+            {
+                std::uint32_t u{under.back()};
+                std::uint32_t o{over.back()};
+                under.pop_back();
+                over.pop_back();
+
+                // the part of the mean u leaves free is taken from o
+                bins_[u].q = static_cast<float>(q[u]);
+                bins_[u].alias = o;
+                q[o] = (q[o] + q[u]) - 1.0;
+                (q[o] < 1.0 ? under : over).push_back(o);
+            }
+
+            // what is left is within rounding of the mean
+            for(std::uint32_t i : under)
+            {
+                bins_[i].q = 1.0f;
+            }
+            for(std::uint32_t i : over)
+            {
+                bins_[i].q = 1.0f;
+            }
+        }
+
+        double get_function_integral() const
+        {
+            return function_integral_;
+        }
+
+        distribution_1d_sample_continuous_result sample_continuous(double u) const
+        {
+            auto [index, du] {sample_bin(u)};
+
+            return {
+                (static_cast<double>(index) + du) / static_cast<double>(bins_.size()),
+                bins_[index].function / function_integral_,
+                index
+            };
+        }
+
+        distribution_1d_pdf_continuous_result pdf_continuous(double x) const
+        {
+            std::size_t lower_index{std::clamp(static_cast<std::size_t>(x * static_cast<double>(bins_.size())), std::size_t{0}, bins_.size() - 1)};
+
+            return {
+                bins_[lower_index].function / function_integral_,
+                lower_index
+            };
+        }
+
+        distribution_1d_sample_discrete_result sample_discrete(double u) const
+        {
+            std::size_t index{sample_bin(u).first};
+
+            return {
+                index,
+                pdf_discrete(index)
+            };
+        }
+
+        double pdf_discrete(std::size_t index) const
+        {
+            return bins_[index].function / (function_integral_ * static_cast<double>(bins_.size()));
+        }
+
+    private:
+        struct bin
+        {
+            float q{1.0f};
+            std::uint32_t alias{};
+            double function{};
+        };
+
+        std::vector<bin> bins_{};
+        double function_integral_{};
+
+        // the index and where in its cell u lands
+        std::pair<std::size_t, double> sample_bin(double u) const
+        {
+            double scaled{std::clamp(u, 0.0, double_one_minus_epsilon) * static_cast<double>(bins_.size())};
+            std::size_t i{std::min(static_cast<std::size_t>(scaled), bins_.size() - 1)};
+            double remainder{scaled - static_cast<double>(i)};
+
+            bin const& b{bins_[i]};
+            if(remainder < b.q)
+            {
+                return {i, std::min(remainder / b.q, double_one_minus_epsilon)};
+            }
+            return {b.alias, std::min((remainder - b.q) / (1.0 - b.q), double_one_minus_epsilon)};
+        }
+    };
+
     struct distribution_2d_sample_continuous_result
     {
         vector2 xy{};
         double pdf_xy{};
     };
 
+    // the conditional distributions of the rows are stored one after another in flat arrays, so a lookup touches the
+    // marginal cdf and one row of the conditional cdf instead of a separately allocated distribution per row
     class distribution_2d
     {
+        static constexpr double double_one_minus_epsilon{0x1.fffffffffffffp-1};
+
     public:
-        explicit distribution_2d(std::vector<std::vector<double>> function)
+        // function holds the rows one after another, resolution.x values each
+        distribution_2d(std::vector<double> function, vector2i const& resolution)
+            : function_{std::move(function)}, resolution_{resolution}
         {
-            x_distributions_.reserve(function.size());
-            for(std::size_t i{}; i < function.size(); ++i)
-            {
-                x_distributions_.emplace_back(new distribution_1d{std::move(function[i])});
-            }
+            std::size_t width{static_cast<std::size_t>(resolution_.x)};
+            std::size_t height{static_cast<std::size_t>(resolution_.y)};
 
-            std::vector<double> y_function{};
-            y_function.reserve(function.size());
-            for(std::size_t i{}; i < function.size(); ++i)
+            cdf_.resize(height * (width + 1));
+            row_integrals_.resize(height);
+            for(std::size_t y{}; y < height; ++y)
             {
-                y_function.push_back(x_distributions_[i]->get_function_integral());
+                double* row_function{function_.data() + y * width};
+                double* row_cdf{cdf_.data() + y * (width + 1)};
+                for(std::size_t i{1}; i <= width; ++i)
+                {
+                    row_cdf[i] = row_cdf[i - 1] + row_function[i - 1];
+                }
+
+                double row_integral{row_cdf[width] / static_cast<double>(width)};
+                if(row_integral != 0.0)
+                {
+                    for(std::size_t i{1}; i <= width; ++i)
+                    {
+                        row_cdf[i] /= static_cast<double>(width) * row_integral;
+                    }
+                }
+                else
+                {
+                    row_integral = 1.0;
+                    for(std::size_t i{1}; i <= width; ++i)
+                    {
+                        row_function[i - 1] = 1.0;
+                        row_cdf[i] = static_cast<double>(i) / static_cast<double>(width);
+                    }
+                }
+                row_integrals_[y] = row_integral;
             }
-            y_distribution_.reset(new distribution_1d{std::move(y_function)});
+
+            y_distribution_.reset(new distribution_1d{row_integrals_});
         }
 
         distribution_2d_sample_continuous_result sample_continuous(vector2 const& u) const
         {
             auto sample_y{y_distribution_->sample_continuous(u.y)};
-            auto sample_x{x_distributions_[sample_y.index]->sample_continuous(u.x)};
+
+            std::size_t width{static_cast<std::size_t>(resolution_.x)};
+            double const* row_function{function_.data() + sample_y.index * width};
+            double const* row_cdf{cdf_.data() + sample_y.index * (width + 1)};
+
+            double ux{std::clamp(u.x, 0.0, double_one_minus_epsilon)};
+            std::size_t upper_index{static_cast<std::size_t>(std::upper_bound(row_cdf, row_cdf + width + 1, ux) - row_cdf)};
+            std::size_t lower_index{upper_index - 1};
+
+            double dx{(ux - row_cdf[lower_index]) / (row_cdf[upper_index] - row_cdf[lower_index])};
 
             return {
-                {sample_x.x, sample_y.x},
-                sample_x.pdf_x * sample_y.pdf_x
+                {(static_cast<double>(lower_index) + dx) / static_cast<double>(width), sample_y.x},
+                row_function[lower_index] / row_integrals_[sample_y.index] * sample_y.pdf_x
             };
         }
 
         double pdf_continuous(vector2 const& xy) const
         {
             auto pdf_y{y_distribution_->pdf_continuous(xy.y)};
-            auto pdf_x{x_distributions_[pdf_y.index]->pdf_continuous(xy.x)};
 
-            return pdf_x.pdf_x * pdf_y.pdf_x;
+            std::size_t width{static_cast<std::size_t>(resolution_.x)};
+            std::size_t x{std::clamp(static_cast<std::size_t>(xy.x * static_cast<double>(width)), std::size_t{0}, width - 1)};
+
+            return function_[pdf_y.index * width + x] / row_integrals_[pdf_y.index] * pdf_y.pdf_x;
         }
 
     private:
-        std::vector<std::unique_ptr<distribution_1d>> x_distributions_{};
+        std::vector<double> function_{};
+        std::vector<double> cdf_{};
+        std::vector<double> row_integrals_{};
+        vector2i resolution_{};
         std::unique_ptr<distribution_1d> y_distribution_{};
     };
 }
\ No newline at end of file
@@ -3,6 +3,72 @@
 
 namespace fc
 {
+    enum class pixel_layout
+    {
+        linear,
+        tiled
+    };
+
+    // where the pixels of an image of the given resolution and layout are stored, shared by everything that keeps
+    // pixels in an image layout
+    class pixel_indexer
+    {
+    public:
+        // 8x8 tiles, so a bilinear footprint usually stays within one or two cache lines
+        static constexpr int tile_size_log2{3};
+        static constexpr int tile_size{1 << tile_size_log2};
+
+        pixel_indexer() = default;
+        pixel_indexer(vector2i const& resolution, pixel_layout layout)
+            : resolution_{resolution}, layout_{layout}
+            , tile_count_x_{static_cast<std::size_t>((resolution.x + tile_size - 1) >> tile_size_log2)}
+        { }
+
+        vector2i get_resolution() const
+        {
+            return resolution_;
+        }
+
+        pixel_layout get_layout() const
+        {
+            return layout_;
+        }
+
+        std::size_t get_pixel_index(vector2i const& pixel) const
+        {
+            if(layout_ == pixel_layout::linear)
+            {
+                return static_cast<std::size_t>(resolution_.x) * static_cast<std::size_t>(pixel.y) + static_cast<std::size_t>(pixel.x);
+            }
+
+            std::size_t tile{tile_count_x_ * static_cast<std::size_t>(pixel.y >> tile_size_log2) + static_cast<std::size_t>(pixel.x >> tile_size_log2)};
+            std::size_t offset{static_cast<std::size_t>(((pixel.y & (tile_size - 1)) << tile_size_log2) | (pixel.x & (tile_size - 1)))};
+            return (tile << (2 * tile_size_log2)) | offset;
+        }
+
+        // tiles are stored whole, so the pixels of a tiled image are padded to a multiple of the tile size
+        std::size_t get_storage_size() const
+        {
+            if(layout_ == pixel_layout::linear)
+            {
+                return static_cast<std::size_t>(resolution_.x) * static_cast<std::size_t>(resolution_.y);
+            }
+
+            std::size_t tile_count_y{static_cast<std::size_t>((resolution_.y + tile_size - 1) >> tile_size_log2)};
+            return tile_count_x_ * tile_count_y << (2 * tile_size_log2);
+        }
+
+        bool operator==(pixel_indexer const& b) const
+        {
+            return resolution_.x == b.resolution_.x && resolution_.y == b.resolution_.y && layout_ == b.layout_;
+        }
+
+    private:
+        vector2i resolution_{};
+        pixel_layout layout_{};
+        std::size_t tile_count_x_{};
+    };
+
     class image
     {
     public:
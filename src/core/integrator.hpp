@@ -10,6 +10,53 @@
 
 namespace fc
 {
+    enum class russian_roulette_mode
+    {
+        none,
+        throughput,
+        efficiency
+    };
+
+    // from min_path_length segments on, a path goes on with a probability q and divides its throughput by q, which
+    // keeps the estimate unbiased; throughput makes q the largest component of the throughput relative to the first
+    // vertex, efficiency divides that by the estimate of the pixel relative to the mean of the image, so that paths
+    // of bright pixels, to which they add little, end sooner than those of dark ones [Vorba and Krivanek 2016];
+    // paths without a pixel estimate fall back to throughput, and q is not allowed above one, the integrators do not
+    // split paths
+    struct russian_roulette
+    {
+        russian_roulette_mode mode{russian_roulette_mode::throughput};
+        int min_path_length{3};
+
+        // the factor the throughput of a path with path_length segments is scaled by when it goes on, zero when it
+        // ends; every call but with mode none uses one dimension, so the dimensions stay aligned across paths
+        double roll(sampler& sampler, int path_length, vector3 const& beta, vector3 const& start_beta, double pixel_estimate) const
+        {
+            if(mode == russian_roulette_mode::none) return 1.0;
+
+            double u{sampler.get().x};
+            if(path_length < min_path_length) return 1.0;
+
+            double start{max_component(start_beta)};
+            if(start <= 0.0) return 1.0;
+
+            double q{max_component(beta) / start};
+            if(mode == russian_roulette_mode::efficiency && pixel_estimate > 0.0)
+            {
+                q /= pixel_estimate;
+            }
+
+            if(q >= 1.0) return 1.0;
+            return u < q ? 1.0 / q : 0.0;
+        }
+
+        int get_dimension_count() const
+        {
+            return mode == russian_roulette_mode::none ? 0 : 1;
+        }
+    };
+
+
     class integrator
     {
     public:
@@ -0,0 +1,365 @@
+#pragma once
+#include "math.hpp"
+#include "cpu.hpp"
+
+#if defined(FC_X86)
+#include <immintrin.h>
+#endif
+
+namespace fc
+{
+    // ray data laid out for the box kernels, the fourth lane is padding
+    struct bounds_ray
+    {
+        explicit bounds_ray(ray3 const& ray)
+            : origin{ray.origin.x, ray.origin.y, ray.origin.z, 0.0}
+            , inv_dir{1.0 / ray.direction.x, 1.0 / ray.direction.y, 1.0 / ray.direction.z, 0.0}
+        { }
+
+        alignas(32) double origin[4];
+        alignas(32) double inv_dir[4];
+    };
+
+    static constexpr int triangle_packet_width{4};
+
+    // triangles stored per vertex and axis with one lane per triangle, unused lanes stay degenerate at the origin
+    struct triangle_packet
+    {
+        float vertices[3][3][triangle_packet_width]{};
+    };
+
+    // per ray setup of the watertight triangle test, the axis the ray mostly travels along becomes z
+    struct triangle_ray
+    {
+        explicit triangle_ray(ray3 const& ray)
+        {
+            kz = max_dimension(abs(ray.direction));
+            kx = kz + 1;
+            if(kx == 3) kx = 0;
+            ky = kx + 1;
+            if(ky == 3) ky = 0;
+
+            vector3 d{permute(ray.direction, kx, ky, kz)};
+            origin[0] = ray.origin[kx];
+            origin[1] = ray.origin[ky];
+            origin[2] = ray.origin[kz];
+            sx = -d.x / d.z;
+            sy = -d.y / d.z;
+            sz = 1.0 / d.z;
+        }
+
+        int kx{};
+        int ky{};
+        int kz{};
+        double origin[3]{};
+        double sx{};
+        double sy{};
+        double sz{};
+    };
+
+    struct triangle_packet_hit
+    {
+        int lane{};
+        vector3 b{};
+        double t{};
+    };
+
+    // every variant performs the same operations in the same order, so all paths give identical results;
+    // the wide ones only avoid fused multiply adds for that reason, and the portable ones take minimum and maximum
+    // with the operand order of minpd and maxpd, which return the second operand when either one is nan
+    struct kernels
+    {
+        bool (*raycast_bounds)(bounds3f const& bounds, bounds_ray const& ray, double t_max, double* t_near);
+        void (*bilinear)(float const* t00, float const* t10, float const* t01, float const* t11, double wx, double wy, int count, double* values);
+        void (*accumulate)(double* sums, double const* values, std::size_t count);
+        bool (*raycast_triangles)(triangle_packet const& packet, triangle_ray const& ray, double t_max, triangle_packet_hit* hit);
+    };
+
+    namespace kernels_sse2
+    {
+        inline double min(double a, double b)
+        {
+            return a < b ? a : b;
+        }
+
+        inline double max(double a, double b)
+        {
+            return a > b ? a : b;
+        }
+
+        inline bool raycast_bounds(bounds3f const& bounds, bounds_ray const& ray, double t_max, double* t_near)
+        {
+            double t_entry[3]{};
+            double t_far[3]{};
+            for(int i{}; i < 3; ++i)
+            {
+                double t_low{(bounds[0][i] - ray.origin[i]) * ray.inv_dir[i]};
+                double t_high{(bounds[1][i] - ray.origin[i]) * ray.inv_dir[i]};
+                t_entry[i] = min(t_low, t_high);
+                t_far[i] = max(t_low, t_high) * (1.0 + 2.0 * math::gamma(3));
+            }
+
+            // reduced like the wide versions, axes 0 and 2 against axis 1 and the padding lane
+            double t0{max(max(t_entry[0], t_entry[2]), max(t_entry[1], -std::numeric_limits<double>::infinity()))};
+            double t1{min(min(t_far[0], t_far[2]), min(t_far[1], std::numeric_limits<double>::infinity()))};
+            *t_near = t0;
+            return t0 <= t1 && t0 < t_max && t1 > 0.0;
+        }
+
+        inline void bilinear(float const* t00, float const* t10, float const* t01, float const* t11, double wx, double wy, int count, double* values)
+        {
+            for(int i{}; i < count; ++i)
+            {
+                double v0{t00[i] * (1.0 - wx) + t10[i] * wx};
+                double v1{t01[i] * (1.0 - wx) + t11[i] * wx};
+                values[i] = v0 * (1.0 - wy) + v1 * wy;
+            }
+        }
+
+        inline void accumulate(double* sums, double const* values, std::size_t count)
+        {
+            for(std::size_t i{}; i < count; ++i)
+            {
+                sums[i] += values[i];
+            }
+        }
+
+        // same steps as mesh_surface::intersect, one lane at a time
+        inline bool raycast_triangle(triangle_packet const& packet, int lane, triangle_ray const& ray, double t_max, triangle_packet_hit* hit)
+        {
+            double x[3]{};
+            double y[3]{};
+            double z[3]{};
+            for(int v{}; v < 3; ++v)
+            {
+                x[v] = packet.vertices[v][ray.kx][lane] - ray.origin[0];
+                y[v] = packet.vertices[v][ray.ky][lane] - ray.origin[1];
+                z[v] = packet.vertices[v][ray.kz][lane] - ray.origin[2];
+                x[v] += ray.sx * z[v];
+                y[v] += ray.sy * z[v];
+            }
+
+            double e0{x[1] * y[2] - y[1] * x[2]};
+            double e1{x[2] * y[0] - y[2] * x[0]};
+            double e2{x[0] * y[1] - y[0] * x[1]};
+
+            if((e0 < 0.0 || e1 < 0.0 || e2 < 0.0) && (e0 > 0.0 || e1 > 0.0 || e2 > 0.0)) return false;
+
+            double det{e0 + e1 + e2};
+            if(det == 0.0) return false;
+
+            for(int v{}; v < 3; ++v)
+            {
+                z[v] *= ray.sz;
+            }
+            double t_scaled{e0 * z[0] + e1 * z[1] + e2 * z[2]};
+            if(det < 0.0 && (t_scaled >= 0.0 || t_scaled < t_max * det)) return false;
+            if(det > 0.0 && (t_scaled <= 0.0 || t_scaled > t_max * det)) return false;
+
+            double inv_det{1.0 / det};
+            double t_hit{t_scaled * inv_det};
+
+            double max_zt{max(std::abs(z[0]), max(std::abs(z[1]), std::abs(z[2])))};
+            double max_xt{max(std::abs(x[0]), max(std::abs(x[1]), std::abs(x[2])))};
+            double max_yt{max(std::abs(y[0]), max(std::abs(y[1]), std::abs(y[2])))};
+            double delta_z{math::gamma(3) * max_zt};
+            double delta_x{math::gamma(5) * (max_xt + max_zt)};
+            double delta_y{math::gamma(5) * (max_yt + max_zt)};
+
+            double delta_e{2.0 * (math::gamma(2) * max_xt * max_yt + delta_y * max_xt + delta_x * max_yt)};
+            double max_e{max(std::abs(e0), max(std::abs(e1), std::abs(e2)))};
+
+            double delta_t{3.0 * (math::gamma(3) * max_e * max_zt + delta_e * max_zt + delta_z * max_e) * std::abs(inv_det)};
+            if(t_hit <= delta_t) return false;
+
+            *hit = {lane, {e0 * inv_det, e1 * inv_det, e2 * inv_det}, t_hit};
+            return true;
+        }
+
+        inline bool raycast_triangles(triangle_packet const& packet, triangle_ray const& ray, double t_max, triangle_packet_hit* hit)
+        {
+            // every lane is tested against the same t_max and the closest one is kept, like the wide versions do
+            bool found{};
+            for(int lane{}; lane < triangle_packet_width; ++lane)
+            {
+                triangle_packet_hit lane_hit{};
+                if(raycast_triangle(packet, lane, ray, t_max, &lane_hit) && (!found || lane_hit.t <= hit->t))
+                {
+                    *hit = lane_hit;
+                    found = true;
+                }
+            }
+            return found;
+        }
+    }
+
+#if defined(FC_X86)
+    namespace kernels_avx2
+    {
+        FC_TARGET_AVX2 inline bool raycast_bounds(bounds3f const& bounds, bounds_ray const& ray, double t_max, double* t_near)
+        {
+            // min xyz, and max xyz rotated out of the four floats ending at max.z
+            __m256d low{_mm256_cvtps_pd(_mm_loadu_ps(&bounds[0].x))};
+            __m128 high_floats{_mm_loadu_ps(&bounds[0].z)};
+            __m256d high{_mm256_cvtps_pd(_mm_shuffle_ps(high_floats, high_floats, _MM_SHUFFLE(0, 3, 2, 1)))};
+
+            __m256d origin{_mm256_load_pd(ray.origin)};
+            __m256d inv_dir{_mm256_load_pd(ray.inv_dir)};
+            __m256d t_low{_mm256_mul_pd(_mm256_sub_pd(low, origin), inv_dir)};
+            __m256d t_high{_mm256_mul_pd(_mm256_sub_pd(high, origin), inv_dir)};
+
+            __m256d t_entry{_mm256_blend_pd(_mm256_min_pd(t_low, t_high), _mm256_set1_pd(-std::numeric_limits<double>::infinity()), 0b1000)};
+            __m256d t_far{_mm256_mul_pd(_mm256_max_pd(t_low, t_high), _mm256_set1_pd(1.0 + 2.0 * math::gamma(3)))};
+            t_far = _mm256_blend_pd(t_far, _mm256_set1_pd(std::numeric_limits<double>::infinity()), 0b1000);
+
+            t_entry = _mm256_max_pd(t_entry, _mm256_permute2f128_pd(t_entry, t_entry, 1));
+            t_entry = _mm256_max_pd(t_entry, _mm256_permute_pd(t_entry, 0b0101));
+            t_far = _mm256_min_pd(t_far, _mm256_permute2f128_pd(t_far, t_far, 1));
+            t_far = _mm256_min_pd(t_far, _mm256_permute_pd(t_far, 0b0101));
+
+            double t0{_mm256_cvtsd_f64(t_entry)};
+            double t1{_mm256_cvtsd_f64(t_far)};
+            *t_near = t0;
+            return t0 <= t1 && t0 < t_max && t1 > 0.0;
+        }
+
+        FC_TARGET_AVX2 inline __m256d abs(__m256d v)
+        {
+            return _mm256_andnot_pd(_mm256_set1_pd(-0.0), v);
+        }
+
+        FC_TARGET_AVX2 inline __m256d max3(__m256d a, __m256d b, __m256d c)
+        {
+            return _mm256_max_pd(a, _mm256_max_pd(b, c));
+        }
+
+        FC_TARGET_AVX2 inline bool raycast_triangles(triangle_packet const& packet, triangle_ray const& ray, double t_max, triangle_packet_hit* hit)
+        {
+            __m256d zero{_mm256_setzero_pd()};
+            __m256d sx{_mm256_set1_pd(ray.sx)};
+            __m256d sy{_mm256_set1_pd(ray.sy)};
+            __m256d sz{_mm256_set1_pd(ray.sz)};
+
+            __m256d x[3];
+            __m256d y[3];
+            __m256d z[3];
+            for(int v{}; v < 3; ++v)
+            {
+                x[v] = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(packet.vertices[v][ray.kx])), _mm256_set1_pd(ray.origin[0]));
+                y[v] = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(packet.vertices[v][ray.ky])), _mm256_set1_pd(ray.origin[1]));
+                z[v] = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(packet.vertices[v][ray.kz])), _mm256_set1_pd(ray.origin[2]));
+                x[v] = _mm256_add_pd(x[v], _mm256_mul_pd(sx, z[v]));
+                y[v] = _mm256_add_pd(y[v], _mm256_mul_pd(sy, z[v]));
+            }
+
+            __m256d e0{_mm256_sub_pd(_mm256_mul_pd(x[1], y[2]), _mm256_mul_pd(y[1], x[2]))};
+            __m256d e1{_mm256_sub_pd(_mm256_mul_pd(x[2], y[0]), _mm256_mul_pd(y[2], x[0]))};
+            __m256d e2{_mm256_sub_pd(_mm256_mul_pd(x[0], y[1]), _mm256_mul_pd(y[0], x[1]))};
+
+            __m256d any_negative{_mm256_or_pd(_mm256_or_pd(_mm256_cmp_pd(e0, zero, _CMP_LT_OQ), _mm256_cmp_pd(e1, zero, _CMP_LT_OQ)), _mm256_cmp_pd(e2, zero, _CMP_LT_OQ))};
+            __m256d any_positive{_mm256_or_pd(_mm256_or_pd(_mm256_cmp_pd(e0, zero, _CMP_GT_OQ), _mm256_cmp_pd(e1, zero, _CMP_GT_OQ)), _mm256_cmp_pd(e2, zero, _CMP_GT_OQ))};
+            __m256d rejected{_mm256_and_pd(any_negative, any_positive)};
+
+            __m256d det{_mm256_add_pd(_mm256_add_pd(e0, e1), e2)};
+            rejected = _mm256_or_pd(rejected, _mm256_cmp_pd(det, zero, _CMP_EQ_OQ));
+
+            for(int v{}; v < 3; ++v)
+            {
+                z[v] = _mm256_mul_pd(z[v], sz);
+            }
+            __m256d t_scaled{_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(e0, z[0]), _mm256_mul_pd(e1, z[1])), _mm256_mul_pd(e2, z[2]))};
+            __m256d t_max_scaled{_mm256_mul_pd(_mm256_set1_pd(t_max), det)};
+            __m256d behind_or_beyond_negative{_mm256_or_pd(_mm256_cmp_pd(t_scaled, zero, _CMP_GE_OQ), _mm256_cmp_pd(t_scaled, t_max_scaled, _CMP_LT_OQ))};
+            __m256d behind_or_beyond_positive{_mm256_or_pd(_mm256_cmp_pd(t_scaled, zero, _CMP_LE_OQ), _mm256_cmp_pd(t_scaled, t_max_scaled, _CMP_GT_OQ))};
+            rejected = _mm256_or_pd(rejected, _mm256_and_pd(_mm256_cmp_pd(det, zero, _CMP_LT_OQ), behind_or_beyond_negative));
+            rejected = _mm256_or_pd(rejected, _mm256_and_pd(_mm256_cmp_pd(det, zero, _CMP_GT_OQ), behind_or_beyond_positive));
+            if(_mm256_movemask_pd(rejected) == 0b1111) return false;
+
+            __m256d inv_det{_mm256_div_pd(_mm256_set1_pd(1.0), det)};
+            __m256d t_hit{_mm256_mul_pd(t_scaled, inv_det)};
+
+            __m256d max_zt{max3(abs(z[0]), abs(z[1]), abs(z[2]))};
+            __m256d max_xt{max3(abs(x[0]), abs(x[1]), abs(x[2]))};
+            __m256d max_yt{max3(abs(y[0]), abs(y[1]), abs(y[2]))};
+            __m256d delta_z{_mm256_mul_pd(_mm256_set1_pd(math::gamma(3)), max_zt)};
+            __m256d delta_x{_mm256_mul_pd(_mm256_set1_pd(math::gamma(5)), _mm256_add_pd(max_xt, max_zt))};
+            __m256d delta_y{_mm256_mul_pd(_mm256_set1_pd(math::gamma(5)), _mm256_add_pd(max_yt, max_zt))};
+
+            __m256d delta_e{_mm256_mul_pd(_mm256_set1_pd(2.0), _mm256_add_pd(_mm256_add_pd(
+                _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(math::gamma(2)), max_xt), max_yt),
+                _mm256_mul_pd(delta_y, max_xt)),
+                _mm256_mul_pd(delta_x, max_yt)))};
+            __m256d max_e{max3(abs(e0), abs(e1), abs(e2))};
+
+            __m256d delta_t{_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(3.0), _mm256_add_pd(_mm256_add_pd(
+                _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(math::gamma(3)), max_e), max_zt),
+                _mm256_mul_pd(delta_e, max_zt)),
+                _mm256_mul_pd(delta_z, max_e))), abs(inv_det))};
+            rejected = _mm256_or_pd(rejected, _mm256_cmp_pd(t_hit, delta_t, _CMP_LE_OQ));
+
+            int mask{~_mm256_movemask_pd(rejected) & 0b1111};
+            if(mask == 0) return false;
+
+            alignas(32) double t[triangle_packet_width];
+            _mm256_store_pd(t, t_hit);
+            int lane{-1};
+            for(int i{}; i < triangle_packet_width; ++i)
+            {
+                if((mask & (1 << i)) != 0 && (lane < 0 || t[i] <= t[lane])) lane = i;
+            }
+
+            alignas(32) double b[3][triangle_packet_width];
+            _mm256_store_pd(b[0], _mm256_mul_pd(e0, inv_det));
+            _mm256_store_pd(b[1], _mm256_mul_pd(e1, inv_det));
+            _mm256_store_pd(b[2], _mm256_mul_pd(e2, inv_det));
+            *hit = {lane, {b[0][lane], b[1][lane], b[2][lane]}, t[lane]};
+            return true;
+        }
+
+        FC_TARGET_AVX2 inline void bilinear(float const* t00, float const* t10, float const* t01, float const* t11, double wx, double wy, int count, double* values)
+        {
+            __m256d wx1{_mm256_set1_pd(1.0 - wx)};
+            __m256d wx0{_mm256_set1_pd(wx)};
+            __m256d wy1{_mm256_set1_pd(1.0 - wy)};
+            __m256d wy0{_mm256_set1_pd(wy)};
+
+            int i{};
+            for(; i + 4 <= count; i += 4)
+            {
+                __m256d v0{_mm256_add_pd(_mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(t00 + i)), wx1), _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(t10 + i)), wx0))};
+                __m256d v1{_mm256_add_pd(_mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(t01 + i)), wx1), _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(t11 + i)), wx0))};
+                _mm256_storeu_pd(values + i, _mm256_add_pd(_mm256_mul_pd(v0, wy1), _mm256_mul_pd(v1, wy0)));
+            }
+            kernels_sse2::bilinear(t00 + i, t10 + i, t01 + i, t11 + i, wx, wy, count - i, values + i);
+        }
+
+        FC_TARGET_AVX2 inline void accumulate(double* sums, double const* values, std::size_t count)
+        {
+            std::size_t i{};
+            for(; i + 4 <= count; i += 4)
+            {
+                _mm256_storeu_pd(sums + i, _mm256_add_pd(_mm256_loadu_pd(sums + i), _mm256_loadu_pd(values + i)));
+            }
+            kernels_sse2::accumulate(sums + i, values + i, count - i);
+        }
+    }
+#endif
+
+    inline kernels const& get_kernels()
+    {
+        static kernels const selected{[] ()
+        {
+            switch(get_cpu_isa())
+            {
+#if defined(FC_X86)
+            case cpu_isa::avx2:
+                return kernels{kernels_avx2::raycast_bounds, kernels_avx2::bilinear, kernels_avx2::accumulate, kernels_avx2::raycast_triangles};
+#endif
+            case cpu_isa::sse2:
+            default:
+                return kernels{kernels_sse2::raycast_bounds, kernels_sse2::bilinear, kernels_sse2::accumulate, kernels_sse2::raycast_triangles};
+            }
+        }()};
+        return selected;
+    }
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "math.hpp"
 #include "surface_point.hpp"
+#include "light_bvh.hpp"
 
 #include <optional>
 
@@ -21,6 +22,19 @@ namespace fc
         virtual vector3 get_power() const = 0;
 
         virtual void set_scene_bounds(bounds3 const& bounds) = 0;
+
+        // lights without bounds, like infinity area lights, can not be ranked by their distance to a receiver
+        virtual std::optional<light_bounds> get_bounds() const
+        {
+            return {};
+        }
+
+        // the position of the light in the lights of its scene, so distributions over them find it without a search
+        std::uint32_t get_index() const { return index_; }
+        void set_index(std::uint32_t index) { index_ = index; }
+
+    private:
+        std::uint32_t index_{};
     };
 
     struct infinity_area_light_sample_wi_result
@@ -79,6 +93,12 @@ namespace fc
         virtual std::optional<standard_light_sample_p_and_wo_result> sample_p_and_wo(double sample_primitive, vector2 const& sample_point, vector2 const& sample_direction, allocator_wrapper& allocator) const = 0;
         virtual double pdf_p(surface_point const& p) const = 0;
         virtual double pdf_wo(surface_point const& p, vector3 const& wo) const = 0;
+
+        // the density of sample_p with view_point, which may favour the parts of the light that face it
+        virtual double pdf_p(surface_point const& view_point, surface_point const& p) const
+        {
+            return pdf_p(p);
+        }
     };
 
     class area_light : public standard_light
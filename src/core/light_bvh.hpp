@@ -0,0 +1,369 @@
+#pragma once
+#include "math.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+namespace fc
+{
+    // where a group of emitters is, how much it emits and in which directions: the normals lie in a cone of angle theta_o
+    // around w and every emitter sends light up to theta_e away from its normal [Conty Estevez and Kulla 2018]
+    struct light_bounds
+    {
+        bounds3f bounds{};
+        vector3f w{0.0f, 1.0f, 0.0f};
+        float phi{};
+        float cos_theta_o{1.0f};
+        float cos_theta_e{};
+        bool two_sided{};
+
+        // an upper bound, up to a constant, of the light the emitters can send to a receiver at p with normal n; never
+        // zero when they can reach it, a zero normal stands for a receiver that takes light from all directions
+        double importance(vector3 const& p, vector3 const& n) const
+        {
+            if(phi == 0.0f) return 0.0;
+
+            bounds3 b{bounds};
+            vector3 center{b.centroid()};
+            vector3 d{p - center};
+            double distance{length(d)};
+            vector3 wi{distance > 0.0 ? d / distance : vector3{}};
+            double d2{std::max(distance * distance, length(b.diagonal()) * 0.5)};
+
+            // all directions from p to the bounds lie within theta_b of the one to their center
+            double cos_theta_b{-1.0};
+            bool inside{p.x >= b.Min().x && p.y >= b.Min().y && p.z >= b.Min().z && p.x <= b.Max().x && p.y <= b.Max().y && p.z <= b.Max().z};
+            if(!inside)
+            {
+                auto [sphere_center, radius] {b.bounding_sphere()};
+                double sqr_distance{sqr_length(p - sphere_center)};
+                if(sqr_distance > radius * radius)
+                {
+                    cos_theta_b = std::sqrt(std::max(1.0 - radius * radius / sqr_distance, 0.0));
+                }
+            }
+            double sin_theta_b{std::sqrt(std::max(1.0 - cos_theta_b * cos_theta_b, 0.0))};
+
+            double cos_theta_w{dot(vector3{w}, wi)};
+            if(two_sided) cos_theta_w = std::abs(cos_theta_w);
+            double sin_theta_w{std::sqrt(std::max(1.0 - cos_theta_w * cos_theta_w, 0.0))};
+            double sin_theta_o{std::sqrt(std::max(1.0 - sqr(cos_theta_o), 0.0))};
+
+            // the smallest angle between a normal of the cone and a direction from the bounds to p
+            double cos_theta_x{cos_sub_clamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o)};
+            double sin_theta_x{sin_sub_clamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o)};
+            double cos_theta_p{cos_sub_clamped(sin_theta_x, cos_theta_x, sin_theta_b, cos_theta_b)};
+            if(cos_theta_p <= cos_theta_e) return 0.0;
+
+            double result{phi * cos_theta_p / d2};
+
+            if(n.x != 0.0 || n.y != 0.0 || n.z != 0.0)
+            {
+                double cos_theta_i{std::abs(dot(wi, n))};
+                double sin_theta_i{std::sqrt(std::max(1.0 - cos_theta_i * cos_theta_i, 0.0))};
+                result *= cos_sub_clamped(sin_theta_i, cos_theta_i, sin_theta_b, cos_theta_b);
+            }
+            return std::max(result, 0.0);
+        }
+
+    private:
+        // cos(max(0, a - b)) and sin(max(0, a - b)) from the sines and cosines of a and b
+        static double cos_sub_clamped(double sin_a, double cos_a, double sin_b, double cos_b)
+        {
+            if(cos_a > cos_b) return 1.0;
+            return cos_a * cos_b + sin_a * sin_b;
+        }
+
+        static double sin_sub_clamped(double sin_a, double cos_a, double sin_b, double cos_b)
+        {
+            if(cos_a > cos_b) return 0.0;
+            return sin_a * cos_b - cos_a * sin_b;
+        }
+    };
+
+    // bounds around both, the cone of normals is the smallest one around both cones; bounds without power are ignored
+    inline light_bounds Union(light_bounds const& a, light_bounds const& b)
+    {
+        if(a.phi == 0.0f) return b;
+        if(b.phi == 0.0f) return a;
+
+        vector3 wa{a.w};
+        vector3 wb{b.w};
+        double theta_a{std::acos(std::clamp(static_cast<double>(a.cos_theta_o), -1.0, 1.0))};
+        double theta_b{std::acos(std::clamp(static_cast<double>(b.cos_theta_o), -1.0, 1.0))};
+        vector3 axis{cross(wa, wb)};
+        double theta_d{std::atan2(length(axis), dot(wa, wb))};
+
+        light_bounds result{Union(a.bounds, b.bounds)};
+        result.phi = a.phi + b.phi;
+        result.cos_theta_e = std::min(a.cos_theta_e, b.cos_theta_e);
+        result.two_sided = a.two_sided || b.two_sided;
+
+        if(std::min(theta_d + theta_b, math::pi) <= theta_a)
+        {
+            result.w = a.w;
+            result.cos_theta_o = a.cos_theta_o;
+        }
+        else if(std::min(theta_d + theta_a, math::pi) <= theta_b)
+        {
+            result.w = b.w;
+            result.cos_theta_o = b.cos_theta_o;
+        }
+        else
+        {
+            double theta_o{(theta_a + theta_d + theta_b) * 0.5};
+            if(theta_o >= math::pi || sqr_length(axis) == 0.0)
+            {
+                result.w = a.w;
+                result.cos_theta_o = -1.0f;
+            }
+            else
+            {
+                // turn wa towards wb until the cone touches both
+                double theta_r{theta_o - theta_a};
+                result.w = wa * std::cos(theta_r) + cross(normalize(axis), wa) * std::sin(theta_r);
+                result.cos_theta_o = static_cast<float>(std::cos(theta_o));
+            }
+        }
+        return result;
+    }
+
+    struct light_bvh_sample_result
+    {
+        std::uint32_t index{};
+        double pdf_index{};
+    };
+
+    // picks one of many emitters in proportion to how much each can light a receiver; a binary tree of their bounds is
+    // walked from the root, choosing a child by the importance of its bounds, so sample and pdf take O(log n)
+    class light_bvh
+    {
+        static constexpr int bucket_count{12};
+        static constexpr double double_one_minus_epsilon{0x1.fffffffffffffp-1};
+
+    public:
+        light_bvh() = default;
+
+        explicit light_bvh(std::vector<light_bounds> const& items)
+        {
+            if(items.empty()) return;
+
+            std::vector<std::uint32_t> indices(items.size());
+            std::iota(indices.begin(), indices.end(), 0);
+
+            item_nodes_.resize(items.size());
+            nodes_.reserve(items.size() * 2 - 1);
+            build(items, indices.data(), indices.data() + indices.size(), 0);
+        }
+
+        bool empty() const
+        {
+            return nodes_.empty();
+        }
+
+        light_bounds const& get_bounds() const
+        {
+            return nodes_[0].bounds;
+        }
+
+        std::optional<light_bvh_sample_result> sample(vector3 const& p, vector3 const& n, double u) const
+        {
+            std::optional<light_bvh_sample_result> result{};
+            if(nodes_.empty()) return result;
+            if(nodes_[0].leaf && nodes_[0].bounds.importance(p, n) == 0.0) return result;
+
+            std::uint32_t node_index{};
+            double pdf{1.0};
+            while(!nodes_[node_index].leaf)
+            {
+                std::uint32_t second_child{nodes_[node_index].second_child_or_item};
+                auto probability{get_first_child_probability(node_index, p, n)};
+                if(!probability) return result;
+
+                if(u < *probability)
+                {
+                    u = std::min(u / *probability, double_one_minus_epsilon);
+                    pdf *= *probability;
+                    node_index += 1;
+                }
+                else
+                {
+                    u = std::min((u - *probability) / (1.0 - *probability), double_one_minus_epsilon);
+                    pdf *= 1.0 - *probability;
+                    node_index = second_child;
+                }
+            }
+
+            result.emplace();
+            result->index = nodes_[node_index].second_child_or_item;
+            result->pdf_index = pdf;
+            return result;
+        }
+
+        // walks up from the leaf of the item, the choices on the way are the ones sample made to reach it
+        double pdf(vector3 const& p, vector3 const& n, std::uint32_t index) const
+        {
+            std::uint32_t node_index{item_nodes_[index]};
+            if(node_index == 0) return nodes_[0].bounds.importance(p, n) > 0.0 ? 1.0 : 0.0;
+
+            double pdf{1.0};
+            while(node_index != 0)
+            {
+                std::uint32_t parent{nodes_[node_index].parent};
+                auto probability{get_first_child_probability(parent, p, n)};
+                if(!probability) return 0.0;
+
+                pdf *= node_index == parent + 1 ? *probability : 1.0 - *probability;
+                node_index = parent;
+            }
+            return pdf;
+        }
+
+        // for emitters that moved, the tree keeps its structure and only the bounds of its nodes are recomputed
+        void refit(std::vector<light_bounds> const& items)
+        {
+            for(std::size_t i{}; i < items.size(); ++i)
+            {
+                nodes_[item_nodes_[i]].bounds = items[i];
+            }
+
+            // children always come after their parent
+            for(std::size_t i{nodes_.size()}; i-- > 0;)
+            {
+                if(nodes_[i].leaf) continue;
+                nodes_[i].bounds = Union(nodes_[i + 1].bounds, nodes_[nodes_[i].second_child_or_item].bounds);
+            }
+        }
+
+    private:
+        // the first child directly follows its parent
+        struct node
+        {
+            light_bounds bounds{};
+            std::uint32_t parent{};
+            std::uint32_t second_child_or_item{};
+            bool leaf{};
+        };
+
+        std::vector<node> nodes_{};
+        std::vector<std::uint32_t> item_nodes_{};
+
+        std::optional<double> get_first_child_probability(std::uint32_t node_index, vector3 const& p, vector3 const& n) const
+        {
+            double importance0{nodes_[node_index + 1].bounds.importance(p, n)};
+            double importance1{nodes_[nodes_[node_index].second_child_or_item].bounds.importance(p, n)};
+            if(importance0 == 0.0 && importance1 == 0.0) return {};
+            return importance0 / (importance0 + importance1);
+        }
+
+        // power times the measure of the directions the bounds emit to times their surface area, long thin bounds
+        // split across their short side are penalized [Conty Estevez and Kulla 2018]
+        static double get_cost(light_bounds const& b, bounds3f const& node_bounds, int axis)
+        {
+            double theta_o{std::acos(std::clamp(static_cast<double>(b.cos_theta_o), -1.0, 1.0))};
+            double theta_e{std::acos(std::clamp(static_cast<double>(b.cos_theta_e), -1.0, 1.0))};
+            double theta_w{std::min(theta_o + theta_e, math::pi)};
+            double sin_theta_o{std::sqrt(std::max(1.0 - sqr(b.cos_theta_o), 0.0))};
+            double m_omega{2.0 * math::pi * (1.0 - b.cos_theta_o) + math::pi * 0.5 *
+                (2.0 * theta_w * sin_theta_o - std::cos(theta_o - 2.0 * theta_w) - 2.0 * theta_o * sin_theta_o + b.cos_theta_o)};
+            vector3 diagonal{node_bounds.diagonal()};
+            double kr{max_component(diagonal) / diagonal[axis]};
+            return b.phi * m_omega * kr * static_cast<double>(b.bounds.area());
+        }
+
+        std::uint32_t build(std::vector<light_bounds> const& items, std::uint32_t* begin, std::uint32_t* end, std::uint32_t parent)
+        {
+            std::uint32_t node_index{static_cast<std::uint32_t>(nodes_.size())};
+            nodes_.emplace_back();
+            nodes_[node_index].parent = parent;
+
+            if(end - begin == 1)
+            {
+                nodes_[node_index].bounds = items[*begin];
+                nodes_[node_index].second_child_or_item = *begin;
+                nodes_[node_index].leaf = true;
+                item_nodes_[*begin] = node_index;
+                return node_index;
+            }
+
+            bounds3f bounds{};
+            bounds3f centroid_bounds{};
+            for(std::uint32_t* i{begin}; i != end; ++i)
+            {
+                bounds.Union(items[*i].bounds);
+                centroid_bounds.Union(items[*i].bounds.centroid());
+            }
+
+            double min_cost{std::numeric_limits<double>::infinity()};
+            int min_cost_axis{-1};
+            int min_cost_bucket{};
+            for(int axis{}; axis < 3; ++axis)
+            {
+                float axis_min{centroid_bounds.Min()[axis]};
+                float axis_length{centroid_bounds.Max()[axis] - axis_min};
+                if(axis_length <= 0.0f || bounds.diagonal()[axis] <= 0.0f) continue;
+
+                light_bounds bucket_bounds[bucket_count]{};
+                std::size_t bucket_item_counts[bucket_count]{};
+                for(std::uint32_t* i{begin}; i != end; ++i)
+                {
+                    int bucket{std::min(static_cast<int>((items[*i].bounds.centroid()[axis] - axis_min) / axis_length * bucket_count), bucket_count - 1)};
+                    bucket_bounds[bucket] = bucket_item_counts[bucket] == 0 ? items[*i] : Union(bucket_bounds[bucket], items[*i]);
+                    bucket_item_counts[bucket] += 1;
+                }
+
+                for(int split{}; split < bucket_count - 1; ++split)
+                {
+                    light_bounds b0{};
+                    light_bounds b1{};
+                    std::size_t count0{};
+                    std::size_t count1{};
+                    for(int i{}; i <= split; ++i)
+                    {
+                        if(bucket_item_counts[i] == 0) continue;
+                        b0 = count0 == 0 ? bucket_bounds[i] : Union(b0, bucket_bounds[i]);
+                        count0 += bucket_item_counts[i];
+                    }
+                    for(int i{split + 1}; i < bucket_count; ++i)
+                    {
+                        if(bucket_item_counts[i] == 0) continue;
+                        b1 = count1 == 0 ? bucket_bounds[i] : Union(b1, bucket_bounds[i]);
+                        count1 += bucket_item_counts[i];
+                    }
+                    if(count0 == 0 || count1 == 0) continue;
+
+                    double cost{get_cost(b0, bounds, axis) + get_cost(b1, bounds, axis)};
+                    if(cost < min_cost || min_cost_axis == -1)
+                    {
+                        min_cost = cost;
+                        min_cost_axis = axis;
+                        min_cost_bucket = split;
+                    }
+                }
+            }
+
+            std::uint32_t* middle{begin + (end - begin) / 2};
+            if(min_cost_axis != -1)
+            {
+                float axis_min{centroid_bounds.Min()[min_cost_axis]};
+                float axis_length{centroid_bounds.Max()[min_cost_axis] - axis_min};
+                middle = std::partition(begin, end, [&] (std::uint32_t i)
+                {
+                    int bucket{std::min(static_cast<int>((items[i].bounds.centroid()[min_cost_axis] - axis_min) / axis_length * bucket_count), bucket_count - 1)};
+                    return bucket <= min_cost_bucket;
+                });
+            }
+
+            build(items, begin, middle, node_index);
+            std::uint32_t second_child{build(items, middle, end, node_index)};
+
+            nodes_[node_index].second_child_or_item = second_child;
+            nodes_[node_index].bounds = Union(nodes_[node_index + 1].bounds, nodes_[second_child].bounds);
+            return node_index;
+        }
+    };
+}
\ No newline at end of file
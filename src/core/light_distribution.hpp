@@ -26,7 +26,13 @@ namespace fc
     public:
         virtual ~spatial_light_distribution() = default;
 
-        virtual light_distribution const* get(surface_point const& p) const = 0;
+        // picks a light for the receiver p, the pdf of a light depends on p as well
+        virtual light_distribution_sample_result sample(surface_point const& p, double sample_picking) const = 0;
+        virtual double pdf(surface_point const& p, light const* light) const = 0;
+
+        // for frames of an animation, after the lights moved
+        virtual void update()
+        { }
     };
 
 
@@ -2,7 +2,8 @@
 #include "bsdf.hpp"
 #include "bxdf.hpp"
 #include "surface_point.hpp"
-#include "allocator.hpp"
+
+#include <memory>
 
 namespace fc
 {
@@ -11,6 +12,12 @@ namespace fc
     public:
         virtual ~material() = default;
 
-        virtual bsdf const* evaluate(surface_point const& p, allocator_wrapper& allocator) const = 0;
+        virtual bsdf evaluate(surface_point const& p) const = 0;
+
+        // called once at scene build, returns a specialized replacement or nullptr to keep this material
+        virtual std::shared_ptr<material> compile() const
+        {
+            return nullptr;
+        }
     };
 }
\ No newline at end of file
@@ -12,6 +12,13 @@ namespace fc
     {
         static constexpr T pi{T(3.141592653589793)};
         static constexpr T inv_pi{T(1.0) / pi};
+        static constexpr T machine_epsilon{std::numeric_limits<T>::epsilon() * T(0.5)};
+
+        // bound on the relative error accumulated by n rounded operations
+        static constexpr T gamma(int n)
+        {
+            return (n * machine_epsilon) / (T(1) - n * machine_epsilon);
+        }
 
         static constexpr T deg_to_rad(T value)
         {
@@ -255,6 +262,12 @@ namespace fc
         }
     }
 
+    template <typename T>
+    T max_component(TVector3<T> const& v)
+    {
+        return std::max(v.x, std::max(v.y, v.z));
+    }
+
     template <typename T>
     TVector3<T> permute(TVector3<T> const& v, int x, int y, int z)
     {
@@ -642,6 +655,25 @@ namespace fc
             return *this;
         }
 
+        // leaves the bounds empty, min above max, when the two do not overlap
+        TBounds3& Intersect(TBounds3 const& b)
+        {
+            p_[0].x = std::max(p_[0].x, b.p_[0].x);
+            p_[0].y = std::max(p_[0].y, b.p_[0].y);
+            p_[0].z = std::max(p_[0].z, b.p_[0].z);
+
+            p_[1].x = std::min(p_[1].x, b.p_[1].x);
+            p_[1].y = std::min(p_[1].y, b.p_[1].y);
+            p_[1].z = std::min(p_[1].z, b.p_[1].z);
+
+            return *this;
+        }
+
+        bool is_empty() const
+        {
+            return p_[0].x > p_[1].x || p_[0].y > p_[1].y || p_[0].z > p_[1].z;
+        }
+
         bool Raycast(TRay3<T> const& ray, T tMax, T* tHit0, T* tHit1) const
         {
             T t0{};
@@ -655,6 +687,7 @@ namespace fc
                 {
                     std::swap(tNear, tFar);
                 }
+                tFar *= T(1) + T(2) * TMath<T>::gamma(3);
 
                 t0 = tNear > t0 ? tNear : t0;
                 t1 = tFar < t1 ? tFar : t1;
@@ -673,14 +706,18 @@ namespace fc
             T t0{(p_[dirIsNeg[0]].x - ray.origin.x) * invDir.x};
             T t1{(p_[1 - dirIsNeg[0]].x - ray.origin.x) * invDir.x};
 
+            // the far distances are rounded up so a hit on the box surface is never missed
+            T far_scale{T(1) + T(2) * TMath<T>::gamma(3)};
+            t1 *= far_scale;
+
             T ty0{(p_[dirIsNeg[1]].y - ray.origin.y) * invDir.y};
-            T ty1{(p_[1 - dirIsNeg[1]].y - ray.origin.y) * invDir.y};
+            T ty1{(p_[1 - dirIsNeg[1]].y - ray.origin.y) * invDir.y * far_scale};
             if(t0 > ty1 || ty0 > t1) return false;
             if(ty0 > t0) t0 = ty0;
             if(ty1 < t1) t1 = ty1;
 
             T tz0{(p_[dirIsNeg[2]].z - ray.origin.z) * invDir.z};
-            T tz1{(p_[1 - dirIsNeg[2]].z - ray.origin.z) * invDir.z};
+            T tz1{(p_[1 - dirIsNeg[2]].z - ray.origin.z) * invDir.z * far_scale};
             if(t0 > tz1 || tz0 > t1) return false;
             if(tz0 > t0) t0 = tz0;
             if(tz1 < t1) t1 = tz1;
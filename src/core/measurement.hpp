@@ -35,5 +35,9 @@ namespace fc
 
         virtual void add_sample(surface_point const& p, vector3 Li) const = 0;
         virtual void add_sample_count(int value) const = 0;
+
+        // a coarse estimate of the luminance of the current pixel relative to the mean of the image, zero when there
+        // is none
+        virtual double get_pixel_estimate() const = 0;
     };
 }
\ No newline at end of file
@@ -3,29 +3,14 @@
 #include <concepts>
 namespace fc
 {
-
-    class microfacet_model
-    {
-    public:
-        virtual ~microfacet_model() = default;
-
-        virtual vector3 sample(vector3 const& i, vector2 const& u) const = 0;
-        virtual double pdf(vector3 const& i, vector3 const& m) const = 0;
-        virtual double distribution(vector3 const& m) const = 0;
-
-        virtual double masking(vector3 const& i, vector3 const& m) const = 0;
-        virtual double masking(vector3 const& i, vector3 const& o, vector3 const& m) const = 0;
-    };
-
-
-    class smith_ggx_microfacet_model : public microfacet_model
+    class smith_ggx_microfacet_model
     {
     public:
         explicit smith_ggx_microfacet_model(vector2 const& roughness)
             : alpha_{roughness_to_alpha(roughness)}
         { }
 
-        virtual vector3 sample(vector3 const& i, vector2 const& u) const override
+        vector3 sample(vector3 const& i, vector2 const& u) const
         {
             vector3 ih{normalize(vector3{alpha_.x * i.x, i.y, alpha_.y * i.z})};
             double lensq{ih.x * ih.x + ih.z * ih.z};
@@ -43,27 +28,39 @@ namespace fc
             return normalize(vector3{alpha_.x * Nh.x, std::max(0.0, Nh.y), alpha_.y * Nh.z});
         }
 
-        virtual double pdf(vector3 const& i, vector3 const& m) const override
+        double pdf(vector3 const& i, vector3 const& m) const
         {
             return masking(i, m) * std::max(0.0, dot(i, m)) * distribution(m) / i.y;
         }
 
-        virtual double distribution(vector3 const& m) const override
+        double distribution(vector3 const& m) const
         {
             double x{m.x * m.x / (alpha_.x * alpha_.x) + m.y * m.y + m.z * m.z / (alpha_.y * alpha_.y)};
             return 1.0 / (math::pi * alpha_.x * alpha_.y * x * x);
         }
 
-        virtual double masking(vector3 const& i, vector3 const& m) const override
+        double masking(vector3 const& i, vector3 const& m) const
         {
             return 1.0 / (1.0 + lamda(i));
         }
 
-        virtual double masking(vector3 const& i, vector3 const& o, vector3 const& m) const override
+        double masking(vector3 const& i, vector3 const& o, vector3 const& m) const
         {
             return 1.0 / (1.0 + lamda(i) + lamda(o));
         }
 
+        // masking, distribution and the visible normal pdfs seen from i and from o, sharing the lambda terms
+        void evaluate(vector3 const& i, vector3 const& o, vector3 const& m, double* g, double* d, double* pdf_i, double* pdf_o) const
+        {
+            double lamda_i{lamda(i)};
+            double lamda_o{lamda(o)};
+
+            *d = distribution(m);
+            *g = 1.0 / (1.0 + lamda_i + lamda_o);
+            *pdf_i = 1.0 / (1.0 + lamda_i) * std::max(0.0, dot(i, m)) * *d / i.y;
+            *pdf_o = 1.0 / (1.0 + lamda_o) * std::max(0.0, dot(o, m)) * *d / o.y;
+        }
+
     private:
         vector2 alpha_{};
 
@@ -0,0 +1,54 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace fc
+{
+    // enough work per thread to pay for starting it
+    inline std::size_t get_parallel_chunk_count(std::size_t count)
+    {
+        constexpr std::size_t min_chunk_size{1 << 14};
+        std::size_t thread_count{std::max(1u, std::thread::hardware_concurrency())};
+        return std::clamp<std::size_t>(count / min_chunk_size, 1, thread_count);
+    }
+
+    // runs f(chunk, begin, end) for chunk_count contiguous chunks of [0, count), each on its own thread
+    template <typename F>
+    void parallel_chunks(std::size_t count, std::size_t chunk_count, F const& f)
+    {
+        std::vector<std::thread> workers{};
+        workers.reserve(chunk_count - 1);
+        for(std::size_t chunk{1}; chunk < chunk_count; ++chunk)
+        {
+            workers.emplace_back(
+                [&f, count, chunk_count, chunk] ()
+                {
+                    f(chunk, count * chunk / chunk_count, count * (chunk + 1) / chunk_count);
+                }
+            );
+        }
+
+        f(0, 0, count / chunk_count);
+
+        for(std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    template <typename F>
+    void parallel_for(std::size_t count, F const& f)
+    {
+        parallel_chunks(count, get_parallel_chunk_count(count),
+            [&f] (std::size_t, std::size_t begin, std::size_t end)
+            {
+                for(std::size_t i{begin}; i < end; ++i)
+                {
+                    f(i);
+                }
+            }
+        );
+    }
+}
\ No newline at end of file
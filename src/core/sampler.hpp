@@ -1,8 +1,11 @@
 #pragma once
 #include "math.hpp"
 
+#include <array>
+#include <bit>
 #include <random>
 #include <memory>
+#include <span>
 #include <fstream>
 #include <string>
 
@@ -12,6 +15,23 @@
 
 namespace fc
 {
+    // the finalizer of splitmix64, every bit of x affects every bit of the result
+    inline std::uint64_t mix_bits(std::uint64_t x)
+    {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111eb;
+        x ^= x >> 31;
+        return x;
+    }
+
+    // the bits become the mantissa of a double in [1, 2), the result is x * 2^-32 exactly
+    inline double to_unit(std::uint32_t x)
+    {
+        return std::bit_cast<double>(0x3ff0000000000000 | (static_cast<std::uint64_t>(x) << 20)) - 1.0;
+    }
+
     class sampler
     {
     public:
@@ -19,6 +39,25 @@ namespace fc
 
         virtual vector2 get() = 0;
 
+        // the next values.size() dimensions with a single virtual call, the samplers are final so their overrides
+        // call get() directly
+        virtual void get_batch(std::span<vector2> values)
+        {
+            for(vector2& value : values)
+            {
+                value = get();
+            }
+        }
+
+        // the next N dimensions in dimension order, the integrators take the dimensions of a vertex at once
+        template<std::size_t N>
+        std::array<vector2, N> get_array()
+        {
+            std::array<vector2, N> values{};
+            get_batch(values);
+            return values;
+        }
+
         virtual void advance_dimension(int count = 1) = 0;
         virtual void set_dimension(int dimension_index) = 0;
     };
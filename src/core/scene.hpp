@@ -36,6 +36,16 @@ namespace fc
             acceleration_structure_factory const& acceleration_structure_factory, light_distribution_factory const& light_distribution_factory, spatial_light_distribution_factory const& spatial_light_distribution_factory)
             : entities_{std::move(entities)}, infinity_area_light_{std::move(infinity_area_light)}
         {
+            // replace materials with constant inputs by their specialized versions
+            for(auto& entity : entities_)
+            {
+                if(entity.material == nullptr) continue;
+                if(auto compiled_material{entity.material->compile()}; compiled_material != nullptr)
+                {
+                    entity.material = std::move(compiled_material);
+                }
+            }
+
             std::uint64_t total_primitive_count{};
             for(auto const& entity : entities_)
             {
@@ -57,6 +67,7 @@ namespace fc
                 if(entity.area_light != nullptr)
                 {
                     entity.surface->prepare_for_sampling();
+                    entity.area_light->set_index(static_cast<std::uint32_t>(lights.size()));
                     lights.push_back(entity.area_light.get());
                 }
             }
@@ -65,6 +76,7 @@ namespace fc
 
             if(infinity_area_light_ != nullptr)
             {
+                infinity_area_light_->set_index(static_cast<std::uint32_t>(lights.size()));
                 lights.push_back(infinity_area_light_.get());
                 infinity_area_light_->set_scene_bounds(acceleration_structure_->get_bounds());
             }
@@ -73,6 +85,18 @@ namespace fc
             spatial_light_distribution_ = spatial_light_distribution_factory.create(std::move(lights));
         }
 
+        // for frames of an animation, after surfaces moved their primitives
+        void update()
+        {
+            acceleration_structure_->update();
+            spatial_light_distribution_->update();
+
+            if(infinity_area_light_ != nullptr)
+            {
+                infinity_area_light_->set_scene_bounds(acceleration_structure_->get_bounds());
+            }
+        }
+
         virtual bounds3 get_bounds() const override
         {
             return acceleration_structure_->get_bounds();
@@ -82,15 +106,7 @@ namespace fc
         {
             std::optional<surface_point*> result{};
 
-            ray3 ray{p.get_position(), w};
-            if(dot(p.get_normal(), w) > 0.0)
-            {
-                ray.origin += p.get_normal() * epsilon_;
-            }
-            else
-            {
-                ray.origin -= p.get_normal() * epsilon_;
-            }
+            ray3 ray{offset_ray_origin(p, w), w};
 
             auto raycast_surface_point_result{acceleration_structure_->raycast_surface_point(ray, std::numeric_limits<double>::infinity(), allocator)};
             if(raycast_surface_point_result)
@@ -98,6 +114,7 @@ namespace fc
                 surface_point* p{raycast_surface_point_result->p};
                 entity const* e{raycast_surface_point_result->entity_primitive.entity};
 
+                p->set_primitive(raycast_surface_point_result->entity_primitive.primitive);
                 p->set_light(e->area_light.get());
                 p->set_material(e->material.get());
                 p->set_medium(e->medium.get());
@@ -109,49 +126,22 @@ namespace fc
 
         virtual bool visibility(surface_point const& p0, surface_point const& p1) const override
         {
-            vector3 position0{p0.get_position()};
-            vector3 position1{p1.get_position()};
-            vector3 normal0{p0.get_normal()};
-            vector3 normal1{p1.get_normal()};
-
-            vector3 to1{position1 - position0};
-            if(dot(to1, normal0) > 0.0)
-            {
-                position0 += normal0 * epsilon_;
-            }
-            else
-            {
-                position0 -= normal0 * epsilon_;
-            }
-
-            if(dot(to1, normal1) < 0.0)
-            {
-                position1 += normal1 * epsilon_;
-            }
-            else
-            {
-                position1 -= normal1 * epsilon_;
-            }
+            vector3 to1{p1.get_position() - p0.get_position()};
+            vector3 position0{offset_ray_origin(p0, to1)};
+            vector3 position1{offset_ray_origin(p1, -to1)};
 
             to1 = position1 - position0;
             double len{length(to1)};
             vector3 w01{to1 / len};
             ray3 ray{position0, w01};
 
-            return !acceleration_structure_->raycast(ray, len);
+            // p1 is a point on a surface as well, stop just short of it
+            return !acceleration_structure_->raycast(ray, len * (1.0 - shadow_epsilon_));
         }
 
         virtual bool visibility(surface_point const& p, vector3 const& w) const override
         {
-            ray3 ray{p.get_position(), w};
-            if(dot(p.get_normal(), w) > 0.0)
-            {
-                ray.origin += p.get_normal() * epsilon_;
-            }
-            else
-            {
-                ray.origin -= p.get_normal() * epsilon_;
-            }
+            ray3 ray{offset_ray_origin(p, w), w};
 
             return !acceleration_structure_->raycast(ray, std::numeric_limits<double>::infinity());
         }
@@ -179,6 +169,6 @@ namespace fc
         std::unique_ptr<light_distribution> light_distribution_{};
         std::unique_ptr<spatial_light_distribution> spatial_light_distribution_{};
 
-        double epsilon_{0.000001};
+        static constexpr double shadow_epsilon_{0.0001};
     };
 }
\ No newline at end of file
@@ -0,0 +1,281 @@
+#pragma once
+#include "math.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FC_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FC_SIMD_SSE2
+#endif
+
+namespace fc
+{
+    // vector3 held in registers as x, y, z, 0, the operations round exactly like the scalar ones
+    // so swapping one for the other does not change any result
+    class packed_vector3
+    {
+    public:
+        packed_vector3()
+#if defined(FC_SIMD_SSE2)
+            : xy_{_mm_setzero_pd()}, zw_{_mm_setzero_pd()}
+#endif
+        { }
+
+        explicit packed_vector3(vector3 const& v)
+        {
+#if defined(FC_SIMD_AVX2)
+            store(_mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(&v.x)), _mm_load_sd(&v.z), 1));
+#elif defined(FC_SIMD_SSE2)
+            xy_ = _mm_loadu_pd(&v.x);
+            zw_ = _mm_load_sd(&v.z);
+#else
+            v_[0] = v.x;
+            v_[1] = v.y;
+            v_[2] = v.z;
+#endif
+        }
+
+        // same value in every lane, used as a scale factor
+        static packed_vector3 broadcast(double c)
+        {
+            packed_vector3 r{};
+#if defined(FC_SIMD_AVX2)
+            r.store(_mm256_set1_pd(c));
+#elif defined(FC_SIMD_SSE2)
+            r.xy_ = _mm_set1_pd(c);
+            r.zw_ = _mm_set1_pd(c);
+#else
+            r.v_[0] = r.v_[1] = r.v_[2] = r.v_[3] = c;
+#endif
+            return r;
+        }
+
+        vector3 unpack() const
+        {
+            vector3 v{};
+#if defined(FC_SIMD_AVX2)
+            __m256d xyzw{load()};
+            _mm_storeu_pd(&v.x, _mm256_castpd256_pd128(xyzw));
+            _mm_store_sd(&v.z, _mm256_extractf128_pd(xyzw, 1));
+#elif defined(FC_SIMD_SSE2)
+            _mm_storeu_pd(&v.x, xy_);
+            _mm_store_sd(&v.z, zw_);
+#else
+            v = {v_[0], v_[1], v_[2]};
+#endif
+            return v;
+        }
+
+        friend packed_vector3 operator+(packed_vector3 const& a, packed_vector3 const& b)
+        {
+            packed_vector3 r{};
+#if defined(FC_SIMD_AVX2)
+            r.store(_mm256_add_pd(a.load(), b.load()));
+#elif defined(FC_SIMD_SSE2)
+            r.xy_ = _mm_add_pd(a.xy_, b.xy_);
+            r.zw_ = _mm_add_pd(a.zw_, b.zw_);
+#else
+            for(int i{}; i < 4; ++i) r.v_[i] = a.v_[i] + b.v_[i];
+#endif
+            return r;
+        }
+
+        friend packed_vector3 operator-(packed_vector3 const& a, packed_vector3 const& b)
+        {
+            packed_vector3 r{};
+#if defined(FC_SIMD_AVX2)
+            r.store(_mm256_sub_pd(a.load(), b.load()));
+#elif defined(FC_SIMD_SSE2)
+            r.xy_ = _mm_sub_pd(a.xy_, b.xy_);
+            r.zw_ = _mm_sub_pd(a.zw_, b.zw_);
+#else
+            for(int i{}; i < 4; ++i) r.v_[i] = a.v_[i] - b.v_[i];
+#endif
+            return r;
+        }
+
+        friend packed_vector3 operator*(packed_vector3 const& a, packed_vector3 const& b)
+        {
+            packed_vector3 r{};
+#if defined(FC_SIMD_AVX2)
+            r.store(_mm256_mul_pd(a.load(), b.load()));
+#elif defined(FC_SIMD_SSE2)
+            r.xy_ = _mm_mul_pd(a.xy_, b.xy_);
+            r.zw_ = _mm_mul_pd(a.zw_, b.zw_);
+#else
+            for(int i{}; i < 4; ++i) r.v_[i] = a.v_[i] * b.v_[i];
+#endif
+            return r;
+        }
+
+        friend packed_vector3 operator*(packed_vector3 const& a, double c)
+        {
+            return a * broadcast(c);
+        }
+
+        friend packed_vector3 operator/(packed_vector3 const& a, double c)
+        {
+            packed_vector3 r{};
+#if defined(FC_SIMD_AVX2)
+            r.store(_mm256_div_pd(a.load(), _mm256_set1_pd(c)));
+#elif defined(FC_SIMD_SSE2)
+            r.xy_ = _mm_div_pd(a.xy_, _mm_set1_pd(c));
+            r.zw_ = _mm_div_pd(a.zw_, _mm_set1_pd(c));
+#else
+            for(int i{}; i < 4; ++i) r.v_[i] = a.v_[i] / c;
+#endif
+            return r;
+        }
+
+        // summed as (x + y) + z like the scalar dot
+        friend double dot(packed_vector3 const& a, packed_vector3 const& b)
+        {
+#if defined(FC_SIMD_AVX2)
+            __m256d p{_mm256_mul_pd(a.load(), b.load())};
+            __m128d xy{_mm256_castpd256_pd128(p)};
+            __m128d zw{_mm256_extractf128_pd(p, 1)};
+            return _mm_cvtsd_f64(_mm_add_sd(_mm_add_sd(xy, _mm_unpackhi_pd(xy, xy)), zw));
+#elif defined(FC_SIMD_SSE2)
+            __m128d xy{_mm_mul_pd(a.xy_, b.xy_)};
+            __m128d zw{_mm_mul_sd(a.zw_, b.zw_)};
+            return _mm_cvtsd_f64(_mm_add_sd(_mm_add_sd(xy, _mm_unpackhi_pd(xy, xy)), zw));
+#else
+            return a.v_[0] * b.v_[0] + a.v_[1] * b.v_[1] + a.v_[2] * b.v_[2];
+#endif
+        }
+
+        friend packed_vector3 cross(packed_vector3 const& a, packed_vector3 const& b)
+        {
+            packed_vector3 r{};
+#if defined(FC_SIMD_AVX2)
+            __m256d a_yzx{_mm256_permute4x64_pd(a.load(), _MM_SHUFFLE(3, 0, 2, 1))};
+            __m256d b_yzx{_mm256_permute4x64_pd(b.load(), _MM_SHUFFLE(3, 0, 2, 1))};
+            __m256d a_zxy{_mm256_permute4x64_pd(a.load(), _MM_SHUFFLE(3, 1, 0, 2))};
+            __m256d b_zxy{_mm256_permute4x64_pd(b.load(), _MM_SHUFFLE(3, 1, 0, 2))};
+            r.store(_mm256_sub_pd(_mm256_mul_pd(a_yzx, b_zxy), _mm256_mul_pd(a_zxy, b_yzx)));
+#elif defined(FC_SIMD_SSE2)
+            __m128d a_yz{_mm_shuffle_pd(a.xy_, a.zw_, 0b01)};
+            __m128d b_yz{_mm_shuffle_pd(b.xy_, b.zw_, 0b01)};
+            __m128d a_zx{_mm_shuffle_pd(a.zw_, a.xy_, 0b00)};
+            __m128d b_zx{_mm_shuffle_pd(b.zw_, b.xy_, 0b00)};
+            r.xy_ = _mm_sub_pd(_mm_mul_pd(a_yz, b_zx), _mm_mul_pd(a_zx, b_yz));
+
+            __m128d z{_mm_mul_pd(a.xy_, _mm_shuffle_pd(b.xy_, b.xy_, 0b01))};
+            r.zw_ = _mm_move_sd(_mm_setzero_pd(), _mm_sub_sd(z, _mm_unpackhi_pd(z, z)));
+#else
+            r.v_[0] = a.v_[1] * b.v_[2] - a.v_[2] * b.v_[1];
+            r.v_[1] = a.v_[2] * b.v_[0] - a.v_[0] * b.v_[2];
+            r.v_[2] = a.v_[0] * b.v_[1] - a.v_[1] * b.v_[0];
+            r.v_[3] = 0.0;
+#endif
+            return r;
+        }
+
+        friend packed_vector3 abs(packed_vector3 const& v)
+        {
+            packed_vector3 r{};
+#if defined(FC_SIMD_AVX2)
+            r.store(_mm256_andnot_pd(_mm256_set1_pd(-0.0), v.load()));
+#elif defined(FC_SIMD_SSE2)
+            r.xy_ = _mm_andnot_pd(_mm_set1_pd(-0.0), v.xy_);
+            r.zw_ = _mm_andnot_pd(_mm_set1_pd(-0.0), v.zw_);
+#else
+            for(int i{}; i < 4; ++i) r.v_[i] = std::abs(v.v_[i]);
+#endif
+            return r;
+        }
+
+        friend packed_vector3 normalize(packed_vector3 const& v)
+        {
+            return v / std::sqrt(dot(v, v));
+        }
+
+    private:
+#if defined(FC_SIMD_SSE2)
+        __m128d xy_;
+        __m128d zw_;
+#else
+        double v_[4]{};
+#endif
+
+#if defined(FC_SIMD_AVX2)
+        // kept as plain doubles, the allocators only align to 16 bytes
+        __m256d load() const
+        {
+            return _mm256_loadu_pd(v_);
+        }
+
+        void store(__m256d xyzw)
+        {
+            _mm256_storeu_pd(v_, xyzw);
+        }
+#endif
+    };
+
+    // affine 3x4 matrix, kept as its four columns so a transform is three broadcast multiply adds
+    // accumulated in the same order as the scalar row by row code
+    class packed_matrix3x4
+    {
+    public:
+        packed_matrix3x4() = default;
+
+        explicit packed_matrix3x4(matrix4x4 const& m)
+            : columns_{
+                packed_vector3{vector3{m.m00, m.m10, m.m20}},
+                packed_vector3{vector3{m.m01, m.m11, m.m21}},
+                packed_vector3{vector3{m.m02, m.m12, m.m22}},
+                packed_vector3{vector3{m.m03, m.m13, m.m23}}
+            }
+        { }
+
+        // linear part only, the translation column is zero
+        explicit packed_matrix3x4(vector3 const& c0, vector3 const& c1, vector3 const& c2)
+            : columns_{packed_vector3{c0}, packed_vector3{c1}, packed_vector3{c2}, packed_vector3{}}
+        { }
+
+        // the upper 3x3 transposed, without translation, normals are transformed by the inverse transpose
+        packed_matrix3x4 transpose3x3() const
+        {
+            vector3 c0{columns_[0].unpack()};
+            vector3 c1{columns_[1].unpack()};
+            vector3 c2{columns_[2].unpack()};
+
+            return packed_matrix3x4{
+                vector3{c0.x, c1.x, c2.x},
+                vector3{c0.y, c1.y, c2.y},
+                vector3{c0.z, c1.z, c2.z}
+            };
+        }
+
+        // bound on the rounding error of transform_point for a point that is already off by up to p_error
+        vector3 transform_point_error(vector3 const& p, vector3 const& p_error) const
+        {
+            double g3{math::gamma(3)};
+            packed_vector3 c0{abs(columns_[0])};
+            packed_vector3 c1{abs(columns_[1])};
+            packed_vector3 c2{abs(columns_[2])};
+            packed_vector3 rounding{(c0 * std::abs(p.x) + c1 * std::abs(p.y) + c2 * std::abs(p.z) + abs(columns_[3])) * g3};
+            packed_vector3 propagated{(c0 * p_error.x + c1 * p_error.y + c2 * p_error.z) * (g3 + 1.0)};
+            return (rounding + propagated).unpack();
+        }
+
+        vector3 get_column(int i) const
+        {
+            return columns_[i].unpack();
+        }
+
+        vector3 transform_point(vector3 const& p) const
+        {
+            return (columns_[0] * p.x + columns_[1] * p.y + columns_[2] * p.z + columns_[3]).unpack();
+        }
+
+        vector3 transform_vector(vector3 const& v) const
+        {
+            return (columns_[0] * v.x + columns_[1] * v.y + columns_[2] * v.z).unpack();
+        }
+
+    private:
+        packed_vector3 columns_[4]{};
+    };
+}
\ No newline at end of file
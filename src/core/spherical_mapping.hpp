@@ -0,0 +1,125 @@
+#pragma once
+#include "math.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace fc
+{
+    // converts between directions and the uv of an equirectangular map, u = 1 - phi / 2pi and v = theta / pi with theta
+    // measured from +y and phi from +x towards +z, without calling any trigonometric function: angles are split into
+    // a tabulated angle and a remainder small enough for a few terms of its taylor series; the table of the inverse is
+    // uniform in the diamond angle, a cheap monotonic function of the angle, so finding the entry needs no search;
+    // the tables are built once per process and shared
+    class spherical_mapping
+    {
+        static constexpr int table_size{1024};
+        static constexpr double angle_step{2.0 * math::pi / table_size};
+        static constexpr double diamond_step{4.0 / table_size};
+        static constexpr double double_one_minus_epsilon{0x1.fffffffffffffp-1};
+
+        struct table_entry
+        {
+            double angle{};
+            double cos_angle{};
+            double sin_angle{};
+        };
+
+        struct tables
+        {
+            std::array<table_entry, table_size> angles{};
+            std::array<table_entry, table_size> diamond_angles{};
+        };
+
+    public:
+        static vector2 direction_to_uv(vector3 const& w)
+        {
+            double r{std::sqrt(w.x * w.x + w.z * w.z)};
+            double theta{get_angle(w.y, r)};
+            double phi{get_angle(w.x, w.z)};
+
+            return {1.0 - phi / (2.0 * math::pi), theta / math::pi};
+        }
+
+        static vector3 uv_to_direction(vector2 const& uv)
+        {
+            auto [cos_theta, sin_theta] {get_cos_sin(uv.y * math::pi)};
+            auto [cos_phi, sin_phi] {get_cos_sin((1.0 - uv.x) * 2.0 * math::pi)};
+
+            return {sin_theta * cos_phi, cos_theta, sin_theta * sin_phi};
+        }
+
+        // the angle of (x, y) in [0, 2pi)
+        static double get_angle(double x, double y)
+        {
+            if(x == 0.0 && y == 0.0) return 0.0;
+
+            int index{std::min(static_cast<int>(get_diamond_angle(x, y) / diamond_step), table_size - 1)};
+            table_entry const& entry{get_tables().diamond_angles[index]};
+
+            // rotated back by the tabulated angle the remainder is below 8 / table_size
+            double rotated_x{x * entry.cos_angle + y * entry.sin_angle};
+            double rotated_y{y * entry.cos_angle - x * entry.sin_angle};
+            double t{rotated_y / rotated_x};
+            double t2{t * t};
+            double angle{entry.angle + t * (1.0 - t2 * (1.0 / 3.0 - t2 * (1.0 / 5.0 - t2 * (1.0 / 7.0))))};
+
+            return std::clamp(angle, 0.0, 2.0 * math::pi * double_one_minus_epsilon);
+        }
+
+        // cos and sin of an angle in [0, 2pi]
+        static std::array<double, 2> get_cos_sin(double angle)
+        {
+            int index{std::clamp(static_cast<int>(angle / angle_step), 0, table_size - 1)};
+            table_entry const& entry{get_tables().angles[index]};
+
+            double d{angle - entry.angle};
+            double d2{d * d};
+            double cos_d{1.0 - d2 * (1.0 / 2.0 - d2 * (1.0 / 24.0 - d2 * (1.0 / 720.0)))};
+            double sin_d{d * (1.0 - d2 * (1.0 / 6.0 - d2 * (1.0 / 120.0)))};
+
+            return {
+                entry.cos_angle * cos_d - entry.sin_angle * sin_d,
+                entry.sin_angle * cos_d + entry.cos_angle * sin_d
+            };
+        }
+
+    private:
+        static tables const& get_tables()
+        {
+            static tables const instance{[] ()
+            {
+                tables tables{};
+                for(int i{}; i < table_size; ++i)
+                {
+                    double angle{i * angle_step};
+                    tables.angles[i] = {angle, std::cos(angle), std::sin(angle)};
+
+                    double q{i * diamond_step};
+                    vector2 p{diamond_point(q)};
+                    double diamond_angle{std::atan2(p.y, p.x)};
+                    if(diamond_angle < 0.0) diamond_angle += 2.0 * math::pi;
+                    tables.diamond_angles[i] = {diamond_angle, std::cos(diamond_angle), std::sin(diamond_angle)};
+                }
+                return tables;
+            }()};
+            return instance;
+        }
+
+        // the distance walked along the square |x| + |y| = 1 to the direction of (x, y), in [0, 4)
+        static double get_diamond_angle(double x, double y)
+        {
+            if(y >= 0.0) return x >= 0.0 ? y / (x + y) : 1.0 - x / (y - x);
+            return x < 0.0 ? 2.0 - y / (-x - y) : 3.0 + x / (x - y);
+        }
+
+        static vector2 diamond_point(double q)
+        {
+            if(q < 1.0) return {1.0 - q, q};
+            if(q < 2.0) return {1.0 - q, 2.0 - q};
+            if(q < 3.0) return {q - 3.0, 2.0 - q};
+            return {q - 3.0, q - 4.0};
+        }
+    };
+}
\ No newline at end of file
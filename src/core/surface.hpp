@@ -2,6 +2,7 @@
 #include "surface_point.hpp"
 #include "allocator.hpp"
 #include <optional>
+#include <variant>
 
 namespace fc
 {
@@ -16,6 +17,31 @@ namespace fc
         double t{};
     };
 
+    struct surface_triangle
+    {
+        vector3f p0{};
+        vector3f p1{};
+        vector3f p2{};
+    };
+
+    struct surface_sphere
+    {
+        vector3 center{};
+        double radius{};
+    };
+
+    // rectangle spanned by tangent and bitangent around center
+    struct surface_plane
+    {
+        vector3 center{};
+        vector3 normal{};
+        vector3 tangent{};
+        vector3 bitangent{};
+        vector2 half_size{};
+    };
+
+    using surface_shape = std::variant<surface_triangle, surface_sphere, surface_plane>;
+
     struct surface_sample_result
     {
         surface_point* p{};
@@ -38,9 +64,27 @@ namespace fc
         virtual std::optional<surface_raycast_result> raycast(std::uint32_t primitive, ray3 const& ray, double t_max) const = 0;
         virtual std::optional<surface_raycast_surface_point_result> raycast_surface_point(std::uint32_t primitive, ray3 const& ray, double t_max, allocator_wrapper& allocator) const = 0;
 
+        // simple shapes hand their world space description to the acceleration structure, which intersects them itself
+        // and builds the surface point of the closest hit from its t, or its barycentrics for triangles
+        virtual std::optional<surface_shape> get_shape(std::uint32_t primitive) const
+        {
+            return {};
+        }
+
+        virtual surface_point* create_surface_point(std::uint32_t primitive, ray3 const& ray, double t, vector3 const& b, allocator_wrapper& allocator) const
+        {
+            return nullptr;
+        }
+
         virtual void prepare_for_sampling() = 0;
         virtual std::optional<surface_sample_result> sample_p(surface_point const& view_point, double sample_primitive, vector2 const& sample_point, allocator_wrapper& allocator) const = 0;
         virtual std::optional<surface_sample_result> sample_p(double sample_primitive, vector2 const& sample_point, allocator_wrapper& allocator) const = 0;
         virtual double pdf_p(surface_point const& p) const = 0;
+
+        // the density of sample_p with view_point, surfaces that favour the primitives facing it need the primitive of p
+        virtual double pdf_p(surface_point const& view_point, surface_point const& p) const
+        {
+            return pdf_p(p);
+        }
     };
 }
\ No newline at end of file
@@ -13,6 +13,7 @@ namespace fc
     {
     public:
         vector3 const& get_position() const { return position_; }
+        vector3 const& get_position_error() const { return position_error_; }
         vector3 const& get_normal() const { return normal_; }
         vector2 const& get_uv() const { return uv_; }
 
@@ -25,8 +26,10 @@ namespace fc
         measurement const* get_measurement() const { return measurement_; }
         surface const* get_surface() const { return surface_; }
         medium const* get_medium() const { return medium_; }
+        std::uint32_t get_primitive() const { return primitive_; }
 
         void set_position(vector3 const& position) { position_ = position; }
+        void set_position_error(vector3 const& position_error) { position_error_ = position_error; }
         void set_normal(vector3 const& normal) { normal_ = normal; }
         void set_uv(vector2 const& uv) { uv_ = uv; }
 
@@ -39,6 +42,7 @@ namespace fc
         void set_measurement(measurement const* measurement) { measurement_ = measurement; }
         void set_surface(surface const* surface) { surface_ = surface; }
         void set_medium(medium const* medium) { medium_ = medium; }
+        void set_primitive(std::uint32_t primitive) { primitive_ = primitive; }
 
         void* get_measurement_data() const { return measurement_data_; }
         void set_measurement_data(void* data) { measurement_data_ = data; }
@@ -46,6 +50,7 @@ namespace fc
 
     private:
         vector3 position_{};
+        vector3 position_error_{};
         vector3 normal_{};
         vector2 uv_{};
 
@@ -57,8 +62,27 @@ namespace fc
         material const* material_{};
         surface const* surface_{};
         medium const* medium_{};
+        std::uint32_t primitive_{};
 
         measurement const* measurement_{};
         void* measurement_data_{};
     };
+    // moves the position off the surface along the normal, far enough to be outside its error bound,
+    // so a ray leaving in direction w can not hit the surface it starts on
+    inline vector3 offset_ray_origin(surface_point const& p, vector3 const& w)
+    {
+        vector3 const& n{p.get_normal()};
+        double d{dot(abs(n), p.get_position_error())};
+        vector3 offset{d * n};
+        if(dot(w, n) < 0.0) offset = -offset;
+
+        // the addition rounds as well, step one more representable value away from the surface
+        vector3 po{p.get_position() + offset};
+        for(int i{}; i < 3; ++i)
+        {
+            if(offset[i] > 0.0) po[i] = std::nextafter(po[i], std::numeric_limits<double>::infinity());
+            else if(offset[i] < 0.0) po[i] = std::nextafter(po[i], -std::numeric_limits<double>::infinity());
+        }
+        return po;
+    }
 }
\ No newline at end of file
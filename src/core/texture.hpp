@@ -1,6 +1,9 @@
 #pragma once
 #include "math.hpp"
 
+#include <cstdint>
+#include <optional>
+
 namespace fc
 {
 
@@ -11,6 +14,18 @@ namespace fc
 
         virtual vector3 evaluate(vector2 const& uv) const = 0;
         virtual vector3 integrate(vector2 const& a, vector2 const& b) const = 0;
+
+        // value of a texture that is the same everywhere, used to fold materials at scene build
+        virtual std::optional<vector3> get_constant() const
+        {
+            return {};
+        }
+
+        // identifies everything evaluate and integrate depend on, used to cache what is derived from them across runs
+        virtual std::optional<std::uint64_t> get_hash() const
+        {
+            return {};
+        }
     };
 
     class texture_2d_rg
@@ -19,6 +34,11 @@ namespace fc
         virtual ~texture_2d_rg() = default;
 
         virtual vector2 evaluate(vector2 const& uv) const = 0;
+
+        virtual std::optional<vector2> get_constant() const
+        {
+            return {};
+        }
     };
 
     class texture_2d_r
@@ -28,5 +48,10 @@ namespace fc
 
         virtual double evaluate(vector2 const& uv) const = 0;
         virtual double integrate(vector2 const& a, vector2 const& b) const = 0;
+
+        virtual std::optional<double> get_constant() const
+        {
+            return {};
+        }
     };
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "math.hpp"
+#include "simd.hpp"
 
 namespace fc
 {
@@ -18,34 +19,28 @@ namespace fc
 
         vector3 transform_point(vector3 const& p) const
         {
-            double x{t_.m[0][0] * p.x + t_.m[0][1] * p.y + t_.m[0][2] * p.z + t_.m[0][3]};
-            double y{t_.m[1][0] * p.x + t_.m[1][1] * p.y + t_.m[1][2] * p.z + t_.m[1][3]};
-            double z{t_.m[2][0] * p.x + t_.m[2][1] * p.y + t_.m[2][2] * p.z + t_.m[2][3]};
-            return {x, y, z};
+            return t_.transform_point(p);
+        }
+
+        // error bound of the transformed point, p_error is the bound the local point already has
+        vector3 transform_point_error(vector3 const& p, vector3 const& p_error) const
+        {
+            return t_.transform_point_error(p, p_error);
         }
 
         vector3 transform_direction(vector3 const& d) const
         {
-            double x{t_.m[0][0] * d.x + t_.m[0][1] * d.y + t_.m[0][2] * d.z};
-            double y{t_.m[1][0] * d.x + t_.m[1][1] * d.y + t_.m[1][2] * d.z};
-            double z{t_.m[2][0] * d.x + t_.m[2][1] * d.y + t_.m[2][2] * d.z};
-            return {x, y, z};
+            return t_.transform_vector(d);
         }
 
         vector3 inverse_transform_point(vector3 const& p) const
         {
-            double x{inv_t_.m[0][0] * p.x + inv_t_.m[0][1] * p.y + inv_t_.m[0][2] * p.z + inv_t_.m[0][3]};
-            double y{inv_t_.m[1][0] * p.x + inv_t_.m[1][1] * p.y + inv_t_.m[1][2] * p.z + inv_t_.m[1][3]};
-            double z{inv_t_.m[2][0] * p.x + inv_t_.m[2][1] * p.y + inv_t_.m[2][2] * p.z + inv_t_.m[2][3]};
-            return {x, y, z};
+            return inv_t_.transform_point(p);
         }
 
         vector3 inverse_transform_direction(vector3 const& d) const
         {
-            double x{inv_t_.m[0][0] * d.x + inv_t_.m[0][1] * d.y + inv_t_.m[0][2] * d.z};
-            double y{inv_t_.m[1][0] * d.x + inv_t_.m[1][1] * d.y + inv_t_.m[1][2] * d.z};
-            double z{inv_t_.m[2][0] * d.x + inv_t_.m[2][1] * d.y + inv_t_.m[2][2] * d.z};
-            return {x, y, z};
+            return inv_t_.transform_vector(d);
         }
 
         bounds3 transform_bounds(bounds3 const& b) const
@@ -60,8 +55,8 @@ namespace fc
 
 
     private:
-        matrix4x4 t_{matrix4x4::identity()};
-        matrix4x4 inv_t_{matrix4x4::identity()};
+        packed_matrix3x4 t_{matrix4x4::identity()};
+        packed_matrix3x4 inv_t_{matrix4x4::identity()};
     };
 
     // position, rotation and scale
@@ -83,50 +78,37 @@ namespace fc
 
         vector3 transform_point(vector3 const& p) const
         {
-            double x{t_.m[0][0] * p.x + t_.m[0][1] * p.y + t_.m[0][2] * p.z + t_.m[0][3]};
-            double y{t_.m[1][0] * p.x + t_.m[1][1] * p.y + t_.m[1][2] * p.z + t_.m[1][3]};
-            double z{t_.m[2][0] * p.x + t_.m[2][1] * p.y + t_.m[2][2] * p.z + t_.m[2][3]};
-            return {x, y, z};
+            return t_.transform_point(p);
+        }
+
+        vector3 transform_point_error(vector3 const& p, vector3 const& p_error) const
+        {
+            return t_.transform_point_error(p, p_error);
         }
 
         vector3 transform_vector(vector3 const& v) const
         {
-            double x{t_.m[0][0] * v.x + t_.m[0][1] * v.y + t_.m[0][2] * v.z};
-            double y{t_.m[1][0] * v.x + t_.m[1][1] * v.y + t_.m[1][2] * v.z};
-            double z{t_.m[2][0] * v.x + t_.m[2][1] * v.y + t_.m[2][2] * v.z};
-            return {x, y, z};
+            return t_.transform_vector(v);
         }
 
         vector3 transform_normal(vector3 const& n) const
         {
-            double x{inv_t_.m[0][0] * n.x + inv_t_.m[1][0] * n.y + inv_t_.m[2][0] * n.z};
-            double y{inv_t_.m[0][1] * n.x + inv_t_.m[1][1] * n.y + inv_t_.m[2][1] * n.z};
-            double z{inv_t_.m[0][2] * n.x + inv_t_.m[1][2] * n.y + inv_t_.m[2][2] * n.z};
-            return normalize(vector3{x, y, z});
+            return normalize(normal_t_.transform_vector(n));
         }
 
         vector3 inverse_transform_point(vector3 const& p) const
         {
-            double x{inv_t_.m[0][0] * p.x + inv_t_.m[0][1] * p.y + inv_t_.m[0][2] * p.z + inv_t_.m[0][3]};
-            double y{inv_t_.m[1][0] * p.x + inv_t_.m[1][1] * p.y + inv_t_.m[1][2] * p.z + inv_t_.m[1][3]};
-            double z{inv_t_.m[2][0] * p.x + inv_t_.m[2][1] * p.y + inv_t_.m[2][2] * p.z + inv_t_.m[2][3]};
-            return {x, y, z};
+            return inv_t_.transform_point(p);
         }
 
         vector3 inverse_transform_vector(vector3 const& v) const
         {
-            double x{inv_t_.m[0][0] * v.x + inv_t_.m[0][1] * v.y + inv_t_.m[0][2] * v.z};
-            double y{inv_t_.m[1][0] * v.x + inv_t_.m[1][1] * v.y + inv_t_.m[1][2] * v.z};
-            double z{inv_t_.m[2][0] * v.x + inv_t_.m[2][1] * v.y + inv_t_.m[2][2] * v.z};
-            return {x, y, z};
+            return inv_t_.transform_vector(v);
         }
 
         vector3 inverse_transform_normal(vector3 const& n) const
         {
-            double x{t_.m[0][0] * n.x + t_.m[1][0] * n.y + t_.m[2][0] * n.z};
-            double y{t_.m[0][1] * n.x + t_.m[1][1] * n.y + t_.m[2][1] * n.z};
-            double z{t_.m[0][2] * n.x + t_.m[1][2] * n.y + t_.m[2][2] * n.z};
-            return normalize(vector3{x, y, z});
+            return normalize(inverse_normal_t_.transform_vector(n));
         }
 
         bounds3 transform_bounds(bounds3 const& b) const
@@ -140,7 +122,9 @@ namespace fc
         }
 
     private:
-        matrix4x4 t_{matrix4x4::identity()};
-        matrix4x4 inv_t_{matrix4x4::identity()};
+        packed_matrix3x4 t_{matrix4x4::identity()};
+        packed_matrix3x4 inv_t_{matrix4x4::identity()};
+        packed_matrix3x4 normal_t_{inv_t_.transpose3x3()};
+        packed_matrix3x4 inverse_normal_t_{t_.transpose3x3()};
     };
 }
\ No newline at end of file
@@ -77,7 +77,8 @@ namespace fc
             pr_transform{},
             std::make_shared<image_texture_2d_rgb>(assets.get_image("env-loft-hall"), reconstruction_filter::bilinear, 4),
             1.0,
-            assets.get_image("env-loft-hall")->get_resolution())
+            assets.get_image("env-loft-hall")->get_resolution(),
+            assets.get_cache_directory())
         };
 
         bvh_acceleration_structure_factory acceleration_structure_factory{};
@@ -163,7 +164,8 @@ namespace fc
             pr_transform{{}, {0.0, math::deg_to_rad(-15.0), 0.0}},
             std::make_shared<image_texture_2d_rgb>(assets.get_image("env-loft-hall"), reconstruction_filter::bilinear, 4),
             1.0,
-            assets.get_image("env-loft-hall")->get_resolution())
+            assets.get_image("env-loft-hall")->get_resolution(),
+            assets.get_cache_directory())
         };
 
         bvh_acceleration_structure_factory acceleration_structure_factory{};
@@ -319,15 +321,17 @@ namespace fc
     {
         fc::assets assets{};
 
+        auto mask_textures{assets.get_packed_texture({"mask-basecolor", "mask-metalness", "mask-roughness", "mask-normal"}, fc::reconstruction_filter::bilinear, 1)};
+
         std::vector<fc::entity> entities{};
         entities.push_back({
             std::make_shared<mesh_surface>(prs_transform{}, assets.get_mesh("mask")),
             std::make_shared<standard_material>(
-                std::make_shared<image_texture_2d_rgb>(assets.get_image("mask-basecolor"), fc::reconstruction_filter::bilinear, 1),
-                std::make_shared<image_texture_2d_r>(assets.get_image("mask-metalness"), fc::reconstruction_filter::bilinear, 1),
-                std::make_shared<image_texture_2d_r>(assets.get_image("mask-roughness"), fc::reconstruction_filter::bilinear, 1),
+                std::make_shared<packed_texture_2d_rgb>(mask_textures, mask_textures->get_source_channel(0)),
+                std::make_shared<packed_texture_2d_r>(mask_textures, mask_textures->get_source_channel(1)),
+                std::make_shared<packed_texture_2d_r>(mask_textures, mask_textures->get_source_channel(2)),
                 std::make_shared<const_texture_2d_r>(1.45),
-                std::make_shared<image_texture_2d_rgb>(assets.get_image("mask-normal"), fc::reconstruction_filter::bilinear, 1)
+                std::make_shared<packed_texture_2d_rgb>(mask_textures, mask_textures->get_source_channel(3))
             )
             /*std::make_shared<mirror_material>(
                 std::make_shared<const_texture_2d_rgb>(vector3{0.8, 0.4, 0.2}),
@@ -338,7 +342,7 @@ namespace fc
 
         auto image{assets.get_image("env-loft-hall")};
         std::shared_ptr<fc::image_texture_2d_rgb> texture{new fc::image_texture_2d_rgb{image, fc::reconstruction_filter::bilinear, 4}};
-        std::shared_ptr<fc::infinity_area_light> infinity_area_light{new fc::texture_infinity_area_light{{{}, {0.0, 0.0, 0.0}}, texture, 1.0, image->get_resolution()}};
+        std::shared_ptr<fc::infinity_area_light> infinity_area_light{new fc::texture_infinity_area_light{{{}, {0.0, 0.0, 0.0}}, texture, 1.0, image->get_resolution(), assets.get_cache_directory()}};
 
 
         fc::bvh_acceleration_structure_factory acceleration_structure_factory{};
@@ -9,16 +9,36 @@ namespace fc
     class raw_image : public image
     {
     public:
-        explicit raw_image(vector2i const& resolution)
-            : resolution_{resolution}, pixels_{static_cast<std::size_t>(resolution.x) * static_cast<std::size_t>(resolution.y)}
-        { }
-        raw_image(vector2i const& resolution, std::vector<T> pixels)
-            : resolution_{resolution}, pixels_{std::move(pixels)}
-        { }
+        explicit raw_image(vector2i const& resolution, pixel_layout layout = pixel_layout::linear)
+            : indexer_{resolution, layout}
+        {
+            pixels_.resize(indexer_.get_storage_size());
+        }
+
+        // pixels are always given in row-major order and swizzled here if needed
+        raw_image(vector2i const& resolution, std::vector<T> pixels, pixel_layout layout = pixel_layout::linear)
+            : indexer_{resolution, layout}
+        {
+            if(layout == pixel_layout::linear)
+            {
+                pixels_ = std::move(pixels);
+            }
+            else
+            {
+                pixels_.resize(indexer_.get_storage_size());
+                for(int i{}; i < resolution.y; ++i)
+                {
+                    for(int j{}; j < resolution.x; ++j)
+                    {
+                        pixels_[get_pixel_index({j, i})] = pixels[static_cast<std::size_t>(resolution.x) * static_cast<std::size_t>(i) + static_cast<std::size_t>(j)];
+                    }
+                }
+            }
+        }
 
         virtual vector2i get_resolution() const override
         {
-            return resolution_;
+            return indexer_.get_resolution();
         }
 
         virtual double r(vector2i const& pixel) const override
@@ -41,13 +61,34 @@ namespace fc
             return get_pixel(pixel).rgb();
         }
 
+        pixel_layout get_layout() const
+        {
+            return indexer_.get_layout();
+        }
+
+        pixel_indexer const& get_indexer() const
+        {
+            return indexer_;
+        }
+
+        std::size_t get_pixel_index(vector2i const& pixel) const
+        {
+            return indexer_.get_pixel_index(pixel);
+        }
+
+        // in storage order, tiles and their padding included
+        std::vector<T> const& get_pixels() const
+        {
+            return pixels_;
+        }
+
     private:
-        vector2i resolution_{};
+        pixel_indexer indexer_{};
         std::vector<T> pixels_{};
 
         T const& get_pixel(vector2i const& pixel) const
         {
-            return pixels_[static_cast<std::size_t>(resolution_.x) * static_cast<std::size_t>(pixel.y) + static_cast<std::size_t>(pixel.x)];
+            return pixels_[get_pixel_index(pixel)];
         }
     };
 }
\ No newline at end of file
@@ -6,8 +6,8 @@ namespace fc
     class backward_integrator : public integrator
     {
     public:
-        explicit backward_integrator(int max_path_length)
-            : max_path_length_{max_path_length}
+        explicit backward_integrator(int max_path_length, russian_roulette russian_roulette = {})
+            : max_path_length_{max_path_length}, russian_roulette_{russian_roulette}
         { }
 
         virtual void run_once(measurement& measurement, scene const& scene, sampler& sampler, allocator_wrapper& allocator) const override
@@ -86,20 +86,21 @@ namespace fc
 
             if(max_path_length_ == 1) return;
 
+            vector3 start_beta{beta};
             int path_length{2};
             while(true)
             {
-                bsdf const* bsdf_p1{p1->get_material()->evaluate(*p1, allocator)};
-                int bxdf{bsdf_p1->sample_bxdf(sampler.get().x)};
+                bsdf bsdf_p1{p1->get_material()->evaluate(*p1)};
+                int bxdf{bsdf_p1.sample_bxdf(sampler.get().x)};
 
-                if(bsdf_p1->get_type(bxdf) != bxdf_type::delta)
+                if(bsdf_p1.get_type(bxdf) != bxdf_type::delta)
                 {
                     auto measurement_sample{measurement.sample_p(*p1, sampler.get(), allocator)};
                     if(measurement_sample)
                     {
                         vector3 d1C{measurement_sample->p->get_position() - p1->get_position()};
                         vector3 w1C{normalize(d1C)};
-                        vector3 f01C{bsdf_p1->evaluate(bxdf, w1C, w10, above_medium->get_ior(), below_medium->get_ior())};
+                        vector3 f01C{bsdf_p1.evaluate(bxdf, w1C, w10, above_medium->get_ior(), below_medium->get_ior())};
 
                         if(f01C && scene.visibility(*p1, *measurement_sample->p))
                         {
@@ -121,7 +122,7 @@ namespace fc
                 vector3 w12{};
                 vector3 value{};
                 double pdf_w12{};
-                if(bsdf_p1->sample_wo(bxdf, w10, above_medium->get_ior(), below_medium->get_ior(), sampler.get(), sampler.get(),
+                if(bsdf_p1.sample_wo(bxdf, w10, above_medium->get_ior(), below_medium->get_ior(), sampler.get(), sampler.get(),
                     &w12, &value, &pdf_w12) != sample_result::success)
                 {
                     break;
@@ -144,9 +145,18 @@ namespace fc
 
                 p1 = p2;
                 w10 = -w12;
+
+                // light paths have no pixel, so they are weighed by their throughput only
+                if(path_length < max_path_length_)
+                {
+                    double factor{russian_roulette_.roll(sampler, path_length, beta, start_beta, 0.0)};
+                    if(factor == 0.0) break;
+                    beta *= factor;
+                }
             }
         }
     private:
         int max_path_length_{};
+        russian_roulette russian_roulette_{};
     };
 }
\ No newline at end of file
@@ -6,8 +6,8 @@ namespace fc
     class bidirectional_integrator : public integrator
     {
     public:
-        explicit bidirectional_integrator(int max_path_length, bool visible_infinity_area_light)
-            : max_path_length_{max_path_length}, visible_infinity_area_light_{visible_infinity_area_light}
+        explicit bidirectional_integrator(int max_path_length, bool visible_infinity_area_light, russian_roulette russian_roulette = {})
+            : max_path_length_{max_path_length}, visible_infinity_area_light_{visible_infinity_area_light}, russian_roulette_{russian_roulette}
         { }
 
         virtual void run_once(measurement& measurement, scene const& scene, sampler& sampler, allocator_wrapper& allocator) const override
@@ -18,13 +18,14 @@ namespace fc
             helper sensor_helper{scene, allocator};
             int t_vertex_count{create_sensor_subpath(t_vertices, measurement, scene, sampler, allocator, sensor_helper)};
             
-            int sensor_max_dimensions{3 + 3 * (max_path_length_ - 1)};
+            int bounce_dimensions{3 + russian_roulette_.get_dimension_count()};
+            int sensor_max_dimensions{3 + bounce_dimensions * (max_path_length_ - 1)};
             sampler.set_dimension(sensor_max_dimensions);
 
             helper light_helper{scene, allocator};
             int s_vertex_count{create_light_subpath(s_vertices, measurement, scene, sampler, allocator, light_helper)};
 
-            int light_max_dimensions{5 + 3 * (max_path_length_ - 1)};
+            int light_max_dimensions{5 + bounce_dimensions * (max_path_length_ - 1)};
             sampler.set_dimension(sensor_max_dimensions + light_max_dimensions);
 
             vector3 Li{};
@@ -79,6 +80,7 @@ namespace fc
     private:
         int max_path_length_{};
         bool visible_infinity_area_light_{};
+        russian_roulette russian_roulette_{};
 
         struct vertex
         {
@@ -155,7 +157,7 @@ namespace fc
             vertices[1].pdf_forward = sensor_sample->pdf_wi * std::abs(dot(vertices[1].p->get_normal(), vertices[0].wi)) / sqr_length(vertices[1].p->get_position() - vertices[0].p->get_position());
             vertices[1].wo = -vertices[0].wi;
             vertices[1].beta = vertices[0].beta * sensor_sample->Wo * (std::abs(dot(vertices[0].p->get_normal(), vertices[0].wi)) / sensor_sample->pdf_wi);
-            vertices[1].bsdf = vertices[1].p->get_material()->evaluate(*vertices[1].p, allocator);
+            vertices[1].bsdf = allocator.emplace<bsdf>(vertices[1].p->get_material()->evaluate(*vertices[1].p));
             vertices[1].bxdf = vertices[1].bsdf->sample_bxdf(sampler.get().x);
             vertices[1].connectable = vertices[1].bsdf->get_type(vertices[1].bxdf) != bxdf_type::delta;
             vertex_count += 1;
@@ -165,6 +167,10 @@ namespace fc
             int v2{2};
             for(int i{2}; i <= max_path_length_; ++i)
             {
+                // the vertices so far stay, only the ones after them depend on the roulette
+                double factor{russian_roulette_.roll(sampler, i - 1, vertices[v1].beta, vertices[1].beta, measurement.get_pixel_estimate())};
+                if(factor == 0.0) return vertex_count;
+
                 double pdf_wi{};
                 vector3 value{};
                 double pdf_wo{};
@@ -183,7 +189,7 @@ namespace fc
                     {
                         vertices[v2].infity_area_light = true;
                         vertices[v2].pdf_forward = pdf_wi;
-                        vertices[v2].beta = vertices[v1].beta * value * (std::abs(dot(vertices[v1].p->get_normal(), vertices[v1].wi)) / pdf_wi);
+                        vertices[v2].beta = vertices[v1].beta * value * (factor * std::abs(dot(vertices[v1].p->get_normal(), vertices[v1].wi)) / pdf_wi);
                         vertices[v2].connectable = true;
 
                         vertices[v0].pdf_backward = pdf_wo * std::abs(dot(vertices[v0].p->get_normal(), vertices[v1].wo))
@@ -201,8 +207,8 @@ namespace fc
                 double n2_dot_wi1{dot(vertices[v2].p->get_normal(), vertices[v1].wi)};
                 vertices[v2].pdf_forward = pdf_wi * std::abs(n2_dot_wi1) / sqr_length(vertices[v2].p->get_position() - vertices[v1].p->get_position());
                 vertices[v2].wo = -vertices[v1].wi;
-                vertices[v2].beta = vertices[v1].beta * value * (std::abs(dot(vertices[v1].p->get_normal(), vertices[v1].wi)) / pdf_wi);
-                vertices[v2].bsdf = vertices[v2].p->get_material()->evaluate(*vertices[v2].p, allocator);
+                vertices[v2].beta = vertices[v1].beta * value * (factor * std::abs(dot(vertices[v1].p->get_normal(), vertices[v1].wi)) / pdf_wi);
+                vertices[v2].bsdf = allocator.emplace<bsdf>(vertices[v2].p->get_material()->evaluate(*vertices[v2].p));
                 vertices[v2].bxdf = vertices[v2].bsdf->sample_bxdf(sampler.get().x);
                 vertices[v2].connectable = vertices[v2].bsdf->get_type(vertices[v2].bxdf) != bxdf_type::delta;
 
@@ -254,7 +260,7 @@ namespace fc
                 vertices[1].pdf_backward = light_sample->pdf_wo * std::abs(dot(vertices[1].p->get_normal(), vertices[0].wo)) / sqr_length(vertices[1].p->get_position() - vertices[0].p->get_position());
                 vertices[1].wi = -vertices[0].wo;
                 vertices[1].beta = vertices[0].beta * light_sample->Le * (std::abs(dot(vertices[0].p->get_normal(), vertices[0].wo)) / light_sample->pdf_wo);
-                vertices[1].bsdf = vertices[1].p->get_material()->evaluate(*vertices[1].p, allocator);
+                vertices[1].bsdf = allocator.emplace<bsdf>(vertices[1].p->get_material()->evaluate(*vertices[1].p));
                 vertices[1].bxdf = vertices[1].bsdf->sample_bxdf(sampler.get().x);
                 vertices[1].connectable = vertices[1].bsdf->get_type(vertices[1].bxdf) != bxdf_type::delta;
                 vertex_count += 1;
@@ -284,7 +290,7 @@ namespace fc
                 vertices[1].pdf_backward = light_sample->pdf_o * std::abs(dot(vertices[1].p->get_normal(), light_sample->wi));
                 vertices[1].wi = light_sample->wi;
                 vertices[1].beta = vertices[0].beta / light_sample->pdf_o;
-                vertices[1].bsdf = vertices[1].p->get_material()->evaluate(*vertices[1].p, allocator);
+                vertices[1].bsdf = allocator.emplace<bsdf>(vertices[1].p->get_material()->evaluate(*vertices[1].p));
                 vertices[1].bxdf = vertices[1].bsdf->sample_bxdf(sampler.get().x);
                 vertices[1].connectable = vertices[1].bsdf->get_type(vertices[1].bxdf) != bxdf_type::delta;
                 vertex_count += 1;
@@ -298,6 +304,9 @@ namespace fc
 
             for(int i{2}; i <= max_path_length_; ++i)
             {
+                double factor{russian_roulette_.roll(sampler, i - 1, vertices[v1].beta, vertices[1].beta, 0.0)};
+                if(factor == 0.0) return vertex_count;
+
                 double pdf_wo{};
                 vector3 value{};
                 double pdf_wi{};
@@ -315,8 +324,8 @@ namespace fc
                 double n2_dot_wo1{dot(vertices[v2].p->get_normal(), vertices[v1].wo)};
                 vertices[v2].pdf_backward = pdf_wo * std::abs(n2_dot_wo1) / sqr_length(vertices[v2].p->get_position() - vertices[v1].p->get_position());
                 vertices[v2].wi = -vertices[v1].wo;
-                vertices[v2].beta = vertices[v1].beta * value * (std::abs(dot(vertices[v1].p->get_normal(), vertices[v1].wo)) / pdf_wo);
-                vertices[v2].bsdf = vertices[v2].p->get_material()->evaluate(*vertices[v2].p, allocator);
+                vertices[v2].beta = vertices[v1].beta * value * (factor * std::abs(dot(vertices[v1].p->get_normal(), vertices[v1].wo)) / pdf_wo);
+                vertices[v2].bsdf = allocator.emplace<bsdf>(vertices[v2].p->get_material()->evaluate(*vertices[v2].p));
                 vertices[v2].bxdf = vertices[v2].bsdf->sample_bxdf(sampler.get().x);
                 vertices[v2].connectable = vertices[v2].bsdf->get_type(vertices[v2].bxdf) != bxdf_type::delta;
 
@@ -409,7 +418,9 @@ namespace fc
                 double eta_a{t0.above_medium->get_ior()};
                 double eta_b{t0.below_medium->get_ior()};
 
-                vector3 f{t0.bsdf->evaluate(t0.bxdf, t0.wo, s0.wi, eta_a, eta_b)};
+                double pdf_wi{};
+                double pdf_wo{};
+                vector3 f{t0.bsdf->evaluate_with_pdf(t0.bxdf, t0.wo, s0.wi, eta_a, eta_b, &pdf_wi, &pdf_wo)};
                 if(!f || !scene.visibility(*t0.p, s0.wi)) return {};
 
                 vector3 Li{t0.beta * f * std::abs(dot(t0.p->get_normal(), s0.wi)) * s0.beta};
@@ -421,8 +432,8 @@ namespace fc
                     scoped_assignment sa2{s0.pdf_forward};
 
                     t0.pdf_backward = scene.get_infinity_area_light()->pdf_o() * std::abs(dot(t0.p->get_normal(), s0.wi));
-                    t1.pdf_backward = t0.bsdf->pdf_wo(t0.bxdf, t0.wo, s0.wi, eta_a, eta_b) * std::abs(dot(t1.p->get_normal(), t0.wo)) / sqr_length(t1.p->get_position() - t0.p->get_position());
-                    s0.pdf_forward = t0.bsdf->pdf_wi(t0.bxdf, t0.wo, s0.wi, eta_a, eta_b);
+                    t1.pdf_backward = pdf_wo * std::abs(dot(t1.p->get_normal(), t0.wo)) / sqr_length(t1.p->get_position() - t0.p->get_position());
+                    s0.pdf_forward = pdf_wi;
 
                     return Li * mis_weight(t_vertices, t, s_vertices, 1);
                 }
@@ -441,7 +452,11 @@ namespace fc
                 double eta_a{t0.above_medium->get_ior()};
                 double eta_b{t0.below_medium->get_ior()};
 
-                vector3 f{t0.bsdf->evaluate(t0.bxdf, t0.wo, -wo, eta_a, eta_b)};
+                vector3 wi{-wo};
+
+                double pdf_wi{};
+                double pdf_wo{};
+                vector3 f{t0.bsdf->evaluate_with_pdf(t0.bxdf, t0.wo, wi, eta_a, eta_b, &pdf_wi, &pdf_wo)};
                 if(!f || !scene.visibility(*t0.p, *s0.p)) return {};
 
                 double g{std::abs(dot(t0.p->get_normal(), wo) * dot(s0.p->get_normal(), wo)) / sqr_len};
@@ -453,11 +468,9 @@ namespace fc
                     scoped_assignment sa1{t1.pdf_backward};
                     scoped_assignment sa2{s0.pdf_forward};
 
-                    vector3 wi{-wo};
-
                     t0.pdf_backward = s0.p->get_light()->pdf_wo(*s0.p, wo) * std::abs(dot(t0.p->get_normal(), wo)) / sqr_len;
-                    t1.pdf_backward = t0.bsdf->pdf_wo(t0.bxdf, t0.wo, wi, eta_a, eta_b) * std::abs(dot(t1.p->get_normal(), t0.wo)) / sqr_length(t1.p->get_position() - t0.p->get_position());
-                    s0.pdf_forward = t0.bsdf->pdf_wi(t0.bxdf, t0.wo, wi, eta_a, eta_b) * std::abs(dot(s0.p->get_normal(), wi)) / sqr_len;
+                    t1.pdf_backward = pdf_wo * std::abs(dot(t1.p->get_normal(), t0.wo)) / sqr_length(t1.p->get_position() - t0.p->get_position());
+                    s0.pdf_forward = pdf_wi * std::abs(dot(s0.p->get_normal(), wi)) / sqr_len;
 
                     return Li * mis_weight(t_vertices, t, s_vertices, 1);
                 }
@@ -483,7 +496,8 @@ namespace fc
             double eta_a{s0.above_medium->get_ior()};
             double eta_b{s0.below_medium->get_ior()};
 
-            vector3 f{s0.bsdf->evaluate(s0.bxdf, wo, s0.wi, eta_a, eta_b)};
+            double pdf_wi{};
+            vector3 f{s0.bsdf->evaluate_with_pdf(s0.bxdf, wo, s0.wi, eta_a, eta_b, &pdf_wi)};
             if(!f || !scene.visibility(*sensor_sample->p, *s0.p)) return;
 
             double microfacet_shadowing{std::abs(dot(sensor_sample->p->get_normal(), wo) * dot(s0.p->get_normal(), wo)) / sqr_len};
@@ -499,11 +513,11 @@ namespace fc
                 s0.pdf_forward = measurement.pdf_wi(*sensor_sample->p, wi) * std::abs(dot(s0.p->get_normal(), wi)) / sqr_len;
                 if(s1.infity_area_light)
                 {
-                    s1.pdf_forward = s0.bsdf->pdf_wi(s0.bxdf, wo, s0.wi, eta_a, eta_b);
+                    s1.pdf_forward = pdf_wi;
                 }
                 else
                 {
-                    s1.pdf_forward = s0.bsdf->pdf_wi(s0.bxdf, wo, s0.wi, eta_a, eta_b) * std::abs(dot(s1.p->get_normal(), s0.wi)) / sqr_length(s1.p->get_position() - s0.p->get_position());
+                    s1.pdf_forward = pdf_wi * std::abs(dot(s1.p->get_normal(), s0.wi)) / sqr_length(s1.p->get_position() - s0.p->get_position());
                 }
 
                 measurement.add_sample(*sensor_sample->p, Li * mis_weight(nullptr, 1, s_vertices, s));
@@ -528,10 +542,14 @@ namespace fc
             double s_eta_a{s0.above_medium->get_ior()};
             double s_eta_b{s0.below_medium->get_ior()};
 
-            vector3 ft{t0.bsdf->evaluate(t0.bxdf, t0.wo, wi, t_eta_a, t_eta_b)};
+            double t_pdf_wi{};
+            double t_pdf_wo{};
+            vector3 ft{t0.bsdf->evaluate_with_pdf(t0.bxdf, t0.wo, wi, t_eta_a, t_eta_b, &t_pdf_wi, &t_pdf_wo)};
             if(!ft) return {};
 
-            vector3 fs{s0.bsdf->evaluate(s0.bxdf, wo, s0.wi, s_eta_a, s_eta_b)};
+            double s_pdf_wi{};
+            double s_pdf_wo{};
+            vector3 fs{s0.bsdf->evaluate_with_pdf(s0.bxdf, wo, s0.wi, s_eta_a, s_eta_b, &s_pdf_wi, &s_pdf_wo)};
             if(!fs || !scene.visibility(*t0.p, *s0.p)) return {};
 
             double t0_dot_wi{dot(t0.p->get_normal(), wi)};
@@ -553,18 +571,18 @@ namespace fc
                 // t1 ----- t0 --wi--> ----- <--wo-- s0 ----- s1
             
 
-                s0.pdf_forward = t0.bsdf->pdf_wi(t0.bxdf, t0.wo, wi, t_eta_a, t_eta_b) * std::abs(dot(s0.p->get_normal(), wi)) / sqr_len;
+                s0.pdf_forward = t_pdf_wi * std::abs(dot(s0.p->get_normal(), wi)) / sqr_len;
                 if(s1.infity_area_light)
                 {
-                    s1.pdf_forward = s0.bsdf->pdf_wi(s0.bxdf, wo, s0.wi, s_eta_a, s_eta_b);
+                    s1.pdf_forward = s_pdf_wi;
                 }
                 else
                 {
-                    s1.pdf_forward = s0.bsdf->pdf_wi(s0.bxdf, wo, s0.wi, s_eta_a, s_eta_b) * std::abs(dot(s1.p->get_normal(), s0.wi)) / sqr_length(s1.p->get_position() - s0.p->get_position());
+                    s1.pdf_forward = s_pdf_wi * std::abs(dot(s1.p->get_normal(), s0.wi)) / sqr_length(s1.p->get_position() - s0.p->get_position());
                 }
 
-                t0.pdf_backward = s0.bsdf->pdf_wo(s0.bxdf, wo, s0.wi, s_eta_a, s_eta_b) * std::abs(dot(t0.p->get_normal(), wo)) / sqr_len;
-                t1.pdf_backward = t0.bsdf->pdf_wo(t0.bxdf, t0.wo, wi, t_eta_a, t_eta_b) * std::abs(dot(t1.p->get_normal(), t0.wo)) / sqr_length(t1.p->get_position() - t0.p->get_position());
+                t0.pdf_backward = s_pdf_wo * std::abs(dot(t0.p->get_normal(), wo)) / sqr_len;
+                t1.pdf_backward = t_pdf_wo * std::abs(dot(t1.p->get_normal(), t0.wo)) / sqr_length(t1.p->get_position() - t0.p->get_position());
 
                 return Li * mis_weight(t_vertices, t, s_vertices, s);
             }
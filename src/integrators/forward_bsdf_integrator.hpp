@@ -8,19 +8,21 @@ namespace fc
     class forward_bsdf_integrator : public integrator
     {
     public:
-        explicit forward_bsdf_integrator(int max_path_length)
-            : max_path_length_{max_path_length}
+        explicit forward_bsdf_integrator(int max_path_length, russian_roulette russian_roulette = {})
+            : max_path_length_{max_path_length}, russian_roulette_{russian_roulette}
         { }
 
         virtual void run_once(measurement& measurement, scene const& scene, sampler& sampler, allocator_wrapper& allocator) const override
         {
             measurement.add_sample_count(1);
 
-            auto measurement_sample{measurement.sample_p_and_wi(sampler.get(), sampler.get(), allocator)};
+            auto measurement_u{sampler.get_array<2>()};
+            auto measurement_sample{measurement.sample_p_and_wi(measurement_u[0], measurement_u[1], allocator)};
             if(!measurement_sample) return;
 
             vector3 Li{};
             vector3 beta{measurement_sample->Wo * (std::abs(dot(measurement_sample->p->get_normal(), measurement_sample->wi)) / (measurement_sample->pdf_p * measurement_sample->pdf_wi))};
+            vector3 start_beta{beta};
 
             helper helper{scene, allocator};
             medium const* above_medium{};
@@ -46,14 +48,16 @@ namespace fc
 
                 for(int i{2}; i <= max_path_length_; ++i)
                 {
-                    bsdf const* bsdf_p1{p1->get_material()->evaluate(*p1, allocator)};
-                    int bxdf{bsdf_p1->sample_bxdf(sampler.get().x)};
+                    auto u{sampler.get_array<3>()};
+
+                    bsdf bsdf_p1{p1->get_material()->evaluate(*p1)};
+                    int bxdf{bsdf_p1.sample_bxdf(u[0].x)};
 
                     vector3 w12{};
                     vector3 value{};
                     double pdf_w12{};
 
-                    if(bsdf_p1->sample_wi(bxdf, w10, above_medium->get_ior(), below_medium->get_ior(), sampler.get(), sampler.get(),
+                    if(bsdf_p1.sample_wi(bxdf, w10, above_medium->get_ior(), below_medium->get_ior(), u[1], u[2],
                         &w12, &value, &pdf_w12) != sample_result::success)
                     {
                         break;
@@ -92,6 +96,13 @@ namespace fc
                         p1 = p2;
                         w10 = w21;
                     }
+
+                    if(i < max_path_length_)
+                    {
+                        double factor{russian_roulette_.roll(sampler, i, beta, start_beta, measurement.get_pixel_estimate())};
+                        if(factor == 0.0) break;
+                        beta *= factor;
+                    }
                 }
             }
 
@@ -99,5 +110,6 @@ namespace fc
         }
     private:
         int max_path_length_{};
+        russian_roulette russian_roulette_{};
     };
 }
\ No newline at end of file
@@ -6,19 +6,21 @@ namespace fc
     class forward_mis_integrator : public integrator
     {
     public:
-        explicit forward_mis_integrator(int max_path_length, bool visible_infinity_area_light)
-            : max_path_length_{max_path_length}, visible_infinity_area_light_{visible_infinity_area_light}
+        explicit forward_mis_integrator(int max_path_length, bool visible_infinity_area_light, russian_roulette russian_roulette = {})
+            : max_path_length_{max_path_length}, visible_infinity_area_light_{visible_infinity_area_light}, russian_roulette_{russian_roulette}
         { }
 
         virtual void run_once(measurement& measurement, scene const& scene, sampler& sampler, allocator_wrapper& allocator) const override
         {
             measurement.add_sample_count(1);
 
-            auto measurement_sample{measurement.sample_p_and_wi(sampler.get(), sampler.get(), allocator)};
+            auto measurement_u{sampler.get_array<2>()};
+            auto measurement_sample{measurement.sample_p_and_wi(measurement_u[0], measurement_u[1], allocator)};
             if(!measurement_sample) return;
 
             vector3 Li{};
             vector3 beta{measurement_sample->Wo * (std::abs(dot(measurement_sample->p->get_normal(), measurement_sample->wi)) / (measurement_sample->pdf_p * measurement_sample->pdf_wi))};
+            vector3 start_beta{beta};
 
             helper helper{scene, allocator};
             medium const* above_medium{};
@@ -44,58 +46,56 @@ namespace fc
 
                 for(int i{2}; i <= max_path_length_; ++i)
                 {
-                    bsdf const* bsdf{p1->get_material()->evaluate(*p1, allocator)};
-                    int bxdf{bsdf->sample_bxdf(sampler.get().x)};
+                    // the bxdf, light, light sample and bsdf sample dimensions of the vertex, used or not
+                    auto u{sampler.get_array<6>()};
 
-                    if(bsdf->get_type(bxdf) == bxdf_type::standard)
+                    bsdf bsdf{p1->get_material()->evaluate(*p1)};
+                    int bxdf{bsdf.sample_bxdf(u[0].x)};
+
+                    if(bsdf.get_type(bxdf) == bxdf_type::standard)
                     {
                         // light strategy
                         {
-                            auto [light, pdf_light] {scene.get_spatial_light_distribution()->get(*p1)->sample(sampler.get().x)};
-                            if(light->get_type() == light_type::infinity_area)
+                            auto [light, pdf_light] {scene.get_spatial_light_distribution()->sample(*p1, u[1].x)};
+                            if(light != nullptr && light->get_type() == light_type::infinity_area)
                             {
                                 auto inf_light{static_cast<infinity_area_light const*>(light)};
-                                auto light_sample{inf_light->sample_wi(sampler.get())};
+                                auto light_sample{inf_light->sample_wi(u[2])};
                                 if(light_sample)
                                 {
-                                    vector3 fL10{bsdf->evaluate(bxdf, w10, light_sample->wi, above_medium->get_ior(), below_medium->get_ior())};
+                                    double pdf_bsdf_w1L{};
+                                    vector3 fL10{bsdf.evaluate_with_pdf(bxdf, w10, light_sample->wi, above_medium->get_ior(), below_medium->get_ior(), &pdf_bsdf_w1L)};
 
                                     if(fL10 && scene.visibility(*p1, light_sample->wi))
                                     {
-                                        double pdf_bsdf_w1L{bsdf->pdf_wi(bxdf, w10, light_sample->wi, above_medium->get_ior(), below_medium->get_ior())};
                                         double pdf_light_w1L{pdf_light * light_sample->pdf_wi};
                                         double weight{power_heuristics(pdf_light_w1L, pdf_bsdf_w1L)};
                                         Li += (beta * fL10 * light_sample->Li) * (weight * std::abs(dot(p1->get_normal(), light_sample->wi)) / pdf_light_w1L);
                                     }
                                 }
-
-                                sampler.advance_dimension();
                             }
-                            else if(light->get_type() == light_type::standard)
+                            else if(light != nullptr && light->get_type() == light_type::standard)
                             {
                                 auto std_light{static_cast<standard_light const*>(light)};
-                                auto light_sample{std_light->sample_p(*p1, sampler.get().x, sampler.get(), allocator)};
+                                auto light_sample{std_light->sample_p(*p1, u[2].x, u[3], allocator)};
                                 if(light_sample)
                                 {
                                     vector3 d1L{light_sample->p->get_position() - p1->get_position()};
                                     vector3 w1L{normalize(d1L)};
-                                    vector3 fL10{bsdf->evaluate(bxdf, w10, w1L, above_medium->get_ior(), below_medium->get_ior())};
+                                    double pdf_bsdf_w1L{};
+                                    vector3 fL10{bsdf.evaluate_with_pdf(bxdf, w10, w1L, above_medium->get_ior(), below_medium->get_ior(), &pdf_bsdf_w1L)};
 
                                     if(fL10 && scene.visibility(*p1, *light_sample->p))
                                     {
                                         double x{std::abs(dot(light_sample->p->get_normal(), w1L)) / sqr_length(d1L)};
                                         double G1L{std::abs(dot(p1->get_normal(), w1L)) * x};
-                                        double pdf_bsdf_pL{bsdf->pdf_wi(bxdf, w10, w1L, above_medium->get_ior(), below_medium->get_ior()) * x};
+                                        double pdf_bsdf_pL{pdf_bsdf_w1L * x};
                                         double pdf_light_pL{pdf_light * light_sample->pdf_p};
                                         double weight{power_heuristics(pdf_light_pL, pdf_bsdf_pL)};
                                         Li += (beta * fL10 * G1L * light_sample->Le) * (weight / pdf_light_pL);
                                     }
                                 }
                             }
-                            else
-                            {
-                                sampler.advance_dimension(2);
-                            }
                         }
 
                         // bsdf strategy
@@ -103,7 +103,7 @@ namespace fc
                         vector3 value{};
                         double pdf_w12{};
 
-                        if(bsdf->sample_wi(bxdf, w10, above_medium->get_ior(), below_medium->get_ior(), sampler.get(), sampler.get(),
+                        if(bsdf.sample_wi(bxdf, w10, above_medium->get_ior(), below_medium->get_ior(), u[4], u[5],
                             &w12, &value, &pdf_w12) != sample_result::success)
                         {
                             break;
@@ -116,7 +116,7 @@ namespace fc
                         {
                             if(scene.get_infinity_area_light() != nullptr)
                             {
-                                double pdf_light{scene.get_spatial_light_distribution()->get(*p1)->pdf(scene.get_infinity_area_light())};
+                                double pdf_light{scene.get_spatial_light_distribution()->pdf(*p1, scene.get_infinity_area_light())};
                                 double pdf_light_w12{pdf_light * scene.get_infinity_area_light()->pdf_wi(w12)};
                                 double weight{power_heuristics(pdf_w12, pdf_light_w12)};
                                 Li += weight * beta * scene.get_infinity_area_light()->get_Li(w12);
@@ -139,8 +139,8 @@ namespace fc
 
                             if(p2->get_light() != nullptr)
                             {
-                                double pdf_light{scene.get_spatial_light_distribution()->get(*p1)->pdf(p2->get_light())};
-                                double pdf_light_p2{pdf_light * p2->get_light()->pdf_p(*p2)};
+                                double pdf_light{scene.get_spatial_light_distribution()->pdf(*p1, p2->get_light())};
+                                double pdf_light_p2{pdf_light * p2->get_light()->pdf_p(*p1, *p2)};
                                 double pdf_bsdf_p2{pdf_w12 * std::abs(dot(p2->get_normal(), w12)) / sqr_length(p2->get_position() - p1->get_position())};
                                 double weight{power_heuristics(pdf_bsdf_p2, pdf_light_p2)};
                                 Li += weight * beta * p2->get_light()->get_Le(*p2, w21);
@@ -150,16 +150,14 @@ namespace fc
                             w10 = w21;
                         }
                     }
-                    else if(bsdf->get_type(bxdf) == bxdf_type::delta)
+                    else if(bsdf.get_type(bxdf) == bxdf_type::delta)
                     {
-                        sampler.advance_dimension(3);
-
                         // bsdf strategy
                         vector3 w12{};
                         vector3 value{};
                         double pdf_w12{};
 
-                        if(bsdf->sample_wi(bxdf, w10, above_medium->get_ior(), below_medium->get_ior(), sampler.get(), sampler.get(),
+                        if(bsdf.sample_wi(bxdf, w10, above_medium->get_ior(), below_medium->get_ior(), u[4], u[5],
                             &w12, &value, &pdf_w12) != sample_result::success)
                         {
                             break;
@@ -203,6 +201,13 @@ namespace fc
                     {
                         break;
                     }
+
+                    if(i < max_path_length_)
+                    {
+                        double factor{russian_roulette_.roll(sampler, i, beta, start_beta, measurement.get_pixel_estimate())};
+                        if(factor == 0.0) break;
+                        beta *= factor;
+                    }
                 }
             }
 
@@ -211,6 +216,7 @@ namespace fc
     private:
         int max_path_length_{};
         bool visible_infinity_area_light_{};
+        russian_roulette russian_roulette_{};
 
         static double power_heuristics(double primary_pdf, double alternative_pdf)
         {
@@ -0,0 +1,97 @@
+#pragma once
+#include "../core/light_distribution.hpp"
+#include "../core/light_bvh.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace fc
+{
+    // picks lights by how much they can light the receiver, from a light bvh over their bounds, power and the cones of
+    // their normals; lights without bounds get an equal share of their own
+    class bvh_light_distribution : public spatial_light_distribution
+    {
+        static constexpr double double_one_minus_epsilon{0x1.fffffffffffffp-1};
+        static constexpr std::uint32_t no_bvh_index{std::numeric_limits<std::uint32_t>::max()};
+
+    public:
+        explicit bvh_light_distribution(std::vector<light const*> lights)
+        {
+            std::vector<light_bounds> items{};
+            bvh_indices_.resize(lights.size(), no_bvh_index);
+            for(light const* light : lights)
+            {
+                if(auto bounds{light->get_bounds()})
+                {
+                    bvh_indices_[light->get_index()] = static_cast<std::uint32_t>(bounded_lights_.size());
+                    bounded_lights_.push_back(light);
+                    items.push_back(*bounds);
+                }
+                else
+                {
+                    unbounded_lights_.push_back(light);
+                }
+            }
+
+            bvh_ = light_bvh{items};
+
+            if(!unbounded_lights_.empty())
+            {
+                double unbounded_count{static_cast<double>(unbounded_lights_.size())};
+                unbounded_probability_ = unbounded_count / (unbounded_count + (bounded_lights_.empty() ? 0.0 : 1.0));
+            }
+        }
+
+        virtual light_distribution_sample_result sample(surface_point const& p, double sample_picking) const override
+        {
+            if(sample_picking < unbounded_probability_)
+            {
+                double u{sample_picking / unbounded_probability_};
+                std::size_t index{std::min(static_cast<std::size_t>(u * static_cast<double>(unbounded_lights_.size())), unbounded_lights_.size() - 1)};
+                return {unbounded_lights_[index], unbounded_probability_ / static_cast<double>(unbounded_lights_.size())};
+            }
+
+            double u{std::min((sample_picking - unbounded_probability_) / (1.0 - unbounded_probability_), double_one_minus_epsilon)};
+            auto bvh_sample{bvh_.sample(p.get_position(), p.get_normal(), u)};
+            if(!bvh_sample) return {};
+
+            return {bounded_lights_[bvh_sample->index], (1.0 - unbounded_probability_) * bvh_sample->pdf_index};
+        }
+
+        virtual double pdf(surface_point const& p, light const* light) const override
+        {
+            std::uint32_t bvh_index{bvh_indices_[light->get_index()]};
+            if(bvh_index == no_bvh_index) return unbounded_probability_ / static_cast<double>(unbounded_lights_.size());
+
+            return (1.0 - unbounded_probability_) * bvh_.pdf(p.get_position(), p.get_normal(), bvh_index);
+        }
+
+        virtual void update() override
+        {
+            std::vector<light_bounds> items{};
+            items.reserve(bounded_lights_.size());
+            for(light const* light : bounded_lights_)
+            {
+                items.push_back(*light->get_bounds());
+            }
+
+            bvh_.refit(items);
+        }
+
+    private:
+        std::vector<light const*> bounded_lights_{};
+        std::vector<light const*> unbounded_lights_{};
+        std::vector<std::uint32_t> bvh_indices_{};
+        light_bvh bvh_{};
+        double unbounded_probability_{};
+    };
+
+    class bvh_spatial_light_distribution_factory : public spatial_light_distribution_factory
+    {
+    public:
+        virtual std::unique_ptr<spatial_light_distribution> create(std::vector<light const*> lights) const override
+        {
+            return std::unique_ptr<spatial_light_distribution>(new bvh_light_distribution{std::move(lights)});
+        }
+    };
+}
\ No newline at end of file
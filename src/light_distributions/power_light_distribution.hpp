@@ -0,0 +1,69 @@
+#pragma once
+#include "../core/light_distribution.hpp"
+#include "../core/distribution.hpp"
+
+namespace fc
+{
+    // picks lights in proportion to their power from an alias table, the pdf of a light is found by its index
+    class power_light_distribution : public light_distribution, public spatial_light_distribution
+    {
+    public:
+        explicit power_light_distribution(std::vector<light const*> lights)
+            : lights_{std::move(lights)}, distribution_{get_powers(lights_)}
+        { }
+
+        virtual light_distribution_sample_result sample(double sample_picking) const override
+        {
+            auto [index, pdf_index] {distribution_.sample_discrete(sample_picking)};
+            return {lights_[index], pdf_index};
+        }
+
+        virtual double pdf(light const* light) const override
+        {
+            return distribution_.pdf_discrete(light->get_index());
+        }
+
+        virtual light_distribution_sample_result sample(surface_point const&, double sample_picking) const override
+        {
+            return sample(sample_picking);
+        }
+
+        virtual double pdf(surface_point const&, light const* light) const override
+        {
+            return pdf(light);
+        }
+
+    private:
+        std::vector<light const*> lights_{};
+        alias_distribution_1d distribution_;
+
+        static std::vector<double> get_powers(std::vector<light const*> const& lights)
+        {
+            std::vector<double> powers{};
+            powers.reserve(lights.size());
+            for(light const* light : lights)
+            {
+                powers.push_back(max_component(light->get_power()));
+            }
+            return powers;
+        }
+    };
+
+    class power_light_distribution_factory : public light_distribution_factory
+    {
+    public:
+        virtual std::unique_ptr<light_distribution> create(std::vector<light const*> lights) const override
+        {
+            return std::unique_ptr<light_distribution>(new power_light_distribution{std::move(lights)});
+        }
+    };
+
+    class power_spatial_light_distribution_factory : public spatial_light_distribution_factory
+    {
+    public:
+        virtual std::unique_ptr<spatial_light_distribution> create(std::vector<light const*> lights) const override
+        {
+            return std::unique_ptr<spatial_light_distribution>(new power_light_distribution{std::move(lights)});
+        }
+    };
+}
\ No newline at end of file
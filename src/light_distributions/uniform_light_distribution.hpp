@@ -21,9 +21,14 @@ namespace fc
             return 1.0 / static_cast<double>(lights_.size());
         }
 
-        virtual light_distribution const* get(surface_point const&) const override
+        virtual light_distribution_sample_result sample(surface_point const&, double sample_picking) const override
         {
-            return this;
+            return sample(sample_picking);
+        }
+
+        virtual double pdf(surface_point const&, light const* light) const override
+        {
+            return pdf(light);
         }
 
     private:
@@ -17,6 +17,39 @@ namespace fc
             return (surface_->get_area() * math::pi * strength_) * color_;
         }
 
+        virtual std::optional<light_bounds> get_bounds() const override
+        {
+            // the cone around the normals of all primitives, over the hemisphere around each of them
+            light_bounds normal_bounds{};
+            for(std::uint32_t i{}; i < surface_->get_primitive_count() && normal_bounds.cos_theta_o != -1.0f; ++i)
+            {
+                light_bounds primitive_bounds{};
+                primitive_bounds.phi = 1.0f;
+                primitive_bounds.cos_theta_o = -1.0f;
+
+                auto shape{surface_->get_shape(i)};
+                if(auto triangle{shape ? std::get_if<surface_triangle>(&*shape) : nullptr})
+                {
+                    vector3 normal{cross(vector3{triangle->p1 - triangle->p0}, vector3{triangle->p2 - triangle->p0})};
+                    if(sqr_length(normal) == 0.0) continue;
+
+                    primitive_bounds.w = normalize(normal);
+                    primitive_bounds.cos_theta_o = 1.0f;
+                }
+                else if(auto plane{shape ? std::get_if<surface_plane>(&*shape) : nullptr})
+                {
+                    primitive_bounds.w = plane->normal;
+                    primitive_bounds.cos_theta_o = 1.0f;
+                }
+                normal_bounds = Union(normal_bounds, primitive_bounds);
+            }
+
+            light_bounds result{surface_->get_bounds(), normal_bounds.w};
+            result.phi = static_cast<float>(max_component(get_power()));
+            result.cos_theta_o = normal_bounds.cos_theta_o;
+            return result;
+        }
+
         virtual vector3 get_Le(surface_point const& p, vector3 const& wo) const override
         {
             if(p.get_light() != this || p.get_surface() != surface_) return {};
@@ -70,6 +103,12 @@ namespace fc
             return surface_->pdf_p(p);
         }
 
+        virtual double pdf_p(surface_point const& view_point, surface_point const& p) const override
+        {
+            if(p.get_light() != this) return {};
+            return surface_->pdf_p(view_point, p);
+        }
+
         virtual double pdf_wo(surface_point const& p, vector3 const& wo) const override
         {
             if(p.get_light() != this || p.get_surface() != surface_) return {};
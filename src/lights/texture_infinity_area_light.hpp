@@ -3,38 +3,40 @@
 #include "../core/transform.hpp"
 #include "../core/texture.hpp"
 #include "../core/distribution.hpp"
+#include "../core/spherical_mapping.hpp"
 #include "../core/color.hpp"
+#include "../core/parallel.hpp"
 
+#include <filesystem>
+#include <fstream>
 #include <memory>
+#include <random>
+#include <string>
+
+#define XXH_INLINE_ALL
+#include "../lib/xxhash.h"
 
 namespace fc
 {
     class texture_infinity_area_light : public infinity_area_light
     {
     public:
-        texture_infinity_area_light(pr_transform const& transform, std::shared_ptr<texture_2d_rgb> texture, double strength, vector2i const& radiance_distribution_resolution)
+        // with a cache directory the radiance function is stored there under a hash of the texture and the resolution,
+        // and later lights with the same texture load it instead of integrating the texture again
+        texture_infinity_area_light(pr_transform const& transform, std::shared_ptr<texture_2d_rgb> texture, double strength, vector2i const& radiance_distribution_resolution,
+            std::filesystem::path const& cache_directory = {})
             : transform_{transform}, texture_{std::move(texture)}, strength_{strength}
         {
-            std::vector<std::vector<double>> radiance_function{};
-            radiance_function.reserve(radiance_distribution_resolution.y);
-
-            double delta_u{static_cast<double>(radiance_distribution_resolution.x)};
-            double delta_v{static_cast<double>(radiance_distribution_resolution.y)};
+            std::filesystem::path cache_path{get_cache_path(cache_directory, radiance_distribution_resolution)};
 
-            for(int i{}; i < radiance_distribution_resolution.y; ++i)
+            std::vector<double> radiance_function{};
+            if(cache_path.empty() || !load_radiance_function(cache_path, radiance_distribution_resolution, radiance_function))
             {
-                auto& row{radiance_function.emplace_back()};
-                double sin_theta{std::sin(math::pi * (i + 0.5) / radiance_distribution_resolution.y)};
-                row.reserve(radiance_distribution_resolution.x);
-                for(int j{}; j < radiance_distribution_resolution.x; ++j)
-                {
-                    vector3 integral{texture_->integrate({j / delta_u, i / delta_v}, {(j + 1) / delta_u, (i + 1) / delta_v})};
-                    power_ += integral * sin_theta;
-                    row.push_back(luminance(integral) * sin_theta);
-                }
+                radiance_function = integrate_radiance_function(radiance_distribution_resolution);
+                if(!cache_path.empty()) save_radiance_function(cache_path, radiance_distribution_resolution, radiance_function);
             }
 
-            radiance_distribution_.reset(new distribution_2d{std::move(radiance_function)});
+            radiance_distribution_.reset(new distribution_2d{std::move(radiance_function), radiance_distribution_resolution});
         }
 
         virtual void set_scene_bounds(bounds3 const& bounds) override
@@ -52,15 +54,7 @@ namespace fc
         virtual vector3 get_Li(vector3 const& wi) const override
         {
             vector3 w{transform_.inverse_transform_direction(wi)};
-
-            double theta{std::acos(std::clamp(w.y, -1.0, 1.0))};
-            double p{std::atan2(w.z, w.x)};
-            double phi{p < 0.0 ? p + 2.0 * math::pi : p};
-
-            double v{theta / math::pi};
-            double u{1.0 - phi / (2.0 * math::pi)};
-
-            return texture_->evaluate({u, v}) * strength_;
+            return texture_->evaluate(spherical_mapping::direction_to_uv(w)) * strength_;
         }
 
         virtual std::optional<infinity_area_light_sample_wi_result> sample_wi(vector2 const& sample_direction) const override
@@ -68,20 +62,13 @@ namespace fc
             std::optional<infinity_area_light_sample_wi_result> result{};
             auto uv_sample{radiance_distribution_->sample_continuous(sample_direction)};
 
-            double theta{uv_sample.xy.y * math::pi};
-            double phi{(1.0 - uv_sample.xy.x) * 2.0 * math::pi};
-
-            double cos_theta{std::cos(theta)};
-            double sin_theta{std::sin(theta)};
-            double cos_phi{std::cos(phi)};
-            double sin_phi{std::sin(phi)};
+            vector3 w{spherical_mapping::uv_to_direction(uv_sample.xy)};
+            double sin_theta{std::sqrt(w.x * w.x + w.z * w.z)};
 
             if(sin_theta == 0.0) return result;
             vector3 Li{texture_->evaluate(uv_sample.xy) * strength_};
             if(!Li) return result;
 
-            vector3 w{sin_theta * cos_phi, cos_theta, sin_theta * sin_phi};
-
             result.emplace();
             result->wi = transform_.transform_direction(w);
             result->pdf_wi = uv_sample.pdf_xy / (2.0 * math::pi * math::pi * sin_theta);
@@ -117,17 +104,10 @@ namespace fc
         {
             vector3 w{transform_.inverse_transform_direction(wi)};
 
-            double theta{std::acos(std::clamp(w.y, -1.0, 1.0))};
-            double p{std::atan2(w.z, w.x)};
-            double phi{p < 0.0 ? p + 2.0 * math::pi : p};
-
-            double sin_theta{std::sin(theta)};
+            double sin_theta{std::sqrt(w.x * w.x + w.z * w.z)};
             if(sin_theta == 0.0) return 0.0;
 
-            double v{theta / math::pi};
-            double u{1.0 - phi / (2.0 * math::pi)};
-
-            return radiance_distribution_->pdf_continuous({u, v}) / (2.0 * math::pi * math::pi * sin_theta);
+            return radiance_distribution_->pdf_continuous(spherical_mapping::direction_to_uv(w)) / (2.0 * math::pi * math::pi * sin_theta);
         }
 
         virtual double pdf_o() const override
@@ -136,6 +116,110 @@ namespace fc
         }
 
     private:
+        static constexpr std::uint64_t cache_version{1};
+
+        // rows are integrated in parallel and their power summed in order, so the result does not depend on the
+        // number of threads
+        std::vector<double> integrate_radiance_function(vector2i const& resolution)
+        {
+            std::size_t width{static_cast<std::size_t>(resolution.x)};
+            std::size_t height{static_cast<std::size_t>(resolution.y)};
+            double delta_u{static_cast<double>(resolution.x)};
+            double delta_v{static_cast<double>(resolution.y)};
+
+            std::vector<double> radiance_function(width * height);
+            std::vector<vector3> row_powers(height);
+            parallel_chunks(height, std::min(get_parallel_chunk_count(width * height), height),
+                [&] (std::size_t, std::size_t begin, std::size_t end)
+                {
+                    for(std::size_t i{begin}; i < end; ++i)
+                    {
+                        double sin_theta{std::sin(math::pi * (i + 0.5) / delta_v)};
+                        vector3 row_power{};
+                        for(std::size_t j{}; j < width; ++j)
+                        {
+                            vector3 integral{texture_->integrate({j / delta_u, i / delta_v}, {(j + 1) / delta_u, (i + 1) / delta_v})};
+                            row_power += integral * sin_theta;
+                            radiance_function[i * width + j] = luminance(integral) * sin_theta;
+                        }
+                        row_powers[i] = row_power;
+                    }
+                }
+            );
+
+            for(vector3 const& row_power : row_powers)
+            {
+                power_ += row_power;
+            }
+
+            return radiance_function;
+        }
+
+        std::filesystem::path get_cache_path(std::filesystem::path const& cache_directory, vector2i const& resolution) const
+        {
+            if(cache_directory.empty()) return {};
+
+            std::optional<std::uint64_t> texture_hash{texture_->get_hash()};
+            if(!texture_hash) return {};
+
+            std::uint64_t key[]{cache_version, *texture_hash, static_cast<std::uint64_t>(resolution.x), static_cast<std::uint64_t>(resolution.y)};
+            return cache_directory / (std::to_string(XXH64(key, sizeof(key), 0)) + ".radiance");
+        }
+
+        // the file holds the resolution, the power and the radiance function; anything that does not fit is ignored
+        // and integrated again
+        bool load_radiance_function(std::filesystem::path const& path, vector2i const& resolution, std::vector<double>& radiance_function)
+        {
+            std::size_t cell_count{static_cast<std::size_t>(resolution.x) * static_cast<std::size_t>(resolution.y)};
+            std::uintmax_t expected_size{sizeof(vector2i) + sizeof(vector3) + cell_count * sizeof(double)};
+
+            std::error_code error{};
+            std::uintmax_t size{std::filesystem::file_size(path, error)};
+            if(error || size != expected_size) return false;
+
+            std::ifstream file{path, std::ios::in | std::ios::binary};
+            vector2i file_resolution{};
+            vector3 power{};
+            radiance_function.resize(cell_count);
+            file.read(reinterpret_cast<char*>(&file_resolution), sizeof(vector2i));
+            file.read(reinterpret_cast<char*>(&power), sizeof(vector3));
+            file.read(reinterpret_cast<char*>(radiance_function.data()), cell_count * sizeof(double));
+            if(!file || file_resolution != resolution) return false;
+
+            power_ = power;
+            return true;
+        }
+
+        void save_radiance_function(std::filesystem::path const& path, vector2i const& resolution, std::vector<double> const& radiance_function) const
+        {
+            std::error_code error{};
+            std::filesystem::create_directories(path.parent_path(), error);
+
+            // written to a file of its own in the same directory and renamed over the cache, so a run that stops
+            // halfway or another one reading the cache never sees part of a file; a cache that cannot be written only
+            // costs the next run the integration
+            std::filesystem::path temporary_path{path};
+            temporary_path += "." + std::to_string(std::random_device{}()) + ".tmp";
+            {
+                std::ofstream file{temporary_path, std::ios::out | std::ios::binary | std::ios::trunc};
+                file.write(reinterpret_cast<char const*>(&resolution), sizeof(vector2i));
+                file.write(reinterpret_cast<char const*>(&power_), sizeof(vector3));
+                file.write(reinterpret_cast<char const*>(radiance_function.data()), radiance_function.size() * sizeof(double));
+                file.close();
+                if(!file)
+                {
+                    std::filesystem::remove(temporary_path, error);
+                    return;
+                }
+            }
+
+            std::filesystem::rename(temporary_path, path, error);
+            if(error)
+            {
+                std::filesystem::remove(temporary_path, error);
+            }
+        }
+
         pr_transform transform_{};
         std::shared_ptr<texture_2d_rgb> texture_{};
         double strength_{};
@@ -1,4 +1,5 @@
 #include "example_scenes.hpp"
+#include "benchmarks.hpp"
 
 int main()
 {
@@ -8,5 +9,16 @@ int main()
     //fc::scene_normals();
     fc::scene_mask();
 
+    //fc::benchmark_image_layout();
+    //fc::benchmark_math();
+    //fc::benchmark_bvh_build();
+    //fc::benchmark_bvh_build_large();
+    //fc::benchmark_bvh_refit();
+    //fc::benchmark_sampler_convergence();
+    //fc::benchmark_sampler_throughput();
+    //fc::benchmark_russian_roulette();
+    //fc::benchmark_many_lights();
+    //fc::benchmark_distribution_sampling();
+
     return 0;
 }
\ No newline at end of file
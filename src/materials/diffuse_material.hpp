@@ -3,6 +3,7 @@
 #include "../bsdfs/lambertian_reflection.hpp"
 #include "../bsdfs/normal_mapping.hpp"
 #include "../core/texture.hpp"
+#include "precomputed_material.hpp"
 
 #include <memory>
 
@@ -15,30 +16,52 @@ namespace fc
             : reflectance_{std::move(reflectance)}, normal_{std::move(normal)}
         { }
 
-        virtual bsdf const* evaluate(surface_point const& p, allocator_wrapper& allocator) const override
+        virtual bsdf evaluate(surface_point const& p) const override
+        {
+            bxdf bxdf{};
+            double scale{};
+            double weight{};
+            evaluate_bxdfs(p.get_uv(), &bxdf, &scale, &weight);
+
+            return bsdf{p.get_shading_tangent(), p.get_shading_normal(), p.get_shading_bitangent(), p.get_normal(),
+                1, &bxdf, &scale, &weight};
+        }
+
+        virtual std::shared_ptr<material> compile() const override
+        {
+            if(!reflectance_->get_constant()) return nullptr;
+            if(normal_ != nullptr && !normal_->get_constant()) return nullptr;
+
+            return std::make_shared<precomputed_material>(
+                [this] (bxdf* bxdfs, double* scales, double* weights)
+                {
+                    return evaluate_bxdfs({}, bxdfs, scales, weights);
+                }
+            );
+        }
+
+    private:
+        std::shared_ptr<texture_2d_rgb> reflectance_{};
+        std::shared_ptr<texture_2d_rgb> normal_{};
+
+        int evaluate_bxdfs(vector2 const& uv, bxdf* bxdfs, double* scales, double* weights) const
         {
             vector3 n{0.0, 1.0, 0.0};
             if(normal_ != nullptr)
             {
-                n = normal_->evaluate(p.get_uv()) * 2.0 - 1.0;
+                n = normal_->evaluate(uv) * 2.0 - 1.0;
                 std::swap(n.y, n.z);
                 n = normalize(n);
                 if(n.y < 0.0) n = -n;
             }
 
-            bxdf const* bxdf{allocator.emplace<bxdf_adapter<normal_mapping<lambertian_reflection>>>(
-                normal_mapping<lambertian_reflection>{n, lambertian_reflection{reflectance_->evaluate(p.get_uv())}}
-            )};
-
-            double scale{1.0};
-            double weight{1.0};
+            bxdfs[0] = bxdf{
+                normal_mapping<lambertian_reflection>{n, lambertian_reflection{reflectance_->evaluate(uv)}}
+            };
 
-            return allocator.emplace<bsdf>(p.get_shading_tangent(), p.get_shading_normal(), p.get_shading_bitangent(), p.get_normal(),
-                1, &bxdf, &scale, &weight);
+            scales[0] = 1.0;
+            weights[0] = 1.0;
+            return 1;
         }
-
-    private:
-        std::shared_ptr<texture_2d_rgb> reflectance_{};
-        std::shared_ptr<texture_2d_rgb> normal_{};
     };
 }
\ No newline at end of file
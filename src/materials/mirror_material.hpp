@@ -5,6 +5,7 @@
 #include "../bsdfs/microfacet_reflection.hpp"
 #include "../bsdfs/specular_reflection.hpp"
 #include "../bsdfs/normal_mapping.hpp"
+#include "precomputed_material.hpp"
 
 #include <memory>
 
@@ -17,19 +18,44 @@ namespace fc
             : reflectance_{std::move(reflectance)}, roughness_{std::move(roughness)}, normal_{std::move(normal)}
         { }
 
-        virtual bsdf const* evaluate(surface_point const& p, allocator_wrapper& allocator) const override
+        virtual bsdf evaluate(surface_point const& p) const override
         {
-            bxdf const* bxdf{};
-            double scale{1.0};
-            double weight{1.0};
+            bxdf bxdf{};
+            double scale{};
+            double weight{};
+            evaluate_bxdfs(p.get_uv(), &bxdf, &scale, &weight);
 
-            vector3 reflectance{reflectance_->evaluate(p.get_uv())};
-            vector2 roughness{roughness_->evaluate(p.get_uv())};
+            return bsdf{p.get_shading_tangent(), p.get_shading_normal(), p.get_shading_bitangent(), p.get_normal(),
+                1, &bxdf, &scale, &weight};
+        }
+
+        virtual std::shared_ptr<material> compile() const override
+        {
+            if(!reflectance_->get_constant() || !roughness_->get_constant()) return nullptr;
+            if(normal_ != nullptr && !normal_->get_constant()) return nullptr;
+
+            return std::make_shared<precomputed_material>(
+                [this] (bxdf* bxdfs, double* scales, double* weights)
+                {
+                    return evaluate_bxdfs({}, bxdfs, scales, weights);
+                }
+            );
+        }
+
+    private:
+        std::shared_ptr<texture_2d_rgb> reflectance_{};
+        std::shared_ptr<texture_2d_rg> roughness_{};
+        std::shared_ptr<texture_2d_rgb> normal_{};
+
+        int evaluate_bxdfs(vector2 const& uv, bxdf* bxdfs, double* scales, double* weights) const
+        {
+            vector3 reflectance{reflectance_->evaluate(uv)};
+            vector2 roughness{roughness_->evaluate(uv)};
 
             vector3 n{0.0, 1.0, 0.0};
             if(normal_ != nullptr)
             {
-                n = normal_->evaluate(p.get_uv()) * 2.0 - 1.0;
+                n = normal_->evaluate(uv) * 2.0 - 1.0;
                 std::swap(n.y, n.z);
                 n = normalize(n);
                 if(n.y < 0.0) n = -n;
@@ -37,27 +63,20 @@ namespace fc
 
             if(roughness.x == 0.0 && roughness.y == 0.0)
             {
-                auto fresnel{allocator.emplace<fresnel_one>()};
-                bxdf = allocator.emplace<bxdf_adapter<normal_mapping<specular_reflection>>>(
-                    normal_mapping<specular_reflection>{n, specular_reflection{reflectance, *fresnel, 0.0}}
-                );
+                bxdfs[0] = bxdf{
+                    normal_mapping<specular_reflection>{n, specular_reflection{reflectance, fresnel{fresnel_type::one}, 0.0}}
+                };
             }
             else
             {
-                auto microfacet_model{allocator.emplace<smith_ggx_microfacet_model>(roughness)};
-                auto fresnel{allocator.emplace<fresnel_one>()};
-                bxdf = allocator.emplace<bxdf_adapter<normal_mapping<microfacet_reflection>>>(
-                    normal_mapping<microfacet_reflection>{n, microfacet_reflection{reflectance, *microfacet_model, *fresnel, 0.0}}
-                );
+                bxdfs[0] = bxdf{
+                    normal_mapping<microfacet_reflection>{n, microfacet_reflection{reflectance, smith_ggx_microfacet_model{roughness}, fresnel{fresnel_type::one}, 0.0}}
+                };
             }
 
-            return allocator.emplace<bsdf>(p.get_shading_tangent(), p.get_shading_normal(), p.get_shading_bitangent(), p.get_normal(),
-                1, &bxdf, &scale, &weight);
+            scales[0] = 1.0;
+            weights[0] = 1.0;
+            return 1;
         }
-
-    private:
-        std::shared_ptr<texture_2d_rgb> reflectance_{};
-        std::shared_ptr<texture_2d_rg> roughness_{};
-        std::shared_ptr<texture_2d_rgb> normal_{};
     };
 }
\ No newline at end of file
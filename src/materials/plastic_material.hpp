@@ -3,6 +3,7 @@
 #include "../core/texture.hpp"
 #include "../bsdfs/microfacet_reflection.hpp"
 #include "../bsdfs/lambertian_reflection.hpp"
+#include "precomputed_material.hpp"
 #include <memory>
 
 namespace fc
@@ -21,40 +22,57 @@ namespace fc
             , ior_{std::move(ior)}
         { }
 
-        virtual bsdf const* evaluate(surface_point const& p, allocator_wrapper& allocator) const override
+        virtual bsdf evaluate(surface_point const& p) const override
         {
-            bxdf const* bxdfs[2]{};
-            double scales[2]{1.0, 1.0};
-            double weights[2]{1.0, 1.0};
+            bxdf bxdfs[2]{};
+            double scales[2]{};
+            double weights[2]{};
+            int size{evaluate_bxdfs(p.get_uv(), bxdfs, scales, weights)};
 
-            vector3 diffuse{diffuse_->evaluate(p.get_uv())};
-            vector3 specular{specular_->evaluate(p.get_uv())};
-            vector2 roughness{roughness_->evaluate(p.get_uv())};
-            double ior{ior_->evaluate(p.get_uv())};
+            return bsdf{p.get_shading_tangent(), p.get_shading_normal(), p.get_shading_bitangent(), p.get_normal(),
+                size, bxdfs, scales, weights};
+        }
 
+        virtual std::shared_ptr<material> compile() const override
+        {
+            if(!diffuse_->get_constant() || !specular_->get_constant() || !roughness_->get_constant() || !ior_->get_constant()) return nullptr;
 
-            bxdfs[0] = allocator.emplace<bxdf_adapter<lambertian_reflection>>(lambertian_reflection{diffuse});
+            return std::make_shared<precomputed_material>(
+                [this] (bxdf* bxdfs, double* scales, double* weights)
+                {
+                    return evaluate_bxdfs({}, bxdfs, scales, weights);
+                }
+            );
+        }
+
+    private:
+        std::shared_ptr<texture_2d_rgb> diffuse_{};
+        std::shared_ptr<texture_2d_rgb> specular_{};
+        std::shared_ptr<texture_2d_rg> roughness_{};
+        std::shared_ptr<texture_2d_r> ior_{};
+
+        int evaluate_bxdfs(vector2 const& uv, bxdf* bxdfs, double* scales, double* weights) const
+        {
+            vector3 diffuse{diffuse_->evaluate(uv)};
+            vector3 specular{specular_->evaluate(uv)};
+            vector2 roughness{roughness_->evaluate(uv)};
+            double ior{ior_->evaluate(uv)};
+
+
+            bxdfs[0] = bxdf{lambertian_reflection{diffuse}};
 
             if(roughness.x == 0.0 && roughness.y == 0.0)
             {
-                auto fresnel{allocator.emplace<fresnel_dielectric>()};
-                bxdfs[1] = allocator.emplace<bxdf_adapter<specular_reflection>>(specular_reflection{specular, *fresnel, ior});
+                bxdfs[1] = bxdf{specular_reflection{specular, fresnel{fresnel_type::dielectric}, ior}};
             }
             else
             {
-                auto microfacet_model{allocator.emplace<smith_ggx_microfacet_model>(roughness)};
-                auto fresnel{allocator.emplace<fresnel_dielectric>()};
-                bxdfs[1] = allocator.emplace< bxdf_adapter<microfacet_reflection>>(microfacet_reflection{specular, *microfacet_model, *fresnel, ior});
+                bxdfs[1] = bxdf{microfacet_reflection{specular, smith_ggx_microfacet_model{roughness}, fresnel{fresnel_type::dielectric}, ior}};
             }
 
-            return allocator.emplace<bsdf>(p.get_shading_tangent(), p.get_shading_normal(), p.get_shading_bitangent(), p.get_normal(),
-                2, bxdfs, scales, weights);
+            scales[0] = scales[1] = 1.0;
+            weights[0] = weights[1] = 1.0;
+            return 2;
         }
-
-    private:
-        std::shared_ptr<texture_2d_rgb> diffuse_{};
-        std::shared_ptr<texture_2d_rgb> specular_{};
-        std::shared_ptr<texture_2d_rg> roughness_{};
-        std::shared_ptr<texture_2d_r> ior_{};
     };
 }
\ No newline at end of file
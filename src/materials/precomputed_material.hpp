@@ -0,0 +1,30 @@
+#pragma once
+#include "../core/material.hpp"
+
+#include <memory>
+
+namespace fc
+{
+    // material whose bxdfs don't depend on the surface point, they are built once and copied into every hit
+    class precomputed_material : public material
+    {
+    public:
+        template<typename F>
+        explicit precomputed_material(F&& evaluate_bxdfs)
+        {
+            bxdf_count_ = evaluate_bxdfs(bxdfs_, scales_, weights_);
+        }
+
+        virtual bsdf evaluate(surface_point const& p) const override
+        {
+            return bsdf{p.get_shading_tangent(), p.get_shading_normal(), p.get_shading_bitangent(), p.get_normal(),
+                bxdf_count_, bxdfs_, scales_, weights_};
+        }
+
+    private:
+        int bxdf_count_{};
+        bxdf bxdfs_[bsdf::bxdf_capacity]{};
+        double scales_[bsdf::bxdf_capacity]{};
+        double weights_[bsdf::bxdf_capacity]{};
+    };
+}
\ No newline at end of file
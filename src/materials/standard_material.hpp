@@ -1,12 +1,15 @@
 #pragma once
 #include "../core/material.hpp"
 #include "../core/texture.hpp"
+#include "../textures/packed_texture.hpp"
 #include "../bsdfs/microfacet_reflection.hpp"
 #include "../bsdfs/lambertian_reflection.hpp"
 #include "../bsdfs/microfacet_reflection.hpp"
 #include "../bsdfs/specular_reflection.hpp"
 #include "../bsdfs/normal_mapping.hpp"
+#include "precomputed_material.hpp"
 #include <memory>
+#include <type_traits>
 
 namespace fc
 {
@@ -24,23 +27,104 @@ namespace fc
             , roughness_{std::move(roughness)}
             , ior_{std::move(ior)}
             , normal_{std::move(normal)}
-        { }
+        {
+            base_color_channel_ = find_packed_channel(base_color_.get());
+            metalness_channel_ = find_packed_channel(metalness_.get());
+            roughness_channel_ = find_packed_channel(roughness_.get());
+            ior_channel_ = find_packed_channel(ior_.get());
+            if(normal_ != nullptr) normal_channel_ = find_packed_channel(normal_.get());
+
+            metalness_constant_ = metalness_->get_constant();
+            roughness_constant_ = roughness_->get_constant();
+            ior_constant_ = ior_->get_constant();
+        }
 
-        virtual bsdf const* evaluate(surface_point const& p, allocator_wrapper& allocator) const override
+        virtual bsdf evaluate(surface_point const& p) const override
         {
-            bxdf const* bxdfs[3]{};
+            bxdf bxdfs[3]{};
             double scales[3]{};
             double weights[3]{};
+            int size{evaluate_bxdfs(p.get_uv(), bxdfs, scales, weights)};
+
+            return bsdf{p.get_shading_tangent(), p.get_shading_normal(), p.get_shading_bitangent(), p.get_normal(),
+                size, bxdfs, scales, weights};
+        }
+
+        virtual std::shared_ptr<material> compile() const override
+        {
+            if(!base_color_->get_constant() || !metalness_constant_ || !roughness_constant_ || !ior_constant_) return nullptr;
+            if(normal_ != nullptr && !normal_->get_constant()) return nullptr;
+
+            return std::make_shared<precomputed_material>(
+                [this] (bxdf* bxdfs, double* scales, double* weights)
+                {
+                    return evaluate_bxdfs({}, bxdfs, scales, weights);
+                }
+            );
+        }
+
+    private:
+        std::shared_ptr<texture_2d_rgb> base_color_{};
+        std::shared_ptr<texture_2d_r> metalness_{};
+        std::shared_ptr<texture_2d_r> roughness_{};
+        std::shared_ptr<texture_2d_r> ior_{};
+        std::shared_ptr<texture_2d_rgb> normal_{};
+
+        std::shared_ptr<packed_texture_2d> packed_texture_{};
+        int base_color_channel_{-1};
+        int metalness_channel_{-1};
+        int roughness_channel_{-1};
+        int ior_channel_{-1};
+        int normal_channel_{-1};
+
+        // constant inputs skip their texture lookups
+        std::optional<double> metalness_constant_{};
+        std::optional<double> roughness_constant_{};
+        std::optional<double> ior_constant_{};
+
+        // textures packed at asset loading are fetched together when they share the packed texture of the first one
+        template <typename T>
+        int find_packed_channel(T const* texture)
+        {
+            using packed_type = std::conditional_t<std::is_same_v<T, texture_2d_rgb>, packed_texture_2d_rgb, packed_texture_2d_r>;
+            auto packed{dynamic_cast<packed_type const*>(texture)};
+            if(packed == nullptr) return -1;
+
+            if(packed_texture_ == nullptr) packed_texture_ = packed->get_packed_texture();
+            return packed->get_packed_texture() == packed_texture_ ? packed->get_channel() : -1;
+        }
+
+        static vector3 evaluate_channel(texture_2d_rgb const& texture, int channel, double const* channels, vector2 const& uv)
+        {
+            if(channel < 0) return texture.evaluate(uv);
+            return {channels[channel], channels[channel + 1], channels[channel + 2]};
+        }
+
+        static double evaluate_channel(texture_2d_r const& texture, int channel, double const* channels, vector2 const& uv)
+        {
+            if(channel < 0) return texture.evaluate(uv);
+            return channels[channel];
+        }
+
+        int evaluate_bxdfs(vector2 const& uv, bxdf* bxdfs, double* scales, double* weights) const
+        {
             int size{};
 
-            vector3 base_color{base_color_->evaluate(p.get_uv())};
-            double metalness{metalness_->evaluate(p.get_uv())};
-            double roughness{roughness_->evaluate(p.get_uv())};
+            // one fetch for all packed channels
+            double channels[packed_texture_2d::max_channel_count]{};
+            if(packed_texture_ != nullptr)
+            {
+                packed_texture_->evaluate(uv, channels);
+            }
+
+            vector3 base_color{evaluate_channel(*base_color_, base_color_channel_, channels, uv)};
+            double metalness{metalness_constant_ ? *metalness_constant_ : evaluate_channel(*metalness_, metalness_channel_, channels, uv)};
+            double roughness{roughness_constant_ ? *roughness_constant_ : evaluate_channel(*roughness_, roughness_channel_, channels, uv)};
 
             vector3 n{0.0, 1.0, 0.0};
             if(normal_ != nullptr)
             {
-                n = normal_->evaluate(p.get_uv()) * 2.0 - 1.0;
+                n = evaluate_channel(*normal_, normal_channel_, channels, uv) * 2.0 - 1.0;
                 std::swap(n.y, n.z);
                 n = normalize(n);
                 if(n.y < 0.0) n = -n;
@@ -48,11 +132,11 @@ namespace fc
 
             if(metalness < 1.0)
             {
-                double ior{ior_->evaluate(p.get_uv())};
+                double ior{ior_constant_ ? *ior_constant_ : evaluate_channel(*ior_, ior_channel_, channels, uv)};
 
-                bxdfs[size] = allocator.emplace<bxdf_adapter<normal_mapping<lambertian_reflection>>>(
+                bxdfs[size] = bxdf{
                     normal_mapping<lambertian_reflection>{n, lambertian_reflection{base_color}}
-                );
+                };
 
                 scales[size] = 1.0 - metalness;
                 weights[size] = (1.0 - metalness) / 2.0;
@@ -60,18 +144,15 @@ namespace fc
 
                 if(roughness == 0.0)
                 {
-                    auto fresnel{allocator.emplace<fresnel_dielectric>()};
-                    bxdfs[size] = allocator.emplace<bxdf_adapter<normal_mapping<specular_reflection>>>(
-                        normal_mapping<specular_reflection>{n, specular_reflection{vector3{1.0, 1.0, 1.0}, *fresnel, ior}}
-                    );
+                    bxdfs[size] = bxdf{
+                        normal_mapping<specular_reflection>{n, specular_reflection{vector3{1.0, 1.0, 1.0}, fresnel{fresnel_type::dielectric}, ior}}
+                    };
                 }
                 else
                 {
-                    auto microfacet_model{allocator.emplace<smith_ggx_microfacet_model>(vector2{roughness, roughness})};
-                    auto fresnel{allocator.emplace<fresnel_dielectric>()};
-                    bxdfs[size] = allocator.emplace<bxdf_adapter<normal_mapping<microfacet_reflection>>>(
-                        normal_mapping<microfacet_reflection>{n, microfacet_reflection{vector3{1.0, 1.0, 1.0}, *microfacet_model, *fresnel, ior}}
-                    );
+                    bxdfs[size] = bxdf{
+                        normal_mapping<microfacet_reflection>{n, microfacet_reflection{vector3{1.0, 1.0, 1.0}, smith_ggx_microfacet_model{vector2{roughness, roughness}}, fresnel{fresnel_type::dielectric}, ior}}
+                    };
                 }
 
                 scales[size] = scales[size - 1];
@@ -83,18 +164,15 @@ namespace fc
             {
                 if(roughness == 0.0)
                 {
-                    auto fresnel{allocator.emplace<fresnel_one>()};
-                    bxdfs[size] = allocator.emplace<bxdf_adapter<normal_mapping<specular_reflection>>>(
-                        normal_mapping<specular_reflection>{n, specular_reflection{base_color, *fresnel, 0.0}}
-                    );
+                    bxdfs[size] = bxdf{
+                        normal_mapping<specular_reflection>{n, specular_reflection{base_color, fresnel{fresnel_type::one}, 0.0}}
+                    };
                 }
                 else
                 {
-                    auto microfacet_model{allocator.emplace<smith_ggx_microfacet_model>(vector2{roughness, roughness})};
-                    auto fresnel{allocator.emplace<fresnel_one>()};
-                    bxdfs[size] = allocator.emplace<bxdf_adapter<normal_mapping<microfacet_reflection>>>(
-                        normal_mapping<microfacet_reflection>{n, microfacet_reflection{base_color, *microfacet_model, *fresnel, 0.0}}
-                    );
+                    bxdfs[size] = bxdf{
+                        normal_mapping<microfacet_reflection>{n, microfacet_reflection{base_color, smith_ggx_microfacet_model{vector2{roughness, roughness}}, fresnel{fresnel_type::one}, 0.0}}
+                    };
                 }
 
                 scales[size] = metalness;
@@ -102,16 +180,7 @@ namespace fc
                 size += 1;
             }
 
-            return allocator.emplace<bsdf>(p.get_shading_tangent(), p.get_shading_normal(), p.get_shading_bitangent(), p.get_normal(),
-                size, bxdfs, scales, weights);
+            return size;
         }
-
-    private:
-        std::shared_ptr<texture_2d_rgb> base_color_{};
-        std::shared_ptr<texture_2d_r> metalness_{};
-        std::shared_ptr<texture_2d_r> roughness_{};
-        std::shared_ptr<texture_2d_r> ior_{};
-        std::shared_ptr<texture_2d_rgb> normal_{};
-
     };
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "../core/material.hpp"
 #include "../bsdfs/specular_transmission.hpp"
 #include "../bsdfs/microfacet_transmission.hpp"
+#include "precomputed_material.hpp"
 
 #include <memory>
 
@@ -16,31 +17,50 @@ namespace fc
             : transmittance_{std::move(transmittance)}, roughness_{std::move(roughness)}
         { }
 
-        virtual bsdf const* evaluate(surface_point const& p, allocator_wrapper& allocator) const override
+        virtual bsdf evaluate(surface_point const& p) const override
         {
-            bxdf const* bxdf{};
-            double scale{1.0};
-            double weight{1.0};
+            bxdf bxdf{};
+            double scale{};
+            double weight{};
+            evaluate_bxdfs(p.get_uv(), &bxdf, &scale, &weight);
 
-            vector3 transmittance{transmittance_->evaluate(p.get_uv())};
-            vector2 roughness{roughness_->evaluate(p.get_uv())};
+            return bsdf{p.get_shading_tangent(), p.get_shading_normal(), p.get_shading_bitangent(), p.get_normal(),
+                1, &bxdf, &scale, &weight};
+        }
+
+        virtual std::shared_ptr<material> compile() const override
+        {
+            if(!transmittance_->get_constant() || !roughness_->get_constant()) return nullptr;
+
+            return std::make_shared<precomputed_material>(
+                [this] (bxdf* bxdfs, double* scales, double* weights)
+                {
+                    return evaluate_bxdfs({}, bxdfs, scales, weights);
+                }
+            );
+        }
+
+    private:
+        std::shared_ptr<texture_2d_rgb> transmittance_{};
+        std::shared_ptr<texture_2d_rg> roughness_{};
+
+        int evaluate_bxdfs(vector2 const& uv, bxdf* bxdfs, double* scales, double* weights) const
+        {
+            vector3 transmittance{transmittance_->evaluate(uv)};
+            vector2 roughness{roughness_->evaluate(uv)};
 
             if(roughness.x == 0.0 && roughness.y == 0.0)
             {
-                bxdf = allocator.emplace<bxdf_adapter<specular_transmission>>(specular_transmission{transmittance});
+                bxdfs[0] = bxdf{specular_transmission{transmittance}};
             }
             else
             {
-                microfacet_model const* model{allocator.emplace<smith_ggx_microfacet_model>(roughness)};
-                bxdf = allocator.emplace<bxdf_adapter<microfacet_transmission>>(microfacet_transmission{transmittance, *model});
+                bxdfs[0] = bxdf{microfacet_transmission{transmittance, smith_ggx_microfacet_model{roughness}}};
             }
 
-            return allocator.emplace<bsdf>(p.get_shading_tangent(), p.get_shading_normal(), p.get_shading_bitangent(), p.get_normal(),
-                1, &bxdf, &scale, &weight);
+            scales[0] = 1.0;
+            weights[0] = 1.0;
+            return 1;
         }
-
-    private:
-        std::shared_ptr<texture_2d_rgb> transmittance_{};
-        std::shared_ptr<texture_2d_rg> roughness_{};
     };
 }
\ No newline at end of file
@@ -11,6 +11,7 @@ namespace fc
     public:
         virtual vector2i get_image_plane_resolution() const = 0;
         virtual void set_pixel(vector2i const& pixel) = 0;
+        virtual void set_pixel_estimate(double estimate) = 0;
     };
 
     class camera_factory
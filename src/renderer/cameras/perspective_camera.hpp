@@ -41,6 +41,7 @@ namespace fc
             }
 
             p->set_position(transform_.transform_point(lens_position));
+            p->set_position_error(transform_.transform_point_error(lens_position, {}));
             p->set_normal(transform_.transform_direction({0.0, 0.0, 1.0}));
             p->set_measurement(this);
 
@@ -138,6 +139,11 @@ namespace fc
             render_target_->add_sample_count(value);
         }
 
+        virtual double get_pixel_estimate() const override
+        {
+            return pixel_estimate_;
+        }
+
         virtual vector2i get_image_plane_resolution() const override
         {
             return render_target_->get_resolution();
@@ -148,6 +154,11 @@ namespace fc
             pixel_ = pixel;
         }
 
+        virtual void set_pixel_estimate(double estimate) override
+        {
+            pixel_estimate_ = estimate;
+        }
+
     private:
         std::shared_ptr<render_target> render_target_{};
         pr_transform transform_{};
@@ -158,6 +169,7 @@ namespace fc
         vector2 sample_plane_size_{};
 
         vector2i pixel_{};
+        double pixel_estimate_{};
 
         std::optional<measurement_sample_p> sample_p_local(vector3 const& lens_position, vector3 const& wi, allocator_wrapper& allocator) const
         {
@@ -177,6 +189,7 @@ namespace fc
 
             surface_point* p{allocator.emplace<surface_point>()};
             p->set_position(transform_.transform_point(lens_position));
+            p->set_position_error(transform_.transform_point_error(lens_position, {}));
             p->set_normal(transform_.transform_direction({0.0, 0.0, 1.0}));
             p->set_measurement(this);
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "../core/math.hpp"
+#include "../core/kernels.hpp"
 
 #include <vector>
 
@@ -32,6 +33,13 @@ namespace fc
             return get_pixel(pixel).sample_sum;
         }
 
+        // adds the sample sums of every pixel to sums, which holds one entry per pixel
+        void accumulate_pixel_sample_sums(vector3* sums) const
+        {
+            static_assert(sizeof(pixel) == 3 * sizeof(double));
+            get_kernels().accumulate(reinterpret_cast<double*>(sums), reinterpret_cast<double const*>(pixels_.data()), pixels_.size() * 3);
+        }
+
         std::uint64_t get_sample_count() const
         {
             return sample_count_;
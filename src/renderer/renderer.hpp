@@ -1,6 +1,7 @@
 #pragma once
 #include "../core/integrator.hpp"
 #include "../core/scene.hpp"
+#include "../core/color.hpp"
 #include "../samplers/random_sampler.hpp"
 #include "../samplers/stratified_sampler.hpp"
 #include "../allocators/paged_allocator.hpp"
@@ -17,10 +18,13 @@
 
 namespace fc
 {
-    class renderer
+    // Statistics collects the raycast statistics of every pixel, to go with an acceleration structure that counts
+    // them; without it the renderer neither stores nor reads them
+    template <bool Statistics>
+    class basic_renderer
     {
     public:
-        renderer(
+        basic_renderer(
             vector2i const& resolution,
             camera_factory const& camera_factory,
             std::shared_ptr<integrator> integrator,
@@ -30,6 +34,7 @@ namespace fc
             : resolution_{resolution}, integrator_{std::move(integrator)}, scene_{std::move(scene)}, worker_count_{worker_count}
         {
             worker_count_ = std::max(1, worker_count_);
+            if constexpr(Statistics) pixel_statistics_.resize(static_cast<std::size_t>(resolution.x) * static_cast<std::size_t>(resolution.y));
 
             render_targets_.reserve(worker_count_);
             cameras_.reserve(worker_count_);
@@ -52,6 +57,7 @@ namespace fc
             int sample_count{sampler_source.get_sample_count()};
 
             camera.set_pixel(pixel);
+            camera.set_pixel_estimate(get_pixel_estimate(pixel.y * resolution_.x + pixel.x));
 
             for(int i{}; i < sample_count; ++i)
             {
@@ -112,32 +118,121 @@ namespace fc
             }
         }
 
+        // the mean of the samples of every pixel, row by row
+        std::vector<vector3> get_image() const
+        {
+            double sample_count{};
+            for(int i{}; i < render_targets_.size(); ++i)
+            {
+                sample_count += static_cast<double>(render_targets_[i]->get_sample_count());
+            }
+
+            std::vector<vector3> image{};
+            image.resize(static_cast<std::size_t>(resolution_.x) * static_cast<std::size_t>(resolution_.y));
+            for(int k{}; k < render_targets_.size(); ++k)
+            {
+                render_targets_[k]->accumulate_pixel_sample_sums(image.data());
+            }
+
+            for(vector3& c : image)
+            {
+                c /= sample_count;
+            }
+            return image;
+        }
+
         void export_image(std::string const& filename)
         {
             std::fstream fout{filename + ".raw", std::ios::trunc | std::ios::binary | std::ios::out};
-            double sampleCount{};
-            for(int i{}; i < render_targets_.size(); ++i)
+            for(vector3 const& c : get_image())
             {
-                sampleCount += static_cast<double>(render_targets_[i]->get_sample_count());
+                vector3f color{static_cast<float>(c.x), static_cast<float>(c.y), static_cast<float>(c.z)};
+                static_assert(sizeof(color) == 12);
+                fout.write(reinterpret_cast<char const*>(&color), sizeof(color));
             }
+        }
+
+        // the luminance of every pixel over the mean of the image, averaged over 3x3 pixels against the noise of a
+        // coarse render; passed to set_pixel_estimates of another render, they drive the efficiency mode of its
+        // russian roulette
+        std::vector<double> get_pixel_estimates() const
+        {
+            std::vector<vector3> image{get_image()};
+            std::vector<double> estimates(image.size());
 
-            vector2i resolution{render_targets_[0]->get_resolution()};
-            for(int i{}; i < resolution.y; ++i)
+            double mean{};
+            for(int y{}; y < resolution_.y; ++y)
             {
-                for(int j{}; j < resolution.x; ++j)
+                for(int x{}; x < resolution_.x; ++x)
                 {
-                    vector3 c{};
-                    for(int k{}; k < render_targets_.size(); ++k)
+                    double sum{};
+                    int count{};
+                    for(int j{std::max(y - 1, 0)}; j <= std::min(y + 1, resolution_.y - 1); ++j)
                     {
-                        c += render_targets_[k]->get_pixel_sample_sum({j, i});
+                        for(int i{std::max(x - 1, 0)}; i <= std::min(x + 1, resolution_.x - 1); ++i)
+                        {
+                            sum += luminance(image[static_cast<std::size_t>(j) * resolution_.x + i]);
+                            count += 1;
+                        }
                     }
 
-                    c /= sampleCount;
-                    vector3f color{static_cast<float>(c.x), static_cast<float>(c.y), static_cast<float>(c.z)};
-                    static_assert(sizeof(color) == 12);
-                    fout.write(reinterpret_cast<char const*>(&color), sizeof(color));
+                    estimates[static_cast<std::size_t>(y) * resolution_.x + x] = sum / count;
+                    mean += luminance(image[static_cast<std::size_t>(y) * resolution_.x + x]);
                 }
             }
+
+            mean /= static_cast<double>(image.size());
+            for(double& estimate : estimates)
+            {
+                estimate = mean > 0.0 ? estimate / mean : 0.0;
+            }
+            return estimates;
+        }
+
+        void set_pixel_estimates(std::vector<double> pixel_estimates)
+        {
+            pixel_estimates_ = std::move(pixel_estimates);
+        }
+
+        // prints the raycast statistics of the render and writes a heatmap of the nodes and primitive tests per ray,
+        // scaled to the pixel with the most; only acceleration structures built with statistics count them
+        void export_statistics(std::string const& filename) requires Statistics
+        {
+            auto get_steps{[] (raycast_statistics const& statistics)
+            {
+                if(statistics.ray_count == 0) return 0.0;
+                return static_cast<double>(statistics.node_count + statistics.primitive_test_count) / static_cast<double>(statistics.ray_count);
+            }};
+
+            raycast_statistics total{};
+            double max_steps{};
+            for(raycast_statistics const& statistics : pixel_statistics_)
+            {
+                total += statistics;
+                max_steps = std::max(max_steps, get_steps(statistics));
+            }
+
+            if(total.ray_count == 0)
+            {
+                std::cout << "no raycast statistics, the acceleration structure does not count them" << std::endl;
+                return;
+            }
+
+            double ray_count{static_cast<double>(total.ray_count)};
+            std::cout << std::setprecision(2) << "rays " << total.ray_count
+                << ", per ray: nodes " << total.node_count / ray_count
+                << ", leaves " << total.leaf_count / ray_count
+                << ", primitive tests " << total.primitive_test_count / ray_count
+                << ", hits " << total.hit_count / ray_count * 100.0 << "%" << std::endl;
+
+            // blue for the cheapest pixels through green to red for the most expensive one
+            std::fstream fout{filename + ".raw", std::ios::trunc | std::ios::binary | std::ios::out};
+            for(raycast_statistics const& statistics : pixel_statistics_)
+            {
+                float t{static_cast<float>(max_steps > 0.0 ? get_steps(statistics) / max_steps : 0.0)};
+                vector3f color{std::clamp(2.0f * t - 1.0f, 0.0f, 1.0f), 1.0f - std::abs(2.0f * t - 1.0f), std::clamp(1.0f - 2.0f * t, 0.0f, 1.0f)};
+                fout.write(reinterpret_cast<char const*>(&color), sizeof(color));
+            }
         }
 
     private:
@@ -150,6 +245,13 @@ namespace fc
         std::vector<std::unique_ptr<camera>> cameras_{};
         std::vector<std::unique_ptr<allocator>> sample_allocators_{};
         std::vector<std::unique_ptr<sampler_source>> sampler_sources_{};
+        std::vector<raycast_statistics> pixel_statistics_{};
+        std::vector<double> pixel_estimates_{};
+
+        double get_pixel_estimate(int pixel_index) const
+        {
+            return pixel_estimates_.empty() ? 0.0 : pixel_estimates_[pixel_index];
+        }
 
         void worker_thread(int index, std::atomic<int>& next_pixel, std::atomic<int>& pixels_done)
         {
@@ -165,6 +267,9 @@ namespace fc
 
                 vector2i current_pixel{current_pixel_index % resolution_.x, current_pixel_index / resolution_.x};
                 camera.set_pixel(current_pixel);
+                camera.set_pixel_estimate(get_pixel_estimate(current_pixel_index));
+                raycast_statistics start_statistics{};
+                if constexpr(Statistics) start_statistics = get_raycast_statistics();
 
                 for(int i{}; i < sample_count; ++i)
                 {
@@ -174,8 +279,12 @@ namespace fc
                     sample_allocator.clear();
                 }
 
+                if constexpr(Statistics) pixel_statistics_[current_pixel_index] = get_raycast_statistics() - start_statistics;
+
                 pixels_done.fetch_add(1, std::memory_order_relaxed);
             }
         }
     };
+
+    using renderer = basic_renderer<false>;
 }
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+#include "sobol_sampler.hpp"
+
+#include <bit>
+
+namespace fc
+{
+    // the samples of all pixels are one 2d sobol sequence per dimension, split along a morton curve over the pixels
+    // so that neighbouring pixels get neighbouring blocks of it; the base 4 digits of the index are shuffled by
+    // hashes of the digits above them, which keeps every aligned block a stratified net but spreads the error of
+    // nearby pixels apart, as blue noise [Ahmed and Wonka 2020]; the sample count is rounded up to a power of two
+    class blue_noise_sampler final : public sampler_source
+    {
+    public:
+        explicit blue_noise_sampler(int sample_count, std::uint64_t seed = 0)
+            : seed_{seed}
+        {
+            sample_count_ = static_cast<int>(std::bit_ceil(static_cast<std::uint32_t>(std::max(sample_count, 1))));
+            log2_sample_count_ = std::countr_zero(static_cast<std::uint32_t>(sample_count_));
+        }
+
+        virtual std::unique_ptr<sampler_source> clone() const override
+        {
+            return std::make_unique<blue_noise_sampler>(sample_count_, seed_);
+        }
+
+        virtual int get_sample_count() const override
+        {
+            return sample_count_;
+        }
+
+        virtual void set_sample(vector2i const& pixel, int sample_index) override
+        {
+            auto spread{[] (int x)
+            {
+                std::uint64_t v{static_cast<std::uint16_t>(x)};
+                v = (v | (v << 8)) & 0x00ff00ff;
+                v = (v | (v << 4)) & 0x0f0f0f0f;
+                v = (v | (v << 2)) & 0x33333333;
+                v = (v | (v << 1)) & 0x55555555;
+                return v;
+            }};
+            morton_index_ = (((spread(pixel.y) << 1) | spread(pixel.x)) << log2_sample_count_) | static_cast<std::uint32_t>(sample_index);
+            current_dimension_ = 0;
+        }
+
+        virtual vector2 get() override
+        {
+            // the scrambling depends on the dimension only, a seed per pixel would make the error white noise again
+            std::uint64_t seed{sobol_sampler::get_dimension_seed(seed_, current_dimension_++)};
+            std::uint32_t index{get_sample_index(seed)};
+
+            // the first sobol dimension is the index with its bits reversed
+            std::uint32_t x{sobol_sampler::owen_scramble(sobol_sampler::reverse_bits(index), static_cast<std::uint32_t>(seed))};
+            std::uint32_t y{sobol_sampler::owen_scramble(sobol_sampler::get_sobol(index, 1), static_cast<std::uint32_t>(seed >> 32))};
+            return {to_unit(x), to_unit(y)};
+        }
+
+        virtual void get_batch(std::span<vector2> values) override
+        {
+            for(vector2& value : values)
+            {
+                value = get();
+            }
+        }
+
+        virtual void advance_dimension(int count = 1) override
+        {
+            current_dimension_ += count;
+        }
+
+        virtual void set_dimension(int dimension_index) override
+        {
+            current_dimension_ = dimension_index;
+        }
+
+    private:
+        static constexpr std::uint8_t digit_permutations[24][4]{
+            {0, 1, 2, 3}, {0, 1, 3, 2}, {0, 2, 1, 3}, {0, 2, 3, 1}, {0, 3, 2, 1}, {0, 3, 1, 2},
+            {1, 0, 2, 3}, {1, 0, 3, 2}, {1, 2, 0, 3}, {1, 2, 3, 0}, {1, 3, 2, 0}, {1, 3, 0, 2},
+            {2, 1, 0, 3}, {2, 1, 3, 0}, {2, 0, 1, 3}, {2, 0, 3, 1}, {2, 3, 0, 1}, {2, 3, 1, 0},
+            {3, 1, 2, 0}, {3, 1, 0, 2}, {3, 2, 1, 0}, {3, 2, 0, 1}, {3, 0, 2, 1}, {3, 0, 1, 2}
+        };
+
+        // index bits above the 32nd only move the points of the first two sobol dimensions by less than 2^-32, so
+        // only the digits below it are shuffled; with an odd power of two samples the lowest digit has one bit
+        std::uint32_t get_sample_index(std::uint64_t seed) const
+        {
+            int low_bit_count{log2_sample_count_ & 1};
+            std::uint32_t index{};
+            for(int shift{low_bit_count}; shift < 32; shift += 2)
+            {
+                std::uint32_t digit{static_cast<std::uint32_t>(morton_index_ >> shift) & 3};
+                std::uint64_t higher_digits{morton_index_ >> (shift + 2)};
+                int permutation{static_cast<int>((mix_bits(higher_digits ^ seed) >> 24) % 24)};
+                index |= static_cast<std::uint32_t>(digit_permutations[permutation][digit]) << shift;
+            }
+
+            if(low_bit_count != 0)
+            {
+                index |= static_cast<std::uint32_t>((morton_index_ ^ mix_bits((morton_index_ >> 1) ^ seed)) & 1);
+            }
+            return index;
+        }
+
+        int sample_count_{};
+        int log2_sample_count_{};
+        std::uint64_t seed_{};
+
+        std::uint64_t morton_index_{};
+        int current_dimension_{};
+    };
+}
\ No newline at end of file
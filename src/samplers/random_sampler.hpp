@@ -1,12 +1,11 @@
 #pragma once
 #include "../core/sampler.hpp"
-#include "../lib/pcg_random.hpp"
-
-#include <random>
 
 namespace fc
 {
-    class random_sampler : public sampler_source
+    // a counter based stream, every dimension is a hash of the sample seed and its index [Steele et al. 2014], so
+    // moving between dimensions is free and the values of a batch do not depend on each other
+    class random_sampler final : public sampler_source
     {
     public:
         random_sampler(int sample_count, std::uint64_t seed = 0)
@@ -26,37 +25,45 @@ namespace fc
         virtual void set_sample(vector2i const& pixel, int sample_index) override
         {
             int data[]{pixel.x, pixel.y, sample_index};
-            std::uint64_t gen_seed{XXH64(data, sizeof(data), seed_)};
-            generator_ = {gen_seed};
+            sample_seed_ = XXH64(data, sizeof(data), seed_);
+            current_dimension_ = 0;
         }
 
         virtual vector2 get() override
         {
-            std::uniform_real_distribution<double> dist{};
-            return {dist(generator_), dist(generator_)};
+            return get(current_dimension_++);
+        }
+
+        virtual void get_batch(std::span<vector2> values) override
+        {
+            std::uint64_t first_dimension{current_dimension_};
+            current_dimension_ += values.size();
+            for(std::size_t i{}; i < values.size(); ++i)
+            {
+                values[i] = get(first_dimension + i);
+            }
         }
 
         virtual void advance_dimension(int count = 1) override
         {
-            std::uint64_t delta{count * std::uint64_t{2}};
-            generator_.advance(delta);
-            generator_position_ += delta;
+            current_dimension_ += count;
         }
 
         virtual void set_dimension(int dimension_index) override
         {
-            std::uint64_t required_position{dimension_index * std::uint64_t{2}};
-            if(required_position > generator_position_)
-                generator_.advance(required_position - generator_position_);
-            else if(required_position < generator_position_)
-                generator_.backstep(generator_position_ - required_position);
-            generator_position_ = required_position;
+            current_dimension_ = dimension_index;
         }
     private:
+        vector2 get(std::uint64_t dimension) const
+        {
+            std::uint64_t bits{mix_bits(sample_seed_ + (dimension + 1) * 0x9e3779b97f4a7c15)};
+            return {to_unit(static_cast<std::uint32_t>(bits)), to_unit(static_cast<std::uint32_t>(bits >> 32))};
+        }
+
         int sample_count_{};
         std::uint64_t seed_{};
 
-        pcg32 generator_{};
-        std::uint64_t generator_position_{};
+        std::uint64_t sample_seed_{};
+        std::uint64_t current_dimension_{};
     };
 }
\ No newline at end of file
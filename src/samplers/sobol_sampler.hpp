@@ -0,0 +1,179 @@
+#pragma once
+#include "../core/sampler.hpp"
+
+#include <array>
+
+namespace fc
+{
+    // the first dimensions come from one sobol sequence, so any power of two prefix of the samples is stratified
+    // across all of them at once; hashes of the pixel owen scramble every dimension and shuffle the order of the
+    // samples, so any sample of any dimension costs the same; later dimensions are padded with 2d sobol
+    // sequences shuffled on their own [Burley 2020]
+    class sobol_sampler final : public sampler_source
+    {
+        static constexpr int sobol_dimension_count{32};
+    public:
+        explicit sobol_sampler(int sample_count, std::uint64_t seed = 0)
+            : sample_count_{sample_count}, seed_{seed}
+        { }
+
+        virtual std::unique_ptr<sampler_source> clone() const override
+        {
+            return std::make_unique<sobol_sampler>(sample_count_, seed_);
+        }
+
+        virtual int get_sample_count() const override
+        {
+            return sample_count_;
+        }
+
+        virtual void set_sample(vector2i const& pixel, int sample_index) override
+        {
+            int data[]{pixel.x, pixel.y};
+            pixel_seed_ = XXH64(data, sizeof(data), seed_);
+            sample_index_ = static_cast<std::uint32_t>(sample_index);
+            shuffled_index_ = owen_scramble(sample_index_, static_cast<std::uint32_t>(pixel_seed_));
+            current_dimension_ = 0;
+        }
+
+        virtual vector2 get() override
+        {
+            int dimension{current_dimension_++};
+            std::uint64_t seed{get_dimension_seed(pixel_seed_, dimension)};
+            if(dimension * 2 < sobol_dimension_count)
+            {
+                std::uint32_t x{owen_scramble(get_sobol(shuffled_index_, dimension * 2), static_cast<std::uint32_t>(seed))};
+                std::uint32_t y{owen_scramble(get_sobol(shuffled_index_, dimension * 2 + 1), static_cast<std::uint32_t>(seed >> 32))};
+                return {to_unit(x), to_unit(y)};
+            }
+            return get_padded_sample(sample_index_, seed);
+        }
+
+        virtual void get_batch(std::span<vector2> values) override
+        {
+            for(vector2& value : values)
+            {
+                value = get();
+            }
+        }
+
+        virtual void advance_dimension(int count = 1) override
+        {
+            current_dimension_ += count;
+        }
+
+        virtual void set_dimension(int dimension_index) override
+        {
+            current_dimension_ = dimension_index;
+        }
+
+        static std::uint64_t get_dimension_seed(std::uint64_t pixel_seed, int dimension)
+        {
+            return mix_bits(pixel_seed ^ (static_cast<std::uint64_t>(dimension) * 0x9e3779b97f4a7c15));
+        }
+
+        // the sample_index-th point of the first two sobol dimensions, a (0, 2) sequence, shuffled and scrambled by seed
+        static vector2 get_padded_sample(std::uint32_t sample_index, std::uint64_t seed)
+        {
+            std::uint32_t index{owen_scramble(sample_index, static_cast<std::uint32_t>(seed))};
+            std::uint64_t point_seed{mix_bits(seed)};
+
+            std::uint32_t x{owen_scramble(get_sobol(index, 0), static_cast<std::uint32_t>(point_seed))};
+            std::uint32_t y{owen_scramble(get_sobol(index, 1), static_cast<std::uint32_t>(point_seed >> 32))};
+            return {to_unit(x), to_unit(y)};
+        }
+
+        static std::uint32_t get_sobol(std::uint32_t index, int dimension)
+        {
+            std::uint32_t result{};
+            for(int i{}; index != 0; index >>= 1, ++i)
+            {
+                result ^= sobol_matrices[dimension][i] & (0u - (index & 1));
+            }
+            return result;
+        }
+
+        static std::uint32_t reverse_bits(std::uint32_t x)
+        {
+            x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);
+            x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);
+            x = ((x >> 4) & 0x0f0f0f0f) | ((x & 0x0f0f0f0f) << 4);
+            x = ((x >> 8) & 0x00ff00ff) | ((x & 0x00ff00ff) << 8);
+            return (x >> 16) | (x << 16);
+        }
+
+        // flips every bit of the binary fraction x depending on the bits above it, hashed with the seed; the
+        // multiplications only carry upwards, so they do it for the reversed bits [Laine and Karras 2011, Vegdahl 2021]
+        static std::uint32_t owen_scramble(std::uint32_t x, std::uint32_t seed)
+        {
+            x = reverse_bits(x);
+            x += seed;
+            x ^= x * 0x6c50b47c;
+            x ^= x * 0xb82f1e52;
+            x ^= x * 0xc7afe638;
+            x ^= x * 0x8d22f6e6;
+            return reverse_bits(x);
+        }
+
+    private:
+        // degree, inner coefficients of the primitive polynomial and initial direction numbers of the sobol dimensions
+        // after the first [Joe and Kuo 2008]
+        struct sobol_parameters
+        {
+            int degree{};
+            std::uint32_t coefficients{};
+            std::uint32_t initial[7]{};
+        };
+
+        static constexpr sobol_parameters sobol_table[sobol_dimension_count - 1]{
+            {1, 0, {1}}, {2, 1, {1, 3}}, {3, 1, {1, 3, 1}}, {3, 2, {1, 1, 1}}, {4, 1, {1, 1, 3, 3}}, {4, 4, {1, 3, 5, 13}},
+            {5, 2, {1, 1, 5, 5, 17}}, {5, 4, {1, 1, 5, 5, 5}}, {5, 7, {1, 1, 7, 11, 19}}, {5, 11, {1, 1, 5, 1, 1}},
+            {5, 13, {1, 1, 1, 3, 11}}, {5, 14, {1, 3, 5, 5, 31}}, {6, 1, {1, 3, 3, 9, 7, 49}}, {6, 13, {1, 1, 1, 15, 21, 21}},
+            {6, 16, {1, 3, 1, 13, 27, 49}}, {6, 19, {1, 1, 1, 15, 7, 5}}, {6, 22, {1, 3, 1, 15, 13, 25}}, {6, 25, {1, 1, 5, 5, 19, 61}},
+            {7, 1, {1, 3, 7, 11, 23, 15, 103}}, {7, 4, {1, 3, 7, 13, 13, 15, 69}}, {7, 7, {1, 1, 3, 13, 7, 35, 63}},
+            {7, 8, {1, 3, 5, 9, 1, 25, 53}}, {7, 14, {1, 3, 1, 13, 9, 35, 107}}, {7, 19, {1, 3, 1, 5, 27, 61, 31}},
+            {7, 21, {1, 1, 5, 11, 19, 41, 61}}, {7, 28, {1, 3, 5, 3, 3, 13, 69}}, {7, 31, {1, 1, 7, 13, 1, 19, 1}},
+            {7, 32, {1, 3, 7, 5, 13, 19, 59}}, {7, 37, {1, 1, 3, 9, 25, 29, 41}}, {7, 41, {1, 3, 5, 13, 23, 1, 55}},
+            {7, 42, {1, 3, 7, 3, 13, 59, 17}}
+        };
+
+        // column i of a generator matrix is the direction number that bit i of the index adds
+        static constexpr std::array<std::array<std::uint32_t, 32>, sobol_dimension_count> sobol_matrices{[] ()
+        {
+            std::array<std::array<std::uint32_t, 32>, sobol_dimension_count> matrices{};
+            for(int i{}; i < 32; ++i)
+            {
+                matrices[0][i] = 1u << (31 - i);
+            }
+
+            for(int dimension{1}; dimension < sobol_dimension_count; ++dimension)
+            {
+                sobol_parameters const& parameters{sobol_table[dimension - 1]};
+                std::array<std::uint32_t, 32>& v{matrices[dimension]};
+                int s{parameters.degree};
+                for(int i{}; i < s; ++i)
+                {
+                    v[i] = parameters.initial[i] << (31 - i);
+                }
+
+                for(int i{s}; i < 32; ++i)
+                {
+                    v[i] = v[i - s] ^ (v[i - s] >> s);
+                    for(int k{1}; k < s; ++k)
+                    {
+                        if((parameters.coefficients >> (s - 1 - k)) & 1) v[i] ^= v[i - k];
+                    }
+                }
+            }
+            return matrices;
+        }()};
+
+        int sample_count_{};
+        std::uint64_t seed_{};
+
+        std::uint64_t pixel_seed_{};
+        std::uint32_t sample_index_{};
+        std::uint32_t shuffled_index_{};
+        int current_dimension_{};
+    };
+}
\ No newline at end of file
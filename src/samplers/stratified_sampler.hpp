@@ -1,21 +1,20 @@
 #pragma once
 #include "../core/sampler.hpp"
-#include "../lib/pcg_random.hpp"
-
-#include <random>
 
 namespace fc
 {
-    class stratified_sampler : public sampler_source
+    // every dimension jitters one sample in each cell of a square grid and visits the cells in a random order; both
+    // the order and the jitter are hashes of the pixel, the dimension and the sample, so nothing is stored and any
+    // sample of any dimension costs the same
+    class stratified_sampler final : public sampler_source
     {
     public:
         explicit stratified_sampler(int sample_count, std::uint64_t seed = 0)
             : seed_{seed}
         {
-            sqrt_sample_count_ = static_cast<int>(std::sqrt(sample_count));
-            sample_count_ = sqrt_sample_count_ * sqrt_sample_count_;
-
-            initialize_generator();
+            sqrt_sample_count_ = static_cast<std::uint32_t>(std::sqrt(sample_count));
+            sample_count_ = static_cast<int>(sqrt_sample_count_ * sqrt_sample_count_);
+            inverse_sqrt_sample_count_ = 1.0 / sqrt_sample_count_;
         }
 
         virtual std::unique_ptr<sampler_source> clone() const override
@@ -30,24 +29,40 @@ namespace fc
 
         virtual void set_sample(vector2i const& pixel, int sample_index) override
         {
-            sample_index_ = sample_index;
+            sample_index_ = static_cast<std::uint32_t>(sample_index);
             current_dimension_ = 0;
 
-            if(current_pixel_ != pixel)
+            if(current_pixel_ != pixel || !pixel_seed_valid_)
             {
                 current_pixel_ = pixel;
+                pixel_seed_valid_ = true;
 
-                initialize_generator();
-
-                for(std::size_t i{}; i < dimensions_.size(); ++i)
-                    dimensions_[i].generated = false;
+                int data[]{pixel.x, pixel.y};
+                pixel_seed_ = XXH64(data, sizeof(data), seed_);
             }
         }
 
         virtual vector2 get() override
         {
-            prepare_dimension(current_dimension_);
-            return dimensions_[current_dimension_++].samples[sample_index_];
+            std::uint64_t seed{mix_bits(pixel_seed_ ^ (static_cast<std::uint64_t>(current_dimension_++) * 0x9e3779b97f4a7c15))};
+
+            std::uint32_t cell{permute(sample_index_, static_cast<std::uint32_t>(sample_count_), static_cast<std::uint32_t>(seed))};
+            std::uint64_t jitter{mix_bits(seed ^ sample_index_)};
+
+            std::uint32_t row{cell / sqrt_sample_count_};
+            std::uint32_t column{cell - row * sqrt_sample_count_};
+            return {
+                (column + to_unit(static_cast<std::uint32_t>(jitter))) * inverse_sqrt_sample_count_,
+                (row + to_unit(static_cast<std::uint32_t>(jitter >> 32))) * inverse_sqrt_sample_count_
+            };
+        }
+
+        virtual void get_batch(std::span<vector2> values) override
+        {
+            for(vector2& value : values)
+            {
+                value = get();
+            }
         }
 
         virtual void advance_dimension(int count = 1) override
@@ -60,93 +75,52 @@ namespace fc
             current_dimension_ = dimension_index;
         }
 
-    private:
+        // element i of a random permutation of [0, n) chosen by seed, a hash that is invertible on the next power of
+        // two is applied until it lands below n [Kensler 2013]
+        static std::uint32_t permute(std::uint32_t i, std::uint32_t n, std::uint32_t seed)
+        {
+            std::uint32_t w{n - 1};
+            w |= w >> 1;
+            w |= w >> 2;
+            w |= w >> 4;
+            w |= w >> 8;
+            w |= w >> 16;
+
+            do
+            {
+                i ^= seed;
+                i *= 0xe170893d;
+                i ^= seed >> 16;
+                i ^= (i & w) >> 4;
+                i ^= seed >> 8;
+                i *= 0x0929eb3f;
+                i ^= seed >> 23;
+                i ^= (i & w) >> 1;
+                i *= 1 | seed >> 27;
+                i *= 0x6935fa69;
+                i ^= (i & w) >> 11;
+                i *= 0x74dcb303;
+                i ^= (i & w) >> 2;
+                i *= 0x9e501cc3;
+                i ^= (i & w) >> 2;
+                i *= 0xc860a3df;
+                i &= w;
+                i ^= i >> 5;
+            } while(i >= n);
+
+            return (i + seed) % n;
+        }
 
+    private:
         int sample_count_{};
-        int sqrt_sample_count_{};
+        std::uint32_t sqrt_sample_count_{};
+        double inverse_sqrt_sample_count_{};
         std::uint64_t seed_{};
 
-        struct dimension
-        {
-            std::unique_ptr<vector2[]> samples{};
-            bool generated{};
-        };
-        std::vector<dimension> dimensions_{};
-
-
         vector2i current_pixel_{};
-        int sample_index_{};
+        bool pixel_seed_valid_{};
+        std::uint64_t pixel_seed_{};
+        std::uint32_t sample_index_{};
         int current_dimension_{};
-
-        pcg32 generator_{};
-        std::uint64_t generator_position_{};
-
-
-        void initialize_generator()
-        {
-            int data[]{current_pixel_.x, current_pixel_.y};
-            std::uint64_t gen_seed{XXH64(data, sizeof(data), seed_)};
-
-            generator_ = {gen_seed};
-            generator_position_ = 0;
-        }
-
-        void prepare_dimension(int dimension_index)
-        {
-            if(dimensions_.size() <= dimension_index)
-            {
-                dimensions_.resize(dimension_index + 1);
-                generate_dimension(dimension_index);
-            }
-            else
-            {
-                if(!dimensions_[dimension_index].generated)
-                    generate_dimension(dimension_index);
-            }
-        }
-
-        void generate_dimension(int dimension_index)
-        {
-            if(dimensions_[dimension_index].samples == nullptr)
-                dimensions_[dimension_index].samples.reset(new vector2[sample_count_]);
-
-
-            std::uint64_t required_position{dimension_index * std::uint64_t{3} * sample_count_};
-            if(generator_position_ != required_position)
-            {
-                if(required_position < generator_position_)
-                    generator_.backstep(generator_position_ - required_position);
-                else
-                    generator_.advance(required_position - generator_position_);
-            }
-            generator_position_ = required_position;
-
-
-            std::uniform_real_distribution<double> dist{};
-            vector2* p{dimensions_[dimension_index].samples.get()};
-
-            for(int i{}; i < sqrt_sample_count_; ++i)
-            {
-                for(int j{}; j < sqrt_sample_count_; ++j)
-                {
-                    *p = {
-                        (j + dist(generator_)) / sqrt_sample_count_,
-                        (i + dist(generator_)) / sqrt_sample_count_
-                    };
-
-                    ++p;
-                }
-            }
-
-            p = dimensions_[dimension_index].samples.get();
-            for(int i{static_cast<int>(sample_count_) - 1}; i >= 1; --i)
-            {
-                int j{static_cast<int>(generator_(i + 1))};
-                std::swap(p[i], p[j]);
-            }
-
-            generator_position_ += sample_count_ * std::uint64_t{3};
-            dimensions_[dimension_index].generated = true;
-        }
     };
 }
\ No newline at end of file
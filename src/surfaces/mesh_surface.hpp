@@ -3,7 +3,9 @@
 #include "../core/mesh.hpp"
 #include "../core/transform.hpp"
 #include "../core/distribution.hpp"
+#include "../core/light_bvh.hpp"
 #include "../core/sampling.hpp"
+#include "../core/parallel.hpp"
 
 #include <memory>
 
@@ -19,13 +21,11 @@ namespace fc
             std::uint32_t vertex_count{mesh_->get_vertex_count()};
             std::uint32_t index_count{mesh_->get_index_count()};
             primitive_count_ = index_count / 3;
+            uvs_ = mesh_->get_uvs();
+            indices_ = mesh_->get_indices();
 
-            vector3f const* positions{mesh_->get_positions()};
             positions_.resize(vertex_count);
-            for(std::uint32_t i{}; i < vertex_count; ++i)
-            {
-                positions_[i] = transform_.transform_point(positions[i]);
-            }
+            set_positions(mesh_->get_positions());
 
             vector3f const* normals{mesh_->get_normals()};
             if(normals != nullptr)
@@ -36,15 +36,26 @@ namespace fc
                     normals_[i] = transform_.transform_normal(normals[i]);
                 }
             }
+        }
 
-            uvs_ = mesh_->get_uvs();
-            indices_ = mesh_->get_indices();
+        // moves the vertices of an animated mesh, one object space position per vertex of the mesh; the shading normals
+        // stay those of the mesh and acceleration structures holding the surface need an update afterwards
+        void set_positions(vector3f const* positions)
+        {
+            parallel_for(positions_.size(), [&] (std::size_t i)
+            {
+                positions_[i] = transform_.transform_point(positions[i]);
+            });
 
+            area_ = 0.0;
+            bounds_ = {};
             for(std::uint32_t i{}; i < primitive_count_; ++i)
             {
                 area_ += get_area(i);
                 bounds_.Union(get_bounds(i));
             }
+
+            if(area_distribution_ != nullptr) prepare_for_sampling();
         }
 
         virtual std::uint32_t get_primitive_count() const override
@@ -78,66 +89,12 @@ namespace fc
         virtual std::optional<surface_raycast_result> raycast(std::uint32_t primitive, ray3 const& ray, double t_max) const override
         {
             std::optional<surface_raycast_result> result{};
-            auto [p0, p1, p2] {get_positions(primitive)};
-
-            // Translate vertices based on ray origin
-            vector3 p0t{p0 - ray.origin};
-            vector3 p1t{p1 - ray.origin};
-            vector3 p2t{p2 - ray.origin};
-
-            // Permute components of triangle vertices and ray direction
-            int kz{max_dimension(abs(ray.direction))};
-            int kx{kz + 1};
-            if(kx == 3) kx = 0;
-            int ky{kx + 1};
-            if(ky == 3) ky = 0;
-            vector3 d{permute(ray.direction, kx, ky, kz)};
-            p0t.permute(kx, ky, kz);
-            p1t.permute(kx, ky, kz);
-            p2t.permute(kx, ky, kz);
-
-            // Apply shear transformation to translated vertex positions
-            double sx{-d.x / d.z};
-            double sy{-d.y / d.z};
-            double sz{1.0 / d.z};
-
-            d.x += sx * d.z;
-            d.y += sy * d.z;
-            p0t.x += sx * p0t.z;
-            p0t.y += sy * p0t.z;
-            p1t.x += sx * p1t.z;
-            p1t.y += sy * p1t.z;
-            p2t.x += sx * p2t.z;
-            p2t.y += sy * p2t.z;
-
-            // Compute edge function coefficients e0, e1, e2
-            double e0{p1t.x * p2t.y - p1t.y * p2t.x};
-            double e1{p2t.x * p0t.y - p2t.y * p0t.x};
-            double e2{p0t.x * p1t.y - p0t.y * p1t.x};
-
-            if((e0 < 0.0 || e1 < 0.0 || e2 < 0.0) && (e0 > 0.0 || e1 > 0.0 || e2 > 0.0)) return result;
 
-            // Compute barycentric coordinates and t value for triangle intersection
-            double det{e0 + e1 + e2};
-            if(det == 0.0) return result;
-
-            p0t.z *= sz;
-            p1t.z *= sz;
-            p2t.z *= sz;
-            double t_scaled = e0 * p0t.z + e1 * p1t.z + e2 * p2t.z;
-            if(det < 0.0 && (t_scaled >= 0.0 || t_scaled < t_max * det))
-            {
-                return result;
-            }
-            else if(det > 0.0 && (t_scaled <= 0.0 || t_scaled > t_max * det))
-            {
-                return result;
-            }
-
-            double t_hit{t_scaled / det};
+            auto hit{intersect(primitive, ray, t_max)};
+            if(!hit) return result;
 
             result.emplace();
-            result->t = t_hit;
+            result->t = hit->t;
 
             return result;
         }
@@ -145,68 +102,29 @@ namespace fc
         virtual std::optional<surface_raycast_surface_point_result> raycast_surface_point(std::uint32_t primitive, ray3 const& ray, double t_max, allocator_wrapper& allocator) const override
         {
             std::optional<surface_raycast_surface_point_result> result{};
-            auto [p0, p1, p2] {get_positions(primitive)};
-
-            // Translate vertices based on ray origin
-            vector3 p0t{p0 - ray.origin};
-            vector3 p1t{p1 - ray.origin};
-            vector3 p2t{p2 - ray.origin};
-
-            // Permute components of triangle vertices and ray direction
-            int kz{max_dimension(abs(ray.direction))};
-            int kx{kz + 1};
-            if(kx == 3) kx = 0;
-            int ky{kx + 1};
-            if(ky == 3) ky = 0;
-            vector3 d{permute(ray.direction, kx, ky, kz)};
-            p0t.permute(kx, ky, kz);
-            p1t.permute(kx, ky, kz);
-            p2t.permute(kx, ky, kz);
 
-            // Apply shear transformation to translated vertex positions
-            double sx{-d.x / d.z};
-            double sy{-d.y / d.z};
-            double sz{1.0 / d.z};
+            auto hit{intersect(primitive, ray, t_max)};
+            if(!hit) return result;
 
-            d.x += sx * d.z;
-            d.y += sy * d.z;
-            p0t.x += sx * p0t.z;
-            p0t.y += sy * p0t.z;
-            p1t.x += sx * p1t.z;
-            p1t.y += sy * p1t.z;
-            p2t.x += sx * p2t.z;
-            p2t.y += sy * p2t.z;
-
-            // Compute edge function coefficients e0, e1, e2
-            double e0{p1t.x * p2t.y - p1t.y * p2t.x};
-            double e1{p2t.x * p0t.y - p2t.y * p0t.x};
-            double e2{p0t.x * p1t.y - p0t.y * p1t.x};
-
-            if((e0 < 0.0 || e1 < 0.0 || e2 < 0.0) && (e0 > 0.0 || e1 > 0.0 || e2 > 0.0)) return result;
-
-            // Compute barycentric coordinates and t value for triangle intersection
-            double det{e0 + e1 + e2};
-            if(det == 0.0) return result;
+            result.emplace();
+            result->t = hit->t;
+            result->p = create_surface_point(primitive, ray, hit->t, {hit->b0, hit->b1, hit->b2}, allocator);
 
-            p0t.z *= sz;
-            p1t.z *= sz;
-            p2t.z *= sz;
-            double t_scaled = e0 * p0t.z + e1 * p1t.z + e2 * p2t.z;
-            if(det < 0.0 && (t_scaled >= 0.0 || t_scaled < t_max * det))
-            {
-                return result;
-            }
-            else if(det > 0.0 && (t_scaled <= 0.0 || t_scaled > t_max * det))
-            {
-                return result;
-            }
+            return result;
+        }
 
-            double inv_det{1.0 / det};
-            double b0{e0 * inv_det};
-            double b1{e1 * inv_det};
-            double b2{e2 * inv_det};
-            double t_hit{t_scaled * inv_det};
+        virtual std::optional<surface_shape> get_shape(std::uint32_t primitive) const override
+        {
+            std::size_t i{static_cast<std::size_t>(primitive) * 3};
+            return surface_triangle{positions_[indices_[i]], positions_[indices_[i + 1]], positions_[indices_[i + 2]]};
+        }
 
+        virtual surface_point* create_surface_point(std::uint32_t primitive, ray3 const&, double, vector3 const& b, allocator_wrapper& allocator) const override
+        {
+            auto [p0, p1, p2] {get_positions(primitive)};
+            double b0{b.x};
+            double b1{b.y};
+            double b2{b.z};
 
             vector3 position{b0 * p0 + b1 * p1 + b2 * p2};
             vector3 dp02{p0 - p2};
@@ -217,13 +135,14 @@ namespace fc
             vector2 duv02{uv0 - uv2};
             vector2 duv12{uv1 - uv2};
 
-            det = duv02.x * duv12.y - duv02.y * duv12.x;
+            double det{duv02.x * duv12.y - duv02.y * duv12.x};
             vector3 dpdu{(duv12.y * dp02 - duv02.y * dp12) / det};
 
             surface_point* p{allocator.emplace<surface_point>()};
 
             p->set_surface(this);
             p->set_position(position);
+            p->set_position_error(math::gamma(7) * (abs(b0 * p0) + abs(b1 * p1) + abs(b2 * p2)));
             p->set_normal(normalize(cross(dp02, dp12)));
             p->set_uv(uv);
 
@@ -247,12 +166,7 @@ namespace fc
             p->set_shading_tangent(tangent);
             p->set_shading_bitangent(bitangent);
 
-
-            result.emplace();
-            result->t = t_hit;
-            result->p = p;
-
-            return result;
+            return p;
         }
 
         virtual void prepare_for_sampling() override
@@ -265,12 +179,53 @@ namespace fc
                 triangle_areas_.push_back(get_area(i));
             }
 
-            area_distribution_.reset(new distribution_1d{std::move(triangle_areas_)});
+            area_distribution_.reset(new alias_distribution_1d{triangle_areas_});
+
+            // towards a view point the triangles are picked by how much they can light it, a triangle only counts
+            // as facing it from the side of its normal
+            if(primitive_count_ > 1)
+            {
+                std::vector<light_bounds> triangle_bounds(primitive_count_);
+                parallel_for(primitive_count_, [&] (std::size_t i)
+                {
+                    auto [p0, p1, p2] {get_positions(static_cast<std::uint32_t>(i))};
+                    vector3 normal{cross(p1 - p0, p2 - p0)};
+                    double area{0.5 * length(normal)};
+
+                    light_bounds& b{triangle_bounds[i]};
+                    b.bounds = get_bounds(static_cast<std::uint32_t>(i));
+                    if(area > 0.0)
+                    {
+                        b.w = normal / (2.0 * area);
+                        b.phi = static_cast<float>(area);
+                    }
+                });
+
+                if(triangle_bvh_ == nullptr)
+                {
+                    triangle_bvh_.reset(new light_bvh{triangle_bounds});
+                }
+                else
+                {
+                    triangle_bvh_->refit(triangle_bounds);
+                }
+            }
         }
 
-        virtual std::optional<surface_sample_result> sample_p(surface_point const&, double sample_primitive, vector2 const& sample_point, allocator_wrapper& allocator) const override
+        virtual std::optional<surface_sample_result> sample_p(surface_point const& view_point, double sample_primitive, vector2 const& sample_point, allocator_wrapper& allocator) const override
         {
-            return sample_p(sample_primitive, sample_point, allocator);
+            if(triangle_bvh_ == nullptr) return sample_p(sample_primitive, sample_point, allocator);
+
+            std::optional<surface_sample_result> result{};
+
+            auto triangle{triangle_bvh_->sample(view_point.get_position(), view_point.get_normal(), sample_primitive)};
+            if(!triangle) return result;
+
+            result.emplace();
+            result->p = sample_triangle(triangle->index, sample_point, allocator);
+            result->pdf_p = triangle->pdf_index / get_area(triangle->index);
+
+            return result;
         }
 
         virtual std::optional<surface_sample_result> sample_p(double sample_primitive, vector2 const& sample_point, allocator_wrapper& allocator) const override
@@ -279,16 +234,8 @@ namespace fc
             result.emplace();
 
             auto dist_result{area_distribution_->sample_discrete(sample_primitive)};
-            auto [p0, p1, p2] {get_positions(static_cast<std::uint32_t>(dist_result.index))};
 
-            auto triangle_sample{sample_triangle_uniform(sample_point)};
-
-            surface_point* p{allocator.emplace<surface_point>()};
-            p->set_surface(this);
-            p->set_position(p0 * triangle_sample.x + p1 * triangle_sample.y + p2 * (1.0 - triangle_sample.x - triangle_sample.y));
-            p->set_normal(normalize(cross(p1 - p0, p2 - p0)));
-
-            result->p = p;
+            result->p = sample_triangle(static_cast<std::uint32_t>(dist_result.index), sample_point, allocator);
             result->pdf_p = 1.0 / area_;
 
             return result;
@@ -299,6 +246,12 @@ namespace fc
             return 1.0 / area_;
         }
 
+        virtual double pdf_p(surface_point const& view_point, surface_point const& p) const override
+        {
+            if(triangle_bvh_ == nullptr) return pdf_p(p);
+            return triangle_bvh_->pdf(view_point.get_position(), view_point.get_normal(), p.get_primitive()) / get_area(p.get_primitive());
+        }
+
     private:
         prs_transform transform_{};
         std::shared_ptr<mesh> mesh_{};
@@ -312,7 +265,114 @@ namespace fc
         double area_{};
         bounds3f bounds_{};
 
-        std::unique_ptr<distribution_1d> area_distribution_{};
+        std::unique_ptr<alias_distribution_1d> area_distribution_{};
+        std::unique_ptr<light_bvh> triangle_bvh_{};
+
+        struct triangle_hit
+        {
+            double b0;
+            double b1;
+            double b2;
+            double t;
+        };
+
+        std::optional<triangle_hit> intersect(std::uint32_t primitive, ray3 const& ray, double t_max) const
+        {
+            std::optional<triangle_hit> result{};
+            auto [p0, p1, p2] {get_positions(primitive)};
+
+            // Translate vertices based on ray origin
+            vector3 p0t{p0 - ray.origin};
+            vector3 p1t{p1 - ray.origin};
+            vector3 p2t{p2 - ray.origin};
+
+            // Permute components of triangle vertices and ray direction
+            int kz{max_dimension(abs(ray.direction))};
+            int kx{kz + 1};
+            if(kx == 3) kx = 0;
+            int ky{kx + 1};
+            if(ky == 3) ky = 0;
+            vector3 d{permute(ray.direction, kx, ky, kz)};
+            p0t.permute(kx, ky, kz);
+            p1t.permute(kx, ky, kz);
+            p2t.permute(kx, ky, kz);
+
+            // Apply shear transformation to translated vertex positions
+            double sx{-d.x / d.z};
+            double sy{-d.y / d.z};
+            double sz{1.0 / d.z};
+
+            d.x += sx * d.z;
+            d.y += sy * d.z;
+            p0t.x += sx * p0t.z;
+            p0t.y += sy * p0t.z;
+            p1t.x += sx * p1t.z;
+            p1t.y += sy * p1t.z;
+            p2t.x += sx * p2t.z;
+            p2t.y += sy * p2t.z;
+
+            // Compute edge function coefficients e0, e1, e2
+            double e0{p1t.x * p2t.y - p1t.y * p2t.x};
+            double e1{p2t.x * p0t.y - p2t.y * p0t.x};
+            double e2{p0t.x * p1t.y - p0t.y * p1t.x};
+
+            if((e0 < 0.0 || e1 < 0.0 || e2 < 0.0) && (e0 > 0.0 || e1 > 0.0 || e2 > 0.0)) return result;
+
+            // Compute barycentric coordinates and t value for triangle intersection
+            double det{e0 + e1 + e2};
+            if(det == 0.0) return result;
+
+            p0t.z *= sz;
+            p1t.z *= sz;
+            p2t.z *= sz;
+            double t_scaled = e0 * p0t.z + e1 * p1t.z + e2 * p2t.z;
+            if(det < 0.0 && (t_scaled >= 0.0 || t_scaled < t_max * det))
+            {
+                return result;
+            }
+            else if(det > 0.0 && (t_scaled <= 0.0 || t_scaled > t_max * det))
+            {
+                return result;
+            }
+
+            double inv_det{1.0 / det};
+            double t_hit{t_scaled * inv_det};
+
+            // Ensure that computed triangle t is conservatively greater than zero
+            double max_zt{max_component(abs(vector3{p0t.z, p1t.z, p2t.z}))};
+            double delta_z{math::gamma(3) * max_zt};
+
+            double max_xt{max_component(abs(vector3{p0t.x, p1t.x, p2t.x}))};
+            double max_yt{max_component(abs(vector3{p0t.y, p1t.y, p2t.y}))};
+            double delta_x{math::gamma(5) * (max_xt + max_zt)};
+            double delta_y{math::gamma(5) * (max_yt + max_zt)};
+
+            double delta_e{2.0 * (math::gamma(2) * max_xt * max_yt + delta_y * max_xt + delta_x * max_yt)};
+            double max_e{max_component(abs(vector3{e0, e1, e2}))};
+
+            double delta_t{3.0 * (math::gamma(3) * max_e * max_zt + delta_e * max_zt + delta_z * max_e) * std::abs(inv_det)};
+            if(t_hit <= delta_t) return result;
+
+            result = {e0 * inv_det, e1 * inv_det, e2 * inv_det, t_hit};
+            return result;
+        }
+
+        surface_point* sample_triangle(std::uint32_t primitive, vector2 const& sample_point, allocator_wrapper& allocator) const
+        {
+            auto [p0, p1, p2] {get_positions(primitive)};
+
+            auto triangle_sample{sample_triangle_uniform(sample_point)};
+            double b2{1.0 - triangle_sample.x - triangle_sample.y};
+
+            surface_point* p{allocator.emplace<surface_point>()};
+            p->set_surface(this);
+            p->set_primitive(primitive);
+            p->set_position(p0 * triangle_sample.x + p1 * triangle_sample.y + p2 * b2);
+            p->set_position_error(math::gamma(6) * (abs(p0 * triangle_sample.x) + abs(p1 * triangle_sample.y) + abs(p2 * b2)));
+            p->set_normal(normalize(cross(p1 - p0, p2 - p0)));
+
+            return p;
+        }
 
         std::tuple<vector3, vector3, vector3> get_positions(std::uint32_t primitive) const
         {
@@ -37,28 +37,48 @@ namespace fc
             return get_area();
         }
 
-        virtual std::optional<surface_raycast_result> raycast(std::uint32_t primitive, ray3 const& ray, double t_max) const override
+        // the hit of a rectangle in the xz plane centered at the origin, the acceleration structures call it with the
+        // shapes they keep in world space, projected onto the frame of the plane
+        static std::optional<double> raycast_plane(vector3 const& o, vector3 const& d, vector2 const& half_size, double t_max)
         {
-            std::optional<surface_raycast_result> result{};
-
-            vector3 o{transform_.inverse_transform_point(ray.origin)};
-            vector3 d{transform_.inverse_transform_direction(ray.direction)};
-
             double t_hit{-o.y / d.y};
             if(t_hit < 0.0 || t_hit > t_max || std::isinf(t_hit) || std::isnan(t_hit))
             {
-                return result;
+                return {};
             }
 
             vector3 position{o + d * t_hit};
-            vector2 half_size{size_ / 2.0};
             if(position.x < -half_size.x || position.x > half_size.x || position.z < -half_size.y || position.z > half_size.y)
+            {
+                return {};
+            }
+            return t_hit;
+        }
+
+        static std::optional<double> raycast_plane(surface_plane const& plane, ray3 const& ray, double t_max)
+        {
+            vector3 o{ray.origin - plane.center};
+            return raycast_plane(
+                {dot(o, plane.tangent), dot(o, plane.normal), dot(o, plane.bitangent)},
+                {dot(ray.direction, plane.tangent), dot(ray.direction, plane.normal), dot(ray.direction, plane.bitangent)},
+                plane.half_size, t_max);
+        }
+
+        virtual std::optional<surface_raycast_result> raycast(std::uint32_t primitive, ray3 const& ray, double t_max) const override
+        {
+            std::optional<surface_raycast_result> result{};
+
+            vector3 o{transform_.inverse_transform_point(ray.origin)};
+            vector3 d{transform_.inverse_transform_direction(ray.direction)};
+
+            std::optional<double> t_hit{raycast_plane(o, d, size_ / 2.0, t_max)};
+            if(!t_hit)
             {
                 return result;
             }
 
             result.emplace();
-            result->t = t_hit;
+            result->t = *t_hit;
 
             return result;
         }
@@ -70,22 +90,45 @@ namespace fc
             vector3 o{transform_.inverse_transform_point(ray.origin)};
             vector3 d{transform_.inverse_transform_direction(ray.direction)};
 
-            double t_hit{-o.y / d.y};
-            if(t_hit < 0.0 || t_hit > t_max || std::isinf(t_hit) || std::isnan(t_hit))
+            std::optional<double> t_hit{raycast_plane(o, d, size_ / 2.0, t_max)};
+            if(!t_hit)
             {
                 return result;
             }
 
-            vector3 position{o + d * t_hit};
+            result.emplace();
+            result->p = create_surface_point(primitive, ray, *t_hit, {}, allocator);
+            result->t = *t_hit;
+
+            return result;
+        }
+
+        virtual std::optional<surface_shape> get_shape(std::uint32_t) const override
+        {
+            return surface_plane{
+                transform_.transform_point({}),
+                transform_.transform_direction({0.0, 1.0, 0.0}),
+                transform_.transform_direction({1.0, 0.0, 0.0}),
+                transform_.transform_direction({0.0, 0.0, 1.0}),
+                size_ / 2.0
+            };
+        }
+
+        virtual surface_point* create_surface_point(std::uint32_t, ray3 const& ray, double t, vector3 const&, allocator_wrapper& allocator) const override
+        {
+            vector3 o{transform_.inverse_transform_point(ray.origin)};
+            vector3 d{transform_.inverse_transform_direction(ray.direction)};
+
+            vector3 position{o + d * t};
             vector2 half_size{size_ / 2.0};
-            if(position.x < -half_size.x || position.x > half_size.x || position.z < -half_size.y || position.z > half_size.y)
-            {
-                return result;
-            }
+
+            // exactly in the plane, only the transform adds error
+            position.y = 0.0;
 
             surface_point* p{allocator.emplace<surface_point>()};
             p->set_surface(this);
             p->set_position(transform_.transform_point(position));
+            p->set_position_error(transform_.transform_point_error(position, {}));
             p->set_normal(transform_.transform_direction({0.0, 1.0, 0.0}));
 
             vector2 uv{
@@ -98,11 +141,7 @@ namespace fc
             p->set_shading_tangent(transform_.transform_direction({1.0, 0.0, 0.0}));
             p->set_shading_bitangent(transform_.transform_direction({0.0, 0.0, 1.0}));
 
-            result.emplace();
-            result->p = p;
-            result->t = t_hit;
-
-            return result;
+            return p;
         }
 
         virtual void prepare_for_sampling() override
@@ -123,6 +162,7 @@ namespace fc
             surface_point* p{allocator.emplace<surface_point>()};
             p->set_surface(this);
             p->set_position(transform_.transform_point({tu.x, 0.0, tu.y}));
+            p->set_position_error(transform_.transform_point_error({tu.x, 0.0, tu.y}, {}));
             p->set_normal(transform_.transform_direction({0.0, 1.0, 0.0}));
 
             result->p = p;
@@ -141,4 +181,4 @@ namespace fc
         pr_transform transform_{};
         vector2 size_{};
     };
-}
+}
\ No newline at end of file
@@ -38,25 +38,22 @@ namespace fc
             return get_area();
         }
 
-        virtual std::optional<surface_raycast_result> raycast(std::uint32_t primitive, ray3 const& ray, double t_max) const override
+        // the first hit in front of o of a sphere centered at the origin, the acceleration structures call it with the
+        // shapes they keep in world space
+        static std::optional<double> raycast_sphere(vector3 const& o, vector3 const& d, double radius, double t_max)
         {
-            std::optional<surface_raycast_result> result{};
-
-            vector3 o{transform_.inverse_transform_point(ray.origin)};
-            vector3 d{transform_.inverse_transform_direction(ray.direction)};
-
             double a{dot(d, d)};
             double b{2.0 * dot(o, d)};
-            double c{dot(o, o) - radius_ * radius_};
+            double c{dot(o, o) - radius * radius};
             double discriminant{b * b - 4.0 * a * c};
 
             if(discriminant < 0.0)
             {
-                return result;
+                return {};
             }
 
-            double sqrtDiscriminant{std::sqrt(discriminant)};
-            double q{b < 0.0 ? -0.5 * (b - sqrtDiscriminant) : -0.5 * (b + sqrtDiscriminant)};
+            double sqrt_discriminant{std::sqrt(discriminant)};
+            double q{b < 0.0 ? -0.5 * (b - sqrt_discriminant) : -0.5 * (b + sqrt_discriminant)};
             double t0{q / a};
             double t1{c / q};
 
@@ -65,19 +62,34 @@ namespace fc
                 std::swap(t0, t1);
             }
 
-            double t_hit = t0;
-            if(t_hit < 0.0)
+            double t_hit{t0 < 0.0 ? t1 : t0};
+            if(t_hit < 0.0 || t_hit > t_max)
             {
-                t_hit = t1;
+                return {};
             }
+            return t_hit;
+        }
 
-            if(t_hit < 0.0 || t_hit > t_max)
+        static std::optional<double> raycast_sphere(surface_sphere const& sphere, ray3 const& ray, double t_max)
+        {
+            return raycast_sphere(ray.origin - sphere.center, ray.direction, sphere.radius, t_max);
+        }
+
+        virtual std::optional<surface_raycast_result> raycast(std::uint32_t primitive, ray3 const& ray, double t_max) const override
+        {
+            std::optional<surface_raycast_result> result{};
+
+            vector3 o{transform_.inverse_transform_point(ray.origin)};
+            vector3 d{transform_.inverse_transform_direction(ray.direction)};
+
+            std::optional<double> t_hit{raycast_sphere(o, d, radius_, t_max)};
+            if(!t_hit)
             {
                 return result;
             }
 
             result.emplace();
-            result->t = t_hit;
+            result->t = *t_hit;
 
             return result;
         }
@@ -89,41 +101,38 @@ namespace fc
             vector3 o{transform_.inverse_transform_point(ray.origin)};
             vector3 d{transform_.inverse_transform_direction(ray.direction)};
 
-            double a{dot(d, d)};
-            double b{2.0 * dot(o, d)};
-            double c{dot(o, o) - radius_ * radius_};
-            double discriminant{b * b - 4.0 * a * c};
-
-            if(discriminant < 0.0)
+            std::optional<double> t_hit{raycast_sphere(o, d, radius_, t_max)};
+            if(!t_hit)
             {
                 return result;
             }
 
-            double sqrtDiscriminant{std::sqrt(discriminant)};
-            double q{b < 0.0 ? -0.5 * (b - sqrtDiscriminant) : -0.5 * (b + sqrtDiscriminant)};
-            double t0{q / a};
-            double t1{c / q};
+            result.emplace();
+            result->p = create_surface_point(primitive, ray, *t_hit, {}, allocator);
+            result->t = *t_hit;
 
-            if(t0 > t1)
-            {
-                std::swap(t0, t1);
-            }
+            return result;
+        }
 
-            double t_hit = t0;
-            if(t_hit < 0.0)
-            {
-                t_hit = t1;
-            }
+        virtual std::optional<surface_shape> get_shape(std::uint32_t) const override
+        {
+            return surface_sphere{transform_.transform_point({}), radius_};
+        }
 
-            if(t_hit < 0.0 || t_hit > t_max)
-            {
-                return result;
-            }
+        virtual surface_point* create_surface_point(std::uint32_t, ray3 const& ray, double t, vector3 const&, allocator_wrapper& allocator) const override
+        {
+            vector3 o{transform_.inverse_transform_point(ray.origin)};
+            vector3 d{transform_.inverse_transform_direction(ray.direction)};
+
+            // project the hit back onto the sphere, what is left of the error is bounded by the projection
+            vector3 position{o + d * t};
+            position *= radius_ / length(position);
+            vector3 position_error{math::gamma(5) * abs(position)};
 
-            vector3 position{o + d * t_hit};
             surface_point* p{allocator.emplace<surface_point>()};
             p->set_surface(this);
             p->set_position(transform_.transform_point(position));
+            p->set_position_error(transform_.transform_point_error(position, position_error));
             p->set_normal(transform_.transform_direction(normalize(position)));
 
 
@@ -139,11 +148,7 @@ namespace fc
             p->set_shading_tangent(tangent);
             p->set_shading_bitangent(bitangent);
 
-            result.emplace();
-            result->p = p;
-            result->t = t_hit;
-
-            return result;
+            return p;
         }
 
         virtual void prepare_for_sampling() override
@@ -160,10 +165,13 @@ namespace fc
             result.emplace();
 
             vector3 normal{sample_sphere_uniform(sample_point)};
+            vector3 position{normal * radius_};
+            vector3 position_error{math::gamma(5) * abs(position)};
 
             surface_point* p{allocator.emplace<surface_point>()};
             p->set_surface(this);
-            p->set_position(transform_.transform_point(normal * radius_));
+            p->set_position(transform_.transform_point(position));
+            p->set_position_error(transform_.transform_point_error(position, position_error));
             p->set_normal(transform_.transform_direction(normal));
 
             result->p = p;
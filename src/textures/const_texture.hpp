@@ -22,6 +22,11 @@ namespace fc
             return width * height * value_;
         }
 
+        virtual std::optional<vector3> get_constant() const override
+        {
+            return value_;
+        }
+
     private:
         vector3 value_{};
     };
@@ -38,6 +43,11 @@ namespace fc
             return value_;
         }
 
+        virtual std::optional<vector2> get_constant() const override
+        {
+            return value_;
+        }
+
     private:
         vector2 value_{};
     };
@@ -61,6 +71,11 @@ namespace fc
             return width * height * value_;
         }
 
+        virtual std::optional<double> get_constant() const override
+        {
+            return value_;
+        }
+
     private:
         double value_{};
     };
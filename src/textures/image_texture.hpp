@@ -3,6 +3,10 @@
 #include "../core/image.hpp"
 
 #include <memory>
+#include <vector>
+
+#define XXH_INLINE_ALL
+#include "../lib/xxhash.h"
 
 namespace fc
 {
@@ -76,6 +80,36 @@ namespace fc
             return value;
         }
 
+        // the pixels are hashed in row-major order, so the hash does not depend on the layout of the image
+        virtual std::optional<std::uint64_t> get_hash() const override
+        {
+            vector2i resolution{image_->get_resolution()};
+            int parameters[]{resolution.x, resolution.y, static_cast<int>(reconstruction_filter_), integral_sample_count_};
+            std::uint64_t hash{XXH64(parameters, sizeof(parameters), 0)};
+
+            std::vector<vector3> row(static_cast<std::size_t>(resolution.x));
+            for(int i{}; i < resolution.y; ++i)
+            {
+                for(int j{}; j < resolution.x; ++j)
+                {
+                    row[j] = image_->rgb({j, i});
+                }
+                hash = XXH64(row.data(), row.size() * sizeof(vector3), hash);
+            }
+
+            return hash;
+        }
+
+        std::shared_ptr<image> const& get_image() const
+        {
+            return image_;
+        }
+
+        reconstruction_filter get_reconstruction_filter() const
+        {
+            return reconstruction_filter_;
+        }
+
     private:
         std::shared_ptr<image> image_{};
         reconstruction_filter reconstruction_filter_{};
@@ -185,6 +219,16 @@ namespace fc
             return value;
         }
 
+        std::shared_ptr<image> const& get_image() const
+        {
+            return image_;
+        }
+
+        reconstruction_filter get_reconstruction_filter() const
+        {
+            return reconstruction_filter_;
+        }
+
     private:
         std::shared_ptr<image> image_{};
         reconstruction_filter reconstruction_filter_{};
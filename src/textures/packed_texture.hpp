@@ -0,0 +1,346 @@
+#pragma once
+#include "image_texture.hpp"
+#include "../images/r8_image.hpp"
+#include "../images/rgb8_image.hpp"
+#include "../images/srgb8_image.hpp"
+#include "../core/color.hpp"
+#include "../core/kernels.hpp"
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace fc
+{
+    // the 8 bit channels of several images of the same resolution and layout interleaved into one texel array, so a
+    // single fetch computes the filter weights once and returns every channel; the texels keep the bytes and the
+    // pixel layout of the images, tiles included, and are decoded through a table per channel
+    class packed_texture_2d
+    {
+    public:
+        static constexpr int max_channel_count{16};
+
+        packed_texture_2d(pixel_indexer const& indexer, reconstruction_filter reconstruction_filter, int integral_sample_count,
+            std::vector<std::uint8_t> texels, std::vector<std::array<float, 256>> decode_tables, std::vector<int> source_channels)
+            : indexer_{indexer}, channel_count_{static_cast<int>(decode_tables.size())}
+            , reconstruction_filter_{reconstruction_filter}, integral_sample_count_{integral_sample_count}
+            , texels_{std::move(texels)}, decode_tables_{std::move(decode_tables)}, source_channels_{std::move(source_channels)}
+            , bilinear_{get_kernels().bilinear}
+        { }
+
+        int get_channel_count() const
+        {
+            return channel_count_;
+        }
+
+        // the first channel of the index-th image that was packed
+        int get_source_channel(int index) const
+        {
+            return source_channels_[index];
+        }
+
+        void evaluate(vector2 const& uv, double* values) const
+        {
+            evaluate(uv, 0, channel_count_, values);
+        }
+
+        void evaluate(vector2 const& uv, int first_channel, int count, double* values) const
+        {
+            switch(reconstruction_filter_)
+            {
+            case reconstruction_filter::bilinear:
+                bilinear(uv, first_channel, count, values);
+                break;
+            case reconstruction_filter::box:
+            default:
+                box(uv, first_channel, count, values);
+                break;
+            }
+        }
+
+        // the same integration as the image textures, over the channels [first_channel, first_channel + count)
+        void integrate(vector2 const& a, vector2 const& b, int first_channel, int count, double* values) const
+        {
+            vector2i resolution{indexer_.get_resolution()};
+            vector2 as{a.x * resolution.x, a.y * resolution.y};
+            vector2 bs{b.x * resolution.x, b.y * resolution.y};
+
+            vector2i p0{static_cast<int>(std::floor(as.x)), static_cast<int>(std::floor(as.y))};
+            vector2i p1{static_cast<int>(std::ceil(bs.x)), static_cast<int>(std::ceil(bs.y))};
+
+            std::fill(values, values + count, 0.0);
+            for(int i{p0.y}; i < p1.y; ++i)
+            {
+                for(int j{p0.x}; j < p1.x; ++j)
+                {
+                    vector2 af{std::max(a.x, static_cast<double>(j) / resolution.x), std::max(a.y, static_cast<double>(i) / resolution.y)};
+                    vector2 bf{std::min(b.x, static_cast<double>(j + 1) / resolution.x), std::min(b.y, static_cast<double>(i + 1) / resolution.y)};
+
+                    double delta_u{(bf.x - af.x) / static_cast<double>(integral_sample_count_)};
+                    double delta_v{(bf.y - af.y) / static_cast<double>(integral_sample_count_)};
+                    double area{delta_u * delta_v};
+
+                    for(int k{}; k < integral_sample_count_; ++k)
+                    {
+                        double v{af.y + (k + 0.5) * delta_v};
+                        for(int l{}; l < integral_sample_count_; ++l)
+                        {
+                            double u{af.x + (l + 0.5) * delta_u};
+                            double sample[max_channel_count]{};
+                            evaluate({u, v}, first_channel, count, sample);
+                            for(int c{}; c < count; ++c)
+                            {
+                                values[c] += sample[c] * area;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        pixel_indexer indexer_{};
+        int channel_count_{};
+        reconstruction_filter reconstruction_filter_{};
+        int integral_sample_count_{};
+        std::vector<std::uint8_t> texels_{};
+        std::vector<std::array<float, 256>> decode_tables_{};
+        std::vector<int> source_channels_{};
+        void (*bilinear_)(float const* t00, float const* t10, float const* t01, float const* t11, double wx, double wy, int count, double* values){};
+
+        std::uint8_t const* get_texel(int x, int y) const
+        {
+            return texels_.data() + indexer_.get_pixel_index({x, y}) * static_cast<std::size_t>(channel_count_);
+        }
+
+        void decode(std::uint8_t const* texel, int first_channel, int count, float* values) const
+        {
+            for(int i{}; i < count; ++i)
+            {
+                values[i] = decode_tables_[first_channel + i][texel[first_channel + i]];
+            }
+        }
+
+        void box(vector2 const& uv, int first_channel, int count, double* values) const
+        {
+            vector2i resolution{indexer_.get_resolution()};
+            std::uint8_t const* texel{get_texel(
+                std::min(static_cast<int>(uv.x * resolution.x), resolution.x - 1),
+                std::min(static_cast<int>(uv.y * resolution.y), resolution.y - 1)
+            )};
+
+            for(int i{}; i < count; ++i)
+            {
+                values[i] = decode_tables_[first_channel + i][texel[first_channel + i]];
+            }
+        }
+
+        void bilinear(vector2 const& uv, int first_channel, int count, double* values) const
+        {
+            vector2i resolution{indexer_.get_resolution()};
+            vector2 ab{uv.x * resolution.x - 0.5, uv.y * resolution.y - 0.5};
+
+            int x0{static_cast<int>(std::floor(ab.x))};
+            int x1{x0 + 1};
+            int y0{static_cast<int>(std::floor(ab.y))};
+            int y1{y0 + 1};
+
+            int px0 = std::clamp(x0, 0, resolution.x - 1);
+            int px1 = std::clamp(x1, 0, resolution.x - 1);
+            int py0 = std::clamp(y0, 0, resolution.y - 1);
+            int py1 = std::clamp(y1, 0, resolution.y - 1);
+
+            float t00[max_channel_count];
+            float t10[max_channel_count];
+            float t01[max_channel_count];
+            float t11[max_channel_count];
+            decode(get_texel(px0, py0), first_channel, count, t00);
+            decode(get_texel(px1, py0), first_channel, count, t10);
+            decode(get_texel(px0, py1), first_channel, count, t01);
+            decode(get_texel(px1, py1), first_channel, count, t11);
+
+            double wx{ab.x - x0};
+            double wy{ab.y - y0};
+
+            bilinear_(t00, t10, t01, t11, wx, wy, count, values);
+        }
+    };
+
+    // the channels of one image in a packed texture, materials that find several of them on the same packed texture
+    // fetch them all at once
+    class packed_texture_2d_rgb : public texture_2d_rgb
+    {
+    public:
+        packed_texture_2d_rgb(std::shared_ptr<packed_texture_2d> packed_texture, int channel)
+            : packed_texture_{std::move(packed_texture)}, channel_{channel}
+        { }
+
+        virtual vector3 evaluate(vector2 const& uv) const override
+        {
+            double values[3]{};
+            packed_texture_->evaluate(uv, channel_, 3, values);
+            return {values[0], values[1], values[2]};
+        }
+
+        virtual vector3 integrate(vector2 const& a, vector2 const& b) const override
+        {
+            double values[3]{};
+            packed_texture_->integrate(a, b, channel_, 3, values);
+            return {values[0], values[1], values[2]};
+        }
+
+        std::shared_ptr<packed_texture_2d> const& get_packed_texture() const
+        {
+            return packed_texture_;
+        }
+
+        int get_channel() const
+        {
+            return channel_;
+        }
+
+    private:
+        std::shared_ptr<packed_texture_2d> packed_texture_{};
+        int channel_{};
+    };
+
+    class packed_texture_2d_r : public texture_2d_r
+    {
+    public:
+        packed_texture_2d_r(std::shared_ptr<packed_texture_2d> packed_texture, int channel)
+            : packed_texture_{std::move(packed_texture)}, channel_{channel}
+        { }
+
+        virtual double evaluate(vector2 const& uv) const override
+        {
+            double value{};
+            packed_texture_->evaluate(uv, channel_, 1, &value);
+            return value;
+        }
+
+        virtual double integrate(vector2 const& a, vector2 const& b) const override
+        {
+            double value{};
+            packed_texture_->integrate(a, b, channel_, 1, &value);
+            return value;
+        }
+
+        std::shared_ptr<packed_texture_2d> const& get_packed_texture() const
+        {
+            return packed_texture_;
+        }
+
+        int get_channel() const
+        {
+            return channel_;
+        }
+
+    private:
+        std::shared_ptr<packed_texture_2d> packed_texture_{};
+        int channel_{};
+    };
+
+    // collects 8 bit images of the same resolution and layout; add returns the first channel of the image in the
+    // packed texture, or -1 for images that cannot be packed with the ones before; the images are read by build, the
+    // packed texture does not need them afterwards
+    class packed_texture_2d_builder
+    {
+    public:
+        int add(image const& image)
+        {
+            if(auto r8{dynamic_cast<r8_image const*>(&image)})
+            {
+                static_assert(sizeof(r8_pixel) == 1);
+                return add(r8->get_indexer(), r8->get_pixels().data(), {get_linear_table()});
+            }
+            if(auto rgb8{dynamic_cast<rgb8_image const*>(&image)})
+            {
+                static_assert(sizeof(rgb8_pixel) == 3);
+                return add(rgb8->get_indexer(), rgb8->get_pixels().data(), {get_linear_table(), get_linear_table(), get_linear_table()});
+            }
+            if(auto srgb8{dynamic_cast<srgb8_image const*>(&image)})
+            {
+                static_assert(sizeof(srgb8_pixel) == 3);
+                return add(srgb8->get_indexer(), srgb8->get_pixels().data(), {get_srgb_table(), get_srgb_table(), get_srgb_table()});
+            }
+            return -1;
+        }
+
+        // copies the bytes of every stored pixel, so tiles and their padding keep their place
+        std::shared_ptr<packed_texture_2d> build(reconstruction_filter reconstruction_filter, int integral_sample_count) const
+        {
+            if(inputs_.empty()) return nullptr;
+
+            std::size_t pixel_count{indexer_.get_storage_size()};
+            std::size_t channel_count{decode_tables_.size()};
+
+            std::vector<std::uint8_t> texels(pixel_count * channel_count);
+            std::vector<int> source_channels{};
+            int channel{};
+            for(input const& input : inputs_)
+            {
+                for(std::size_t i{}; i < pixel_count; ++i)
+                {
+                    std::memcpy(texels.data() + i * channel_count + channel, input.pixels + i * input.channel_count, input.channel_count);
+                }
+                source_channels.push_back(channel);
+                channel += input.channel_count;
+            }
+
+            return std::make_shared<packed_texture_2d>(indexer_, reconstruction_filter, integral_sample_count, std::move(texels), decode_tables_, std::move(source_channels));
+        }
+
+    private:
+        struct input
+        {
+            std::uint8_t const* pixels;
+            int channel_count;
+        };
+
+        std::vector<input> inputs_{};
+        std::vector<std::array<float, 256>> decode_tables_{};
+        pixel_indexer indexer_{};
+
+        template <typename T>
+        int add(pixel_indexer const& indexer, T const* pixels, std::vector<std::array<float, 256>> const& decode_tables)
+        {
+            if(inputs_.empty())
+            {
+                indexer_ = indexer;
+            }
+            else if(!(indexer == indexer_))
+            {
+                return -1;
+            }
+
+            if(decode_tables_.size() + decode_tables.size() > packed_texture_2d::max_channel_count) return -1;
+
+            int channel{static_cast<int>(decode_tables_.size())};
+            inputs_.push_back({reinterpret_cast<std::uint8_t const*>(pixels), static_cast<int>(decode_tables.size())});
+            decode_tables_.insert(decode_tables_.end(), decode_tables.begin(), decode_tables.end());
+
+            return channel;
+        }
+
+        static std::array<float, 256> get_linear_table()
+        {
+            std::array<float, 256> table{};
+            for(int i{}; i < 256; ++i)
+            {
+                table[i] = static_cast<float>(i / 255.0);
+            }
+            return table;
+        }
+
+        static std::array<float, 256> get_srgb_table()
+        {
+            std::array<float, 256> table{};
+            for(int i{}; i < 256; ++i)
+            {
+                table[i] = static_cast<float>(srgb_to_rgb(static_cast<std::uint8_t>(i)));
+            }
+            return table;
+        }
+    };
+}
\ No newline at end of file